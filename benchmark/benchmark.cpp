@@ -1,8 +1,31 @@
 #include "benchmark/benchmark.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
 #include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "rc_ptr/offset_rc_ptr.hpp"
+#include "rc_ptr/rc_buffer.hpp"
+#include "rc_ptr/rc_buffer_chain.hpp"
+#include "rc_ptr/rc_graph.hpp"
+#include "rc_ptr/rc_observer_list.hpp"
+#include "rc_ptr/rc_persistent_map.hpp"
+#include "rc_ptr/rc_persistent_vector.hpp"
 #include "rc_ptr/rc_ptr.hpp"
+#include "rc_ptr/rc_vector.hpp"
+
+#if __has_include(<sys/mman.h>)
+#include "rc_ptr/rc_mmap.hpp"
+#endif
 
 static void shared_ptr_copy(benchmark::State& state)
 {
@@ -26,6 +49,17 @@ static void rc_ptr_copy(benchmark::State& state)
 }
 BENCHMARK(rc_ptr_copy);
 
+static void rc_ptr_copy_immortal(benchmark::State& state)
+{
+    static const auto ptr = memory::make_immortal_rc<int>(0);
+    for (auto _ : state)
+    {
+        auto copy = ptr;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(rc_ptr_copy_immortal);
+
 static void raw_ptr_copy(benchmark::State& state)
 {
     int x = 0;
@@ -36,3 +70,844 @@ static void raw_ptr_copy(benchmark::State& state)
     }
 }
 BENCHMARK(raw_ptr_copy);
+
+static void rc_ptr_reset_make_rc(benchmark::State& state)
+{
+    auto ptr = memory::make_rc<int>(0);
+    for (auto _ : state)
+    {
+        ptr.reset();
+        ptr = memory::make_rc<int>(1);
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+BENCHMARK(rc_ptr_reset_make_rc);
+
+static void rc_ptr_emplace(benchmark::State& state)
+{
+    auto ptr = memory::make_rc<int>(0);
+    for (auto _ : state)
+    {
+        ptr.emplace(1);
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+BENCHMARK(rc_ptr_emplace);
+
+static void rc_ptr_make_rc_loop(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        std::vector<memory::rc_ptr<std::size_t>> records;
+        records.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            records.push_back(memory::make_rc<std::size_t>(i));
+        }
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_make_rc_loop)->Arg(1 << 16);
+
+static void rc_ptr_make_rc_n(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        auto records =
+            memory::make_rc_n<std::size_t>(count,
+                                           [](std::size_t i) { return i; });
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_make_rc_n)->Arg(1 << 16);
+
+template<typename Vector>
+static void rc_ptr_vector_growth(benchmark::State& state)
+{
+    const auto count  = static_cast<std::size_t>(state.range(0));
+    auto       shared = memory::make_rc<std::size_t>(std::size_t{ 0 });
+    for (auto _ : state)
+    {
+        Vector ptrs;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ptrs.push_back(shared);
+        }
+        benchmark::DoNotOptimize(ptrs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(rc_ptr_vector_growth,
+                   std::vector<memory::rc_ptr<std::size_t>>)
+    ->Arg(1 << 16);
+BENCHMARK_TEMPLATE(rc_ptr_vector_growth,
+                   memory::rc_vector<memory::rc_ptr<std::size_t>>)
+    ->Arg(1 << 16);
+
+template<typename Vector>
+static void rc_ptr_vector_insert_front(benchmark::State& state)
+{
+    const auto count  = static_cast<std::size_t>(state.range(0));
+    auto       shared = memory::make_rc<std::size_t>(std::size_t{ 0 });
+    Vector     ptrs;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        ptrs.push_back(shared);
+    }
+    for (auto _ : state)
+    {
+        ptrs.insert(ptrs.begin(), shared);
+        ptrs.erase(ptrs.begin());
+    }
+}
+BENCHMARK_TEMPLATE(rc_ptr_vector_insert_front,
+                   std::vector<memory::rc_ptr<std::size_t>>)
+    ->Arg(1 << 12);
+BENCHMARK_TEMPLATE(rc_ptr_vector_insert_front,
+                   memory::rc_vector<memory::rc_ptr<std::size_t>>)
+    ->Arg(1 << 12);
+
+static void rc_ptr_fill_copy(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto       ptr   = memory::make_rc<std::size_t>(std::size_t{ 0 });
+
+    std::vector<memory::rc_ptr<std::size_t>> ptrs(count);
+    for (auto _ : state)
+    {
+        std::fill(ptrs.begin(), ptrs.end(), ptr);
+        benchmark::DoNotOptimize(ptrs.data());
+        state.PauseTiming();
+        std::fill(ptrs.begin(), ptrs.end(), nullptr);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_fill_copy)->Arg(1 << 16);
+
+static void rc_ptr_fill_share_n(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto       ptr   = memory::make_rc<std::size_t>(std::size_t{ 0 });
+
+    std::vector<memory::rc_ptr<std::size_t>> ptrs(count);
+    for (auto _ : state)
+    {
+        ptr.share_n(ptrs.begin(), count);
+        benchmark::DoNotOptimize(ptrs.data());
+        state.PauseTiming();
+        std::fill(ptrs.begin(), ptrs.end(), nullptr);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_fill_share_n)->Arg(1 << 16);
+
+static void rc_ptr_release_reset(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto       ptr   = memory::make_rc<std::size_t>(std::size_t{ 0 });
+
+    std::vector<memory::rc_ptr<std::size_t>> ptrs(count);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        ptr.share_n(ptrs.begin(), count);
+        state.ResumeTiming();
+        for (auto& p : ptrs)
+        {
+            p.reset();
+        }
+        benchmark::DoNotOptimize(ptrs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_release_reset)->Arg(1 << 16);
+
+static void rc_ptr_release_range(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto       ptr   = memory::make_rc<std::size_t>(std::size_t{ 0 });
+
+    std::vector<memory::rc_ptr<std::size_t>> ptrs(count);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        ptr.share_n(ptrs.begin(), count);
+        state.ResumeTiming();
+        memory::rc_release_range(ptrs.begin(), ptrs.end());
+        benchmark::DoNotOptimize(ptrs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_release_range)->Arg(1 << 16);
+
+// Pointers to distinct objects in random order, so that the control blocks
+// are cold when the pointers are destroyed.
+static std::vector<memory::rc_ptr<std::size_t>>
+    cold_pointers(std::size_t count)
+{
+    std::vector<memory::rc_ptr<std::size_t>> ptrs;
+    ptrs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        ptrs.push_back(memory::make_rc<std::size_t>(i));
+    }
+    std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{ 42 });
+    return ptrs;
+}
+
+static void rc_ptr_vector_clear(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto ptrs = cold_pointers(count);
+        state.ResumeTiming();
+        ptrs.clear();
+        benchmark::DoNotOptimize(ptrs.data());
+    }
+    state.counters["time_per_element"] = benchmark::Counter(
+        static_cast<double>(count),
+        benchmark::Counter::kIsIterationInvariantRate |
+            benchmark::Counter::kInvert);
+}
+BENCHMARK(rc_ptr_vector_clear)
+    ->Arg(1 << 22)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+static void rc_ptr_rc_clear(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto ptrs = cold_pointers(count);
+        state.ResumeTiming();
+        memory::rc_clear(ptrs);
+        benchmark::DoNotOptimize(ptrs.data());
+    }
+    state.counters["time_per_element"] = benchmark::Counter(
+        static_cast<double>(count),
+        benchmark::Counter::kIsIterationInvariantRate |
+            benchmark::Counter::kInvert);
+}
+BENCHMARK(rc_ptr_rc_clear)
+    ->Arg(1 << 22)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+template<typename Set>
+static void rc_ptr_owner_lookup(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto       ptrs  = cold_pointers(count);
+
+    Set set{ ptrs.begin(), ptrs.end() };
+    std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{ 7 });
+    for (auto _ : state)
+    {
+        std::size_t found = 0;
+        for (const auto& ptr : ptrs)
+        {
+            found += set.count(ptr);
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(rc_ptr_owner_lookup,
+                   std::set<memory::rc_ptr<std::size_t>,
+                            memory::owner_less<memory::rc_ptr<std::size_t>>>)
+    ->Arg(1 << 16);
+BENCHMARK_TEMPLATE(rc_ptr_owner_lookup,
+                   std::unordered_set<memory::rc_ptr<std::size_t>,
+                                      memory::owner_hash,
+                                      memory::owner_equal>)
+    ->Arg(1 << 16);
+
+static void rc_ptr_publish_lock(benchmark::State& state)
+{
+    const auto count       = static_cast<std::size_t>(state.range(0));
+    auto       subscribers = cold_pointers(count);
+
+    std::vector<memory::weak_rc_ptr<std::size_t>> list{ subscribers.begin(),
+                                                        subscribers.end() };
+    for (auto _ : state)
+    {
+        for (const auto& entry : list)
+        {
+            if (auto subscriber = entry.lock())
+            {
+                ++*subscriber;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_publish_lock)->Arg(1 << 16);
+
+static void rc_ptr_publish_observer_list(benchmark::State& state)
+{
+    const auto count       = static_cast<std::size_t>(state.range(0));
+    auto       subscribers = cold_pointers(count);
+
+    memory::rc_observer_list<std::size_t> list;
+    for (const auto& subscriber : subscribers)
+    {
+        list.subscribe(subscriber);
+    }
+
+    for (auto _ : state)
+    {
+        list.for_each([](std::size_t& subscriber) { ++subscriber; });
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_publish_observer_list)->Arg(1 << 16);
+
+static void rc_ptr_versioned_vector_copy(benchmark::State& state)
+{
+    const auto       count = static_cast<std::size_t>(state.range(0));
+    std::vector<int> current(count);
+    std::size_t      index = 0;
+
+    for (auto _ : state)
+    {
+        auto next   = current;
+        next[index] = 1;
+        current     = std::move(next);
+        index       = (index + 4099) % count;
+    }
+    benchmark::DoNotOptimize(current.data());
+}
+BENCHMARK(rc_ptr_versioned_vector_copy)->Range(1 << 10, 1 << 20);
+
+static void rc_ptr_versioned_persistent_vector(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+
+    memory::rc_transient_vector<int> transient;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        transient.push_back(0);
+    }
+
+    auto        current = std::move(transient).persistent();
+    std::size_t index   = 0;
+
+    for (auto _ : state)
+    {
+        auto next = current.set(index, 1);
+        current   = std::move(next);
+        index     = (index + 4099) % count;
+    }
+    benchmark::DoNotOptimize(current.size());
+}
+BENCHMARK(rc_ptr_versioned_persistent_vector)->Range(1 << 10, 1 << 20);
+
+static void rc_ptr_persistent_vector_build(benchmark::State& state)
+{
+    const auto count = static_cast<int>(state.range(0));
+
+    for (auto _ : state)
+    {
+        memory::rc_transient_vector<int> transient;
+        for (int i = 0; i != count; ++i)
+        {
+            transient.push_back(i);
+        }
+        benchmark::DoNotOptimize(transient.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_persistent_vector_build)->Arg(1 << 16);
+
+static void rc_ptr_snapshot_unordered_map(benchmark::State& state)
+{
+    const auto count = static_cast<int>(state.range(0));
+
+    std::unordered_map<int, int> current;
+    for (int i = 0; i != count; ++i)
+    {
+        current[i] = i;
+    }
+
+    int key = 0;
+    for (auto _ : state)
+    {
+        auto snapshot = current;
+        current[key]  = -key;
+        key           = (key + 4099) % count;
+        benchmark::DoNotOptimize(snapshot.size());
+    }
+}
+BENCHMARK(rc_ptr_snapshot_unordered_map)->Range(1 << 10, 1 << 18);
+
+static void rc_ptr_snapshot_persistent_map(benchmark::State& state)
+{
+    const auto count = static_cast<int>(state.range(0));
+
+    memory::rc_transient_map<int, int> transient;
+    for (int i = 0; i != count; ++i)
+    {
+        transient.set(i, i);
+    }
+
+    auto current = std::move(transient).persistent();
+    int  key     = 0;
+    for (auto _ : state)
+    {
+        auto snapshot = current;
+        current       = current.set(key, -key);
+        key           = (key + 4099) % count;
+        benchmark::DoNotOptimize(snapshot.size());
+    }
+}
+BENCHMARK(rc_ptr_snapshot_persistent_map)->Range(1 << 10, 1 << 18);
+
+template<typename Map>
+static void rc_ptr_map_lookup(benchmark::State& state)
+{
+    const auto count = static_cast<int>(state.range(0));
+
+    std::vector<std::pair<int, int>> entries;
+    for (int i = 0; i != count; ++i)
+    {
+        entries.emplace_back(i, i);
+    }
+
+    const Map map(entries.begin(), entries.end());
+    std::shuffle(entries.begin(), entries.end(), std::mt19937{ 7 });
+
+    for (auto _ : state)
+    {
+        std::size_t found = 0;
+        for (const auto& entry : entries)
+        {
+            found += map.find(entry.first) != map.end();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(rc_ptr_map_lookup, std::unordered_map<int, int>)
+    ->Arg(1 << 16);
+
+static void rc_ptr_persistent_map_lookup(benchmark::State& state)
+{
+    const auto count = static_cast<int>(state.range(0));
+
+    std::vector<std::pair<int, int>> entries;
+    for (int i = 0; i != count; ++i)
+    {
+        entries.emplace_back(i, i);
+    }
+
+    const auto map = memory::rc_persistent_map<int, int>::from_sorted(
+        entries.begin(),
+        entries.end());
+    std::shuffle(entries.begin(), entries.end(), std::mt19937{ 7 });
+
+    for (auto _ : state)
+    {
+        std::size_t found = 0;
+        for (const auto& entry : entries)
+        {
+            found += map.find(entry.first) != nullptr;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(rc_ptr_persistent_map_lookup)->Arg(1 << 16);
+
+static void rc_ptr_split_vector_copy(benchmark::State& state)
+{
+    const auto             record = static_cast<std::size_t>(state.range(0));
+    std::vector<std::byte> frame(1 << 16);
+
+    for (auto _ : state)
+    {
+        std::vector<std::vector<std::byte>> records;
+        for (auto it = frame.begin(); it != frame.end(); it += record)
+        {
+            records.emplace_back(it, it + record);
+        }
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (1 << 16));
+}
+BENCHMARK(rc_ptr_split_vector_copy)->Arg(256)->Arg(4096);
+
+static void rc_ptr_split_rc_buffer(benchmark::State& state)
+{
+    const auto             record = static_cast<std::size_t>(state.range(0));
+    std::vector<std::byte> bytes(1 << 16);
+    const auto frame = memory::rc_buffer::copy_from(bytes.data(), bytes.size());
+
+    for (auto _ : state)
+    {
+        auto                           rest = frame;
+        std::vector<memory::rc_buffer> records;
+        while (!rest.empty())
+        {
+            records.push_back(rest.split_to(record));
+        }
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (1 << 16));
+}
+BENCHMARK(rc_ptr_split_rc_buffer)->Arg(256)->Arg(4096);
+
+static void std_gather_copy(benchmark::State& state)
+{
+    const auto             body_size = static_cast<std::size_t>(state.range(0));
+    std::vector<std::byte> header(64);
+    std::vector<std::byte> body(body_size);
+    std::vector<std::byte> trailer(16);
+
+    for (auto _ : state)
+    {
+        std::vector<std::byte> message;
+        message.reserve(header.size() + body.size() + trailer.size());
+        message.insert(message.end(), header.begin(), header.end());
+        message.insert(message.end(), body.begin(), body.end());
+        message.insert(message.end(), trailer.begin(), trailer.end());
+        benchmark::DoNotOptimize(message.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (80 + body_size));
+}
+BENCHMARK(std_gather_copy)->Arg(4096)->Arg(1 << 16);
+
+#if RC_PTR_HAS_IOVEC
+static void rc_ptr_gather_buffer_chain(benchmark::State& state)
+{
+    const auto             body_size = static_cast<std::size_t>(state.range(0));
+    std::vector<std::byte> bytes(body_size);
+    const auto header  = memory::rc_buffer::copy_from(bytes.data(), 64);
+    const auto body    = memory::rc_buffer::copy_from(bytes.data(), body_size);
+    const auto trailer = memory::rc_buffer::copy_from(bytes.data(), 16);
+
+    for (auto _ : state)
+    {
+        memory::rc_buffer_chain message;
+        message.append(header);
+        message.append(body);
+        message.append(trailer);
+
+        constexpr auto count = memory::rc_buffer_chain::inline_capacity;
+        struct iovec   vec[count];
+        benchmark::DoNotOptimize(message.to_iovec(vec, count));
+        benchmark::DoNotOptimize(vec);
+    }
+    state.SetBytesProcessed(state.iterations() * (80 + body_size));
+}
+BENCHMARK(rc_ptr_gather_buffer_chain)->Arg(4096)->Arg(1 << 16);
+#endif
+
+#if __has_include(<sys/mman.h>)
+static const char* index_file(std::size_t size)
+{
+    static const char* path = "rc_ptr_benchmark_index";
+    std::ofstream{ path, std::ios::binary | std::ios::trunc }
+        << std::string(size, 'x');
+    return path;
+}
+
+static void std_load_index(benchmark::State& state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const auto path = index_file(size);
+
+    for (auto _ : state)
+    {
+        std::ifstream          file{ path, std::ios::binary };
+        std::vector<std::byte> bytes(size);
+        file.read(reinterpret_cast<char*>(bytes.data()), size);
+        benchmark::DoNotOptimize(bytes.data());
+    }
+    std::remove(path);
+}
+BENCHMARK(std_load_index)->Arg(1 << 16)->Arg(1 << 22);
+
+static void rc_ptr_load_index_mmap_cache(benchmark::State& state)
+{
+    const auto            size = static_cast<std::size_t>(state.range(0));
+    const auto            path = index_file(size);
+    memory::rc_mmap_cache cache;
+    const auto            consumer = cache.open(path);
+
+    for (auto _ : state)
+    {
+        auto region = cache.open(path);
+        benchmark::DoNotOptimize(region.get());
+    }
+    std::remove(path);
+}
+BENCHMARK(rc_ptr_load_index_mmap_cache)->Arg(1 << 16)->Arg(1 << 22);
+#endif
+
+struct checkpoint_schema
+{
+    std::vector<int> columns;
+};
+
+struct checkpoint_record
+{
+    int                               key;
+    memory::rc_ptr<checkpoint_schema> schema;
+};
+
+namespace memory
+{
+template<>
+struct rc_graph_traits<checkpoint_schema>
+{
+    static void save(rc_graph_writer& out, const checkpoint_schema& value)
+    {
+        out.write_size(value.columns.size());
+        out.write_bytes(value.columns.data(),
+                        value.columns.size() * sizeof(int));
+    }
+
+    static checkpoint_schema load(rc_graph_reader& in)
+    {
+        checkpoint_schema result;
+        result.columns.resize(in.read_size());
+        in.read_bytes(result.columns.data(),
+                      result.columns.size() * sizeof(int));
+        return result;
+    }
+};
+
+template<>
+struct rc_graph_traits<checkpoint_record>
+{
+    static void save(rc_graph_writer& out, const checkpoint_record& value)
+    {
+        out.write(value.key);
+        out.write_rc(value.schema);
+    }
+
+    static checkpoint_record load(rc_graph_reader& in)
+    {
+        checkpoint_record result;
+        result.key    = in.read<int>();
+        result.schema = in.read_rc<checkpoint_schema>();
+        return result;
+    }
+};
+} // namespace memory
+
+// 4096 records sharing 16 schemas of 64 columns.
+static std::vector<memory::rc_ptr<checkpoint_record>> checkpoint_records()
+{
+    std::vector<memory::rc_ptr<checkpoint_schema>> schemas;
+    for (int i = 0; i != 16; ++i)
+    {
+        schemas.push_back(memory::make_rc<checkpoint_schema>(
+            checkpoint_schema{ std::vector<int>(64, i) }));
+    }
+
+    std::vector<memory::rc_ptr<checkpoint_record>> records;
+    for (int i = 0; i != 4096; ++i)
+    {
+        records.push_back(memory::make_rc<checkpoint_record>(
+            checkpoint_record{ i, schemas[i % 16] }));
+    }
+    return records;
+}
+
+static void tree_checkpoint(benchmark::State& state)
+{
+    const auto records = checkpoint_records();
+
+    for (auto _ : state)
+    {
+        std::stringstream stream;
+        for (const auto& record : records)
+        {
+            const auto& columns = record->schema->columns;
+            const auto  size    = columns.size();
+            stream.write(reinterpret_cast<const char*>(&record->key),
+                         sizeof(int));
+            stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            stream.write(reinterpret_cast<const char*>(columns.data()),
+                         size * sizeof(int));
+        }
+
+        std::vector<memory::rc_ptr<checkpoint_record>> loaded;
+        for (std::size_t i = 0; i != records.size(); ++i)
+        {
+            checkpoint_record record;
+            std::size_t       size;
+            stream.read(reinterpret_cast<char*>(&record.key), sizeof(int));
+            stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+            checkpoint_schema schema{ std::vector<int>(size) };
+            stream.read(reinterpret_cast<char*>(schema.columns.data()),
+                        size * sizeof(int));
+            record.schema = memory::make_rc<checkpoint_schema>(
+                std::move(schema));
+            loaded.push_back(
+                memory::make_rc<checkpoint_record>(std::move(record)));
+        }
+
+        state.counters["bytes"] = static_cast<double>(stream.str().size());
+        benchmark::DoNotOptimize(loaded.data());
+    }
+}
+BENCHMARK(tree_checkpoint);
+
+static void rc_ptr_graph_checkpoint(benchmark::State& state)
+{
+    const auto records = checkpoint_records();
+
+    for (auto _ : state)
+    {
+        std::stringstream stream;
+        {
+            memory::rc_graph_writer writer{ stream };
+            for (const auto& record : records)
+            {
+                writer.write_rc(record);
+            }
+        }
+
+        std::vector<memory::rc_ptr<checkpoint_record>> loaded;
+        {
+            memory::rc_graph_reader reader{ stream };
+            for (std::size_t i = 0; i != records.size(); ++i)
+            {
+                loaded.push_back(reader.read_rc<checkpoint_record>());
+            }
+        }
+
+        state.counters["bytes"] = static_cast<double>(stream.str().size());
+        benchmark::DoNotOptimize(loaded.data());
+    }
+}
+BENCHMARK(rc_ptr_graph_checkpoint);
+
+struct startup_tree
+{
+    int                          value;
+    memory::rc_ptr<startup_tree> left;
+    memory::rc_ptr<startup_tree> right;
+};
+
+struct offset_startup_tree
+{
+    int                                        value;
+    memory::offset_rc_ptr<offset_startup_tree> left;
+    memory::offset_rc_ptr<offset_startup_tree> right;
+};
+
+namespace memory
+{
+template<>
+struct rc_graph_traits<startup_tree>
+{
+    static void save(rc_graph_writer& out, const startup_tree& value)
+    {
+        out.write(value.value);
+        out.write_rc(value.left);
+        out.write_rc(value.right);
+    }
+
+    static startup_tree load(rc_graph_reader& in)
+    {
+        startup_tree result;
+        result.value = in.read<int>();
+        result.left  = in.read_rc<startup_tree>();
+        result.right = in.read_rc<startup_tree>();
+        return result;
+    }
+};
+} // namespace memory
+
+template<typename Tree>
+static long long startup_tree_sum(const Tree* tree)
+{
+    return tree ? tree->value + startup_tree_sum(tree->left.get()) +
+                      startup_tree_sum(tree->right.get()) :
+                  0;
+}
+
+static memory::rc_ptr<startup_tree> make_startup_tree(int depth, int& next)
+{
+    if (!depth)
+    {
+        return nullptr;
+    }
+
+    auto left  = make_startup_tree(depth - 1, next);
+    auto right = make_startup_tree(depth - 1, next);
+    return memory::make_rc<startup_tree>(
+        startup_tree{ next++, std::move(left), std::move(right) });
+}
+
+static memory::offset_rc_ptr<offset_startup_tree>
+    make_offset_startup_tree(memory::offset_arena arena, int depth, int& next)
+{
+    if (!depth)
+    {
+        return nullptr;
+    }
+
+    auto left  = make_offset_startup_tree(arena, depth - 1, next);
+    auto right = make_offset_startup_tree(arena, depth - 1, next);
+    return memory::make_offset_rc<offset_startup_tree>(
+        arena,
+        offset_startup_tree{ next++, std::move(left), std::move(right) });
+}
+
+static void rc_ptr_startup_deserialize(benchmark::State& state)
+{
+    int               next = 0;
+    std::stringstream stream;
+    memory::rc_graph_writer{ stream }.write_rc(make_startup_tree(16, next));
+    const auto bytes = stream.str();
+
+    for (auto _ : state)
+    {
+        std::stringstream       in{ bytes };
+        memory::rc_graph_reader reader{ in };
+        auto                    tree = reader.read_rc<startup_tree>();
+        benchmark::DoNotOptimize(startup_tree_sum(tree.get()));
+    }
+}
+BENCHMARK(rc_ptr_startup_deserialize);
+
+static void rc_ptr_startup_offset_attach(benchmark::State& state)
+{
+    struct alignas(16) unit
+    {
+        std::byte bytes[16];
+    };
+
+    std::vector<unit> region(1 << 19);
+    {
+        int  next = 0;
+        auto arena =
+            memory::offset_arena::create(region.data(), region.size() * 16);
+        arena.root<offset_startup_tree>() =
+            make_offset_startup_tree(arena, 16, next);
+    }
+
+    for (auto _ : state)
+    {
+        auto arena =
+            memory::offset_arena::attach(region.data(), region.size() * 16);
+        benchmark::DoNotOptimize(
+            startup_tree_sum(arena.root<offset_startup_tree>().get()));
+    }
+}
+BENCHMARK(rc_ptr_startup_offset_attach);
@@ -0,0 +1,512 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef OFFSET_RC_PTR_HPP
+#define OFFSET_RC_PTR_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+template<typename T>
+class offset_rc_ptr;
+
+class offset_arena;
+
+namespace detail
+{
+// Alignment of the blocks allocated by offset_arena.
+constexpr std::size_t offset_alignment = 16;
+
+// Blocks are rounded up to powers of two, from 16 bytes up to 2^47 bytes.
+constexpr std::size_t offset_min_class   = 4;
+constexpr std::size_t offset_class_count = 44;
+
+constexpr std::uint64_t offset_arena_magic = 0x31414e4552414352; // "RCARENA1"
+
+inline std::uintptr_t address_of(const void* ptr) noexcept
+{
+    return reinterpret_cast<std::uintptr_t>(ptr);
+}
+
+// Self-relative offsets, 0 stands for nullptr. A pointer is never stored at
+// the address it points to, as the objects follow their block headers.
+inline std::ptrdiff_t to_offset(const void* self, const void* target) noexcept
+{
+    return target ? static_cast<std::ptrdiff_t>(address_of(target) -
+                                                address_of(self)) :
+                    0;
+}
+
+template<typename T>
+T* from_offset(const void* self, std::ptrdiff_t offset) noexcept
+{
+    return offset ? reinterpret_cast<T*>(address_of(self) +
+                                         static_cast<std::uintptr_t>(offset)) :
+                    nullptr;
+}
+
+/**
+ * @brief Header of the region managed by offset_arena. All the positions
+ * are offsets from the beginning of the region.
+ *
+ */
+struct offset_arena_header
+{
+    std::uint64_t  magic;
+    std::uint64_t  size;
+    std::uint64_t  used;
+    std::ptrdiff_t root;
+    std::uint64_t  free_lists[offset_class_count];
+};
+
+/**
+ * @brief Control block resident in the arena, followed by the object.
+ *
+ */
+struct alignas(offset_alignment) offset_control_block
+{
+    std::uint64_t  ref_count;
+    std::ptrdiff_t arena;
+
+    void* object() noexcept
+    {
+        return this + 1;
+    }
+};
+
+constexpr std::size_t offset_header_size =
+    (sizeof(offset_arena_header) + offset_alignment - 1) &
+    ~(offset_alignment - 1);
+} // namespace detail
+
+/**
+ * @brief offset_arena class allocates memory from a caller-provided region,
+ * e.g. a writable file mapping or shared memory. The allocator state lives
+ * at the beginning of the region and refers to the blocks by offsets, so
+ * the region stays valid when it is mapped at another address.
+ *
+ * Blocks are rounded up to powers of two and reused through a free list of
+ * each size. The arena is a handle to the region and is cheap to copy.
+ *
+ */
+class offset_arena
+{
+public:
+    /**
+     * @brief Formats the region as an empty arena.
+     *
+     * @param base Aligned to 16 bytes
+     * @param size
+     * @return offset_arena
+     * @throws std::invalid_argument when the region cannot hold the header
+     */
+    static offset_arena create(void* base, std::size_t size)
+    {
+        assert(detail::address_of(base) % detail::offset_alignment == 0);
+
+        if (size < detail::offset_header_size)
+        {
+            throw std::invalid_argument("offset_arena: region too small.");
+        }
+
+        auto header = ::new (base) detail::offset_arena_header{};
+        header->magic = detail::offset_arena_magic;
+        header->size  = size;
+        header->used  = detail::offset_header_size;
+        return offset_arena{ header };
+    }
+
+    /**
+     * @brief Attaches to the arena created earlier in the region, possibly
+     * at a different address.
+     *
+     * @param base Aligned to 16 bytes
+     * @param size Size of the region, e.g. of the file mapping
+     * @return offset_arena
+     * @throws std::invalid_argument when the region holds no arena or is
+     * smaller than the arena
+     */
+    static offset_arena attach(void* base, std::size_t size)
+    {
+        assert(detail::address_of(base) % detail::offset_alignment == 0);
+
+        auto header = static_cast<detail::offset_arena_header*>(base);
+        if (size < detail::offset_header_size ||
+            header->magic != detail::offset_arena_magic)
+        {
+            throw std::invalid_argument("offset_arena: no arena in region.");
+        }
+
+        if (header->size > size || header->used > header->size ||
+            header->used < detail::offset_header_size)
+        {
+            throw std::invalid_argument("offset_arena: region too small.");
+        }
+
+        return offset_arena{ header };
+    }
+
+    /**
+     * @brief Allocates at least size bytes aligned to 16 bytes.
+     *
+     * @param size
+     * @return void*
+     * @throws std::bad_alloc when the region is exhausted
+     */
+    void* allocate(std::size_t size)
+    {
+        const auto size_class = class_of(size);
+        auto&      free_list  = m_header->free_lists[size_class];
+
+        if (free_list)
+        {
+            auto block = base() + free_list;
+            free_list  = *reinterpret_cast<std::uint64_t*>(block);
+            return block;
+        }
+
+        const auto block_size = class_size(size_class);
+        if (block_size > m_header->size - m_header->used)
+        {
+            throw std::bad_alloc();
+        }
+
+        auto block = base() + m_header->used;
+        m_header->used += block_size;
+        return block;
+    }
+
+    /**
+     * @brief Returns the block allocated with the same size to its free
+     * list.
+     *
+     * @param ptr
+     * @param size
+     */
+    void deallocate(void* ptr, std::size_t size) noexcept
+    {
+        assert(contains(ptr));
+
+        const auto size_class = find_class(size);
+        assert(size_class < detail::offset_class_count);
+
+        auto& free_list = m_header->free_lists[size_class];
+        *static_cast<std::uint64_t*>(ptr) = free_list;
+        free_list = static_cast<std::byte*>(ptr) - base();
+    }
+
+    /**
+     * @brief Returns true if ptr points into the region.
+     *
+     * @param ptr
+     * @return true
+     * @return false
+     */
+    bool contains(const void* ptr) const noexcept
+    {
+        const auto address = detail::address_of(ptr);
+        const auto first   = detail::address_of(m_header);
+        return address >= first && address - first < m_header->size;
+    }
+
+    /**
+     * @brief Returns the number of bytes used by the header and the blocks,
+     * including the free ones.
+     *
+     * @return std::size_t
+     */
+    std::size_t used() const noexcept
+    {
+        return m_header->used;
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return m_header->size;
+    }
+
+    /**
+     * @brief Returns the root pointer stored in the header, the entry point
+     * of the structures of the arena after attach. All the callers must use
+     * the same type T.
+     *
+     * @tparam T
+     * @return offset_rc_ptr<T>&
+     */
+    template<typename T>
+    offset_rc_ptr<T>& root() noexcept
+    {
+        static_assert(sizeof(offset_rc_ptr<T>) == sizeof(std::ptrdiff_t));
+        return *reinterpret_cast<offset_rc_ptr<T>*>(&m_header->root);
+    }
+
+    bool operator==(const offset_arena& other) const noexcept
+    {
+        return m_header == other.m_header;
+    }
+
+    bool operator!=(const offset_arena& other) const noexcept
+    {
+        return m_header != other.m_header;
+    }
+
+private:
+    template<typename T>
+    friend class offset_rc_ptr;
+
+    explicit offset_arena(detail::offset_arena_header* header) noexcept :
+        m_header{ header }
+    {
+    }
+
+    std::byte* base() const noexcept
+    {
+        return reinterpret_cast<std::byte*>(m_header);
+    }
+
+    // Returns offset_class_count when size exceeds the largest class.
+    static std::size_t find_class(std::size_t size) noexcept
+    {
+        std::size_t size_class = 0;
+        while (size_class < detail::offset_class_count &&
+               class_size(size_class) < size)
+        {
+            ++size_class;
+        }
+
+        return size_class;
+    }
+
+    static std::size_t class_of(std::size_t size)
+    {
+        const auto size_class = find_class(size);
+        if (size_class == detail::offset_class_count)
+        {
+            throw std::bad_alloc();
+        }
+
+        return size_class;
+    }
+
+    static constexpr std::size_t class_size(std::size_t size_class) noexcept
+    {
+        return std::size_t{ 1 } << (size_class + detail::offset_min_class);
+    }
+
+    detail::offset_arena_header* m_header;
+};
+
+/**
+ * @brief offset_rc_ptr class template is a reference counting pointer to an
+ * object allocated in offset_arena by make_offset_rc. Instead of addresses,
+ * it stores the offset of the control block from itself, and the control
+ * block, placed in the arena in front of the object, stores the offset of
+ * the arena. A graph of objects linked by offset_rc_ptr members is therefore
+ * valid at any base address of the region and needs no fixups on load.
+ *
+ * The reference count is kept in the region. offset_rc_ptr objects outside
+ * of the region, e.g. on the stack, must be destroyed before the region is
+ * unmapped, only the ones stored in the region persist.
+ *
+ * The objects are destroyed as T, without conversions to the base classes,
+ * and there are no weak references. The class methods are not thread safe.
+ *
+ * @tparam T Type of the object, aligned to at most 16 bytes
+ */
+template<typename T>
+class offset_rc_ptr
+{
+public:
+    using element_type = T;
+    using pointer      = T*;
+    using reference    = T&;
+
+    constexpr offset_rc_ptr() noexcept = default;
+
+    constexpr offset_rc_ptr(std::nullptr_t) noexcept { }
+
+    offset_rc_ptr(const offset_rc_ptr& other) noexcept :
+        m_offset{ detail::to_offset(this, other.block()) }
+    {
+        if (auto block = this->block())
+        {
+            ++block->ref_count;
+        }
+    }
+
+    offset_rc_ptr(offset_rc_ptr&& other) noexcept :
+        m_offset{ detail::to_offset(this, other.block()) }
+    {
+        other.m_offset = 0;
+    }
+
+    offset_rc_ptr& operator=(const offset_rc_ptr& other) noexcept
+    {
+        offset_rc_ptr(other).swap(*this);
+        return *this;
+    }
+
+    offset_rc_ptr& operator=(offset_rc_ptr&& other) noexcept
+    {
+        offset_rc_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~offset_rc_ptr()
+    {
+        auto block = this->block();
+        if (!block || --block->ref_count)
+        {
+            return;
+        }
+
+        get()->~T();
+
+        auto arena = offset_arena{ detail::from_offset<
+            detail::offset_arena_header>(block, block->arena) };
+        arena.deallocate(block, block_size);
+    }
+
+    pointer get() const noexcept
+    {
+        auto block = this->block();
+        return block ? static_cast<pointer>(block->object()) : nullptr;
+    }
+
+    reference operator*() const noexcept
+    {
+        assert(m_offset);
+        return *get();
+    }
+
+    pointer operator->() const noexcept
+    {
+        assert(m_offset);
+        return get();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_offset != 0;
+    }
+
+    std::size_t use_count() const noexcept
+    {
+        auto block = this->block();
+        return block ? static_cast<std::size_t>(block->ref_count) : 0;
+    }
+
+    bool unique() const noexcept
+    {
+        return use_count() == 1;
+    }
+
+    void reset() noexcept
+    {
+        offset_rc_ptr().swap(*this);
+    }
+
+    void swap(offset_rc_ptr& other) noexcept
+    {
+        auto block       = this->block();
+        auto other_block = other.block();
+        m_offset         = detail::to_offset(this, other_block);
+        other.m_offset   = detail::to_offset(&other, block);
+    }
+
+    friend bool operator==(const offset_rc_ptr& lhs,
+                           const offset_rc_ptr& rhs) noexcept
+    {
+        return lhs.block() == rhs.block();
+    }
+
+    friend bool operator!=(const offset_rc_ptr& lhs,
+                           const offset_rc_ptr& rhs) noexcept
+    {
+        return lhs.block() != rhs.block();
+    }
+
+    /**
+     * @brief Creates the object in the arena, forwarding the arguments to
+     * the constructor of type T. The control block and the object share one
+     * allocation.
+     *
+     * @tparam ArgsT
+     * @param arena
+     * @param args
+     * @return offset_rc_ptr
+     * @throws std::bad_alloc when the arena is exhausted
+     */
+    template<typename... ArgsT>
+    static offset_rc_ptr make(offset_arena arena, ArgsT&&... args)
+    {
+        static_assert(alignof(T) <= detail::offset_alignment,
+                      "T must be aligned to at most 16 bytes.");
+
+        auto mem = arena.allocate(block_size);
+        try
+        {
+            ::new (static_cast<detail::offset_control_block*>(mem)
+                       ->object()) T(std::forward<ArgsT>(args)...);
+        }
+        catch (...)
+        {
+            arena.deallocate(mem, block_size);
+            throw;
+        }
+
+        auto block       = static_cast<detail::offset_control_block*>(mem);
+        block->ref_count = 1;
+        block->arena     = detail::to_offset(block, arena.m_header);
+
+        offset_rc_ptr result;
+        result.m_offset = detail::to_offset(&result, block);
+        return result;
+    }
+
+private:
+    static constexpr std::size_t block_size =
+        sizeof(detail::offset_control_block) + sizeof(T);
+
+    detail::offset_control_block* block() const noexcept
+    {
+        return detail::from_offset<detail::offset_control_block>(this,
+                                                                 m_offset);
+    }
+
+    std::ptrdiff_t m_offset = 0;
+};
+
+/**
+ * @brief Creates the object of type T in the arena, forwarding the
+ * arguments to its constructor.
+ *
+ * @tparam T
+ * @tparam ArgsT
+ * @param arena
+ * @param args
+ * @return offset_rc_ptr<T>
+ * @throws std::bad_alloc when the arena is exhausted
+ */
+template<typename T, typename... ArgsT>
+offset_rc_ptr<T> make_offset_rc(offset_arena arena, ArgsT&&... args)
+{
+    return offset_rc_ptr<T>::make(arena, std::forward<ArgsT>(args)...);
+}
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
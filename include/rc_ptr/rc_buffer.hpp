@@ -0,0 +1,531 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_BUFFER_HPP
+#define RC_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+class rc_buffer_mut;
+
+/**
+ * @brief rc_buffer class is an immutable view of bytes sharing the ownership
+ * of their storage. The view is a slice of rc_ptr<std::byte[]>, so slice,
+ * split_to and split_off only adjust the pointer and the size and increment
+ * the reference count of the storage, the bytes are never copied.
+ *
+ */
+class rc_buffer
+{
+public:
+    using value_type     = std::byte;
+    using size_type      = std::size_t;
+    using const_iterator = const std::byte*;
+
+    rc_buffer() noexcept = default;
+
+    /**
+     * @brief Creates the view of all bytes of the array.
+     *
+     * @param bytes
+     */
+    explicit rc_buffer(rc_ptr<std::byte[]> bytes) noexcept :
+        m_bytes{ std::move(bytes) }
+    {
+    }
+
+    /**
+     * @brief Copies size bytes from data into a new storage.
+     *
+     * @param data
+     * @param size
+     * @return rc_buffer
+     */
+    static rc_buffer copy_from(const void* data, size_type size)
+    {
+        if (!size)
+        {
+            return rc_buffer{};
+        }
+
+        auto bytes = make_rc_for_overwrite<std::byte[]>(size);
+        std::memcpy(bytes.get(), data, size);
+        return rc_buffer{ std::move(bytes) };
+    }
+
+    const std::byte* data() const noexcept
+    {
+        return m_bytes.get();
+    }
+
+    size_type size() const noexcept
+    {
+        return m_bytes ? m_bytes.size() : 0;
+    }
+
+    bool empty() const noexcept
+    {
+        return !size();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return data();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return data() + size();
+    }
+
+    std::byte operator[](size_type index) const noexcept
+    {
+        assert(index < size());
+        return m_bytes[index];
+    }
+
+    /**
+     * @brief Returns true if no other view shares the storage.
+     *
+     * @return true
+     * @return false
+     */
+    bool unique() const noexcept
+    {
+        return m_bytes.unique();
+    }
+
+    /**
+     * @brief Returns the view as rc_ptr, sharing the ownership with this.
+     *
+     * @return const rc_ptr<std::byte[]>&
+     */
+    const rc_ptr<std::byte[]>& as_rc() const noexcept
+    {
+        return m_bytes;
+    }
+
+    /**
+     * @brief Returns the view of the bytes [first, last).
+     *
+     * @param first
+     * @param last
+     * @return rc_buffer
+     */
+    rc_buffer slice(size_type first, size_type last) const noexcept
+    {
+        assert(first <= last && last <= size());
+        return rc_buffer{ subrange(first, last - first) };
+    }
+
+    /**
+     * @brief Removes the bytes [0, at) from this and returns them.
+     *
+     * @param at
+     * @return rc_buffer
+     */
+    rc_buffer split_to(size_type at) noexcept
+    {
+        assert(at <= size());
+        rc_buffer head{ subrange(0, at) };
+        m_bytes = subrange(at, size() - at);
+        return head;
+    }
+
+    /**
+     * @brief Removes the bytes [at, size()) from this and returns them.
+     *
+     * @param at
+     * @return rc_buffer
+     */
+    rc_buffer split_off(size_type at) noexcept
+    {
+        assert(at <= size());
+        rc_buffer tail{ subrange(at, size() - at) };
+        m_bytes = subrange(0, at);
+        return tail;
+    }
+
+    /**
+     * @brief Keeps the first count bytes.
+     *
+     * @param count
+     */
+    void truncate(size_type count) noexcept
+    {
+        if (count < size())
+        {
+            m_bytes = subrange(0, count);
+        }
+    }
+
+    /**
+     * @brief Removes the first count bytes.
+     *
+     * @param count
+     */
+    void advance(size_type count) noexcept
+    {
+        assert(count <= size());
+        m_bytes = subrange(count, size() - count);
+    }
+
+    void clear() noexcept
+    {
+        m_bytes.reset();
+    }
+
+    /**
+     * @brief Converts the view into rc_buffer_mut. The storage is reused
+     * when no other view shares it, otherwise the bytes are copied.
+     *
+     * @return rc_buffer_mut
+     */
+    rc_buffer_mut into_mut() &&;
+
+private:
+    rc_ptr<std::byte[]> subrange(size_type offset,
+                                 size_type count) const noexcept
+    {
+        return m_bytes ? m_bytes.slice(offset, count) : rc_ptr<std::byte[]>{};
+    }
+
+    rc_ptr<std::byte[]> m_bytes;
+};
+
+/**
+ * @brief rc_buffer_mut class is a growable byte buffer over
+ * rc_ptr<std::byte[]>. split_to and split_off divide the buffer into views
+ * of disjoint ranges of the same storage, each limited to its own range.
+ * freeze converts the buffer into rc_buffer without copying.
+ *
+ * When the storage is no longer shared with another view, reserve reclaims
+ * the space released by advance and by the dropped split parts before
+ * allocating a new storage.
+ *
+ */
+class rc_buffer_mut
+{
+public:
+    using value_type     = std::byte;
+    using size_type      = std::size_t;
+    using iterator       = std::byte*;
+    using const_iterator = const std::byte*;
+
+    rc_buffer_mut() noexcept = default;
+
+    /**
+     * @brief Creates the empty buffer able to hold capacity bytes.
+     *
+     * @param capacity
+     */
+    explicit rc_buffer_mut(size_type capacity)
+    {
+        reserve(capacity);
+    }
+
+    rc_buffer_mut(const rc_buffer_mut&) = delete;
+    rc_buffer_mut& operator=(const rc_buffer_mut&) = delete;
+
+    rc_buffer_mut(rc_buffer_mut&& other) noexcept :
+        m_storage{ std::move(other.m_storage) },
+        m_offset{ std::exchange(other.m_offset, 0) },
+        m_size{ std::exchange(other.m_size, 0) },
+        m_capacity{ std::exchange(other.m_capacity, 0) }
+    {
+    }
+
+    rc_buffer_mut& operator=(rc_buffer_mut&& other) noexcept
+    {
+        m_storage  = std::move(other.m_storage);
+        m_offset   = std::exchange(other.m_offset, 0);
+        m_size     = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        return *this;
+    }
+
+    std::byte* data() noexcept
+    {
+        return m_storage.get() + m_offset;
+    }
+
+    const std::byte* data() const noexcept
+    {
+        return m_storage.get() + m_offset;
+    }
+
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    size_type capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    bool empty() const noexcept
+    {
+        return !m_size;
+    }
+
+    iterator begin() noexcept
+    {
+        return data();
+    }
+
+    iterator end() noexcept
+    {
+        return data() + m_size;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return data();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return data() + m_size;
+    }
+
+    std::byte& operator[](size_type index) noexcept
+    {
+        assert(index < m_size);
+        return data()[index];
+    }
+
+    std::byte operator[](size_type index) const noexcept
+    {
+        assert(index < m_size);
+        return data()[index];
+    }
+
+    /**
+     * @brief Returns true if no other view shares the storage.
+     *
+     * @return true
+     * @return false
+     */
+    bool unique() const noexcept
+    {
+        return m_storage.unique();
+    }
+
+    /**
+     * @brief Makes room for at least additional more bytes.
+     *
+     * @param additional
+     */
+    void reserve(size_type additional)
+    {
+        if (additional <= m_capacity - m_size)
+        {
+            return;
+        }
+
+        const auto required = m_size + additional;
+
+        // No other view refers to the storage, so all of it is free except
+        // for the bytes of this buffer.
+        if (m_storage.unique() && m_storage.size() >= required)
+        {
+            if (m_storage.size() - m_offset < required)
+            {
+                std::memmove(m_storage.get(), data(), m_size);
+                m_offset = 0;
+            }
+
+            m_capacity = m_storage.size() - m_offset;
+            return;
+        }
+
+        auto storage = make_rc_for_overwrite<std::byte[]>(
+            std::max(required, 2 * m_capacity));
+        if (m_size)
+        {
+            std::memcpy(storage.get(), data(), m_size);
+        }
+
+        m_storage  = std::move(storage);
+        m_offset   = 0;
+        m_capacity = m_storage.size();
+    }
+
+    void append(const void* bytes, size_type count)
+    {
+        if (!count)
+        {
+            return;
+        }
+
+        reserve(count);
+        std::memcpy(data() + m_size, bytes, count);
+        m_size += count;
+    }
+
+    void push_back(std::byte value)
+    {
+        reserve(1);
+        data()[m_size++] = value;
+    }
+
+    void resize(size_type size, std::byte value = std::byte{})
+    {
+        if (size > m_size)
+        {
+            reserve(size - m_size);
+            std::memset(data() + m_size,
+                        std::to_integer<int>(value),
+                        size - m_size);
+        }
+
+        m_size = size;
+    }
+
+    /**
+     * @brief Returns the pointer to the unused capacity, which may be filled
+     * externally, e.g. by readv, and then added with commit.
+     *
+     * @return std::byte*
+     */
+    std::byte* spare() noexcept
+    {
+        return data() + m_size;
+    }
+
+    /**
+     * @brief Adds count bytes written to the unused capacity to the buffer.
+     *
+     * @param count
+     */
+    void commit(size_type count) noexcept
+    {
+        assert(count <= m_capacity - m_size);
+        m_size += count;
+    }
+
+    /**
+     * @brief Keeps the first count bytes, the capacity is unchanged.
+     *
+     * @param count
+     */
+    void truncate(size_type count) noexcept
+    {
+        m_size = std::min(count, m_size);
+    }
+
+    /**
+     * @brief Removes the first count bytes.
+     *
+     * @param count
+     */
+    void advance(size_type count) noexcept
+    {
+        assert(count <= m_size);
+        m_offset += count;
+        m_size -= count;
+        m_capacity -= count;
+    }
+
+    void clear() noexcept
+    {
+        m_size = 0;
+    }
+
+    /**
+     * @brief Removes the bytes [0, at) from this and returns them. The
+     * returned buffer ends at at, this keeps the rest of the capacity.
+     *
+     * @param at
+     * @return rc_buffer_mut
+     */
+    rc_buffer_mut split_to(size_type at) noexcept
+    {
+        assert(at <= m_size);
+        rc_buffer_mut head{ m_storage, m_offset, at, at };
+        advance(at);
+        return head;
+    }
+
+    /**
+     * @brief Removes the bytes [at, size()) from this and returns them
+     * together with the rest of the capacity. This ends at at.
+     *
+     * @param at
+     * @return rc_buffer_mut
+     */
+    rc_buffer_mut split_off(size_type at) noexcept
+    {
+        assert(at <= m_size);
+        rc_buffer_mut tail{ m_storage,
+                            m_offset + at,
+                            m_size - at,
+                            m_capacity - at };
+        m_size     = at;
+        m_capacity = at;
+        return tail;
+    }
+
+    /**
+     * @brief Converts the buffer into rc_buffer sharing its storage.
+     *
+     * @return rc_buffer
+     */
+    rc_buffer freeze() &&
+    {
+        rc_buffer result =
+            m_size ? rc_buffer{ m_storage.slice(m_offset, m_size) } :
+                     rc_buffer{};
+        *this = rc_buffer_mut{};
+        return result;
+    }
+
+private:
+    friend class rc_buffer;
+
+    rc_buffer_mut(rc_ptr<std::byte[]> storage,
+                  size_type           offset,
+                  size_type           size,
+                  size_type           capacity) noexcept :
+        m_storage{ std::move(storage) },
+        m_offset{ offset },
+        m_size{ size },
+        m_capacity{ capacity }
+    {
+    }
+
+    rc_ptr<std::byte[]> m_storage;
+    size_type           m_offset   = 0;
+    size_type           m_size     = 0;
+    size_type           m_capacity = 0;
+};
+
+inline rc_buffer_mut rc_buffer::into_mut() &&
+{
+    if (m_bytes.unique())
+    {
+        const auto size = m_bytes.size();
+        return rc_buffer_mut{ std::move(m_bytes), 0, size, size };
+    }
+
+    rc_buffer_mut result{ size() };
+    result.append(data(), size());
+    clear();
+    return result;
+}
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
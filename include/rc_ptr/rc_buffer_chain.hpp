@@ -0,0 +1,383 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_BUFFER_CHAIN_HPP
+#define RC_BUFFER_CHAIN_HPP
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#define RC_PTR_HAS_IOVEC 1
+#else
+#define RC_PTR_HAS_IOVEC 0
+#endif
+
+#include "rc_ptr/rc_buffer.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+/**
+ * @brief rc_buffer_chain class is a sequence of bytes made of rc_buffer
+ * fragments, e.g. a header, a cached body and a trailer, written with a
+ * single vectored write instead of being copied into a contiguous buffer.
+ *
+ * Up to inline_capacity fragments are stored in the chain itself. consume
+ * releases the fragments as soon as all of their bytes are consumed, and
+ * split_to divides at most one fragment, sharing its storage.
+ *
+ */
+class rc_buffer_chain
+{
+public:
+    using size_type      = std::size_t;
+    using const_iterator = const rc_buffer*;
+
+    static constexpr size_type inline_capacity = 4;
+
+    rc_buffer_chain() noexcept = default;
+
+    rc_buffer_chain(const rc_buffer_chain& other) : rc_buffer_chain()
+    {
+        append(other);
+    }
+
+    rc_buffer_chain(rc_buffer_chain&& other) noexcept :
+        m_inline{ std::move(other.m_inline) },
+        m_heap{ std::move(other.m_heap) },
+        m_first{ std::exchange(other.m_first, 0) },
+        m_last{ std::exchange(other.m_last, 0) },
+        m_size{ std::exchange(other.m_size, 0) }
+    {
+        other.m_heap.clear();
+    }
+
+    rc_buffer_chain& operator=(const rc_buffer_chain& other)
+    {
+        if (this != &other)
+        {
+            rc_buffer_chain copy{ other };
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    rc_buffer_chain& operator=(rc_buffer_chain&& other) noexcept
+    {
+        m_inline = std::move(other.m_inline);
+        m_heap   = std::move(other.m_heap);
+        m_first  = std::exchange(other.m_first, 0);
+        m_last   = std::exchange(other.m_last, 0);
+        m_size   = std::exchange(other.m_size, 0);
+        other.m_heap.clear();
+        return *this;
+    }
+
+    /**
+     * @brief Returns the number of bytes.
+     *
+     * @return size_type
+     */
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    bool empty() const noexcept
+    {
+        return !m_size;
+    }
+
+    /**
+     * @brief Returns the number of fragments.
+     *
+     * @return size_type
+     */
+    size_type fragment_count() const noexcept
+    {
+        return m_last - m_first;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return fragments() + m_first;
+    }
+
+    const_iterator end() const noexcept
+    {
+        return fragments() + m_last;
+    }
+
+    /**
+     * @brief Appends the fragment, empty ones are skipped.
+     *
+     * @param fragment
+     */
+    void append(rc_buffer fragment)
+    {
+        if (fragment.empty())
+        {
+            return;
+        }
+
+        make_room(1);
+        m_size += fragment.size();
+        fragments()[m_last++] = std::move(fragment);
+    }
+
+    /**
+     * @brief Appends the fragments of other, sharing their storage.
+     *
+     * @param other
+     */
+    void append(const rc_buffer_chain& other)
+    {
+        make_room(other.fragment_count());
+        for (const auto& fragment : other)
+        {
+            m_size += fragment.size();
+            fragments()[m_last++] = fragment;
+        }
+    }
+
+    void append(rc_buffer_chain&& other)
+    {
+        make_room(other.fragment_count());
+        for (auto it = other.mutable_begin(); it != other.mutable_end(); ++it)
+        {
+            m_size += it->size();
+            fragments()[m_last++] = std::move(*it);
+        }
+        other.clear();
+    }
+
+    /**
+     * @brief Removes the first count bytes, releasing the fragments
+     * consumed entirely.
+     *
+     * @param count
+     */
+    void consume(size_type count) noexcept
+    {
+        assert(count <= m_size);
+        m_size -= count;
+
+        while (count)
+        {
+            auto& front = fragments()[m_first];
+            if (count < front.size())
+            {
+                front.advance(count);
+                break;
+            }
+
+            count -= front.size();
+            front.clear();
+            ++m_first;
+        }
+
+        if (m_first == m_last)
+        {
+            m_first = 0;
+            m_last  = 0;
+        }
+    }
+
+    /**
+     * @brief Removes the first at bytes from this and returns them. At most
+     * one fragment is divided, no bytes are copied.
+     *
+     * @param at
+     * @return rc_buffer_chain
+     */
+    rc_buffer_chain split_to(size_type at)
+    {
+        assert(at <= m_size);
+        rc_buffer_chain head;
+
+        while (at)
+        {
+            auto& front = fragments()[m_first];
+            if (at < front.size())
+            {
+                head.append(front.split_to(at));
+                m_size -= at;
+                break;
+            }
+
+            at -= front.size();
+            m_size -= front.size();
+            head.append(std::move(front));
+            ++m_first;
+        }
+
+        if (m_first == m_last)
+        {
+            m_first = 0;
+            m_last  = 0;
+        }
+
+        return head;
+    }
+
+    /**
+     * @brief Removes the bytes [at, size()) from this and returns them.
+     *
+     * @param at
+     * @return rc_buffer_chain
+     */
+    rc_buffer_chain split_off(size_type at)
+    {
+        auto head = split_to(at);
+        std::swap(*this, head);
+        return head;
+    }
+
+    void clear() noexcept
+    {
+        for (auto it = mutable_begin(); it != mutable_end(); ++it)
+        {
+            it->clear();
+        }
+
+        m_heap.clear();
+        m_first = 0;
+        m_last  = 0;
+        m_size  = 0;
+    }
+
+    /**
+     * @brief Copies the bytes into a single rc_buffer. A chain of one
+     * fragment returns it without copying.
+     *
+     * @return rc_buffer
+     */
+    rc_buffer flatten() const
+    {
+        if (fragment_count() == 1)
+        {
+            return *begin();
+        }
+
+        rc_buffer_mut result{ m_size };
+        for (const auto& fragment : *this)
+        {
+            result.append(fragment.data(), fragment.size());
+        }
+        return std::move(result).freeze();
+    }
+
+#if RC_PTR_HAS_IOVEC
+    /**
+     * @brief Describes up to count fragments, starting from the first one,
+     * in vec for writev.
+     *
+     * @param vec
+     * @param count
+     * @return size_type Number of entries filled
+     */
+    size_type to_iovec(struct iovec* vec, size_type count) const noexcept
+    {
+        count = std::min(count, fragment_count());
+        for (size_type i = 0; i != count; ++i)
+        {
+            const auto& fragment = begin()[i];
+            vec[i].iov_base = const_cast<std::byte*>(fragment.data());
+            vec[i].iov_len  = fragment.size();
+        }
+        return count;
+    }
+#endif
+
+private:
+    const rc_buffer* fragments() const noexcept
+    {
+        return m_heap.empty() ? m_inline.data() : m_heap.data();
+    }
+
+    rc_buffer* fragments() noexcept
+    {
+        return m_heap.empty() ? m_inline.data() : m_heap.data();
+    }
+
+    rc_buffer* mutable_begin() noexcept
+    {
+        return fragments() + m_first;
+    }
+
+    rc_buffer* mutable_end() noexcept
+    {
+        return fragments() + m_last;
+    }
+
+    size_type capacity() const noexcept
+    {
+        return m_heap.empty() ? inline_capacity : m_heap.size();
+    }
+
+    // Moves the fragments to the front or to a larger heap array, so count
+    // more fit after the last one.
+    void make_room(size_type count)
+    {
+        if (m_last + count <= capacity())
+        {
+            return;
+        }
+
+        const auto fragment_count = m_last - m_first;
+
+        if (fragment_count + count <= capacity())
+        {
+            std::move(mutable_begin(), mutable_end(), fragments());
+            std::fill(fragments() + fragment_count,
+                      fragments() + m_last,
+                      rc_buffer{});
+        }
+        else
+        {
+            std::vector<rc_buffer> heap(
+                std::max(2 * capacity(), fragment_count + count));
+            std::move(mutable_begin(), mutable_end(), heap.begin());
+            m_heap = std::move(heap);
+
+            for (auto& fragment : m_inline)
+            {
+                fragment.clear();
+            }
+        }
+
+        m_first = 0;
+        m_last  = fragment_count;
+    }
+
+    std::array<rc_buffer, inline_capacity> m_inline;
+    std::vector<rc_buffer>                 m_heap;
+    size_type                              m_first = 0;
+    size_type                              m_last  = 0;
+    size_type                              m_size  = 0;
+};
+
+#if RC_PTR_HAS_IOVEC
+/**
+ * @brief Describes the unused capacity of the buffer for readv. Add the
+ * bytes read with rc_buffer_mut::commit.
+ *
+ * @param buffer
+ * @return struct iovec
+ */
+inline struct iovec spare_iovec(rc_buffer_mut& buffer) noexcept
+{
+    return { buffer.spare(), buffer.capacity() - buffer.size() };
+}
+#endif
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
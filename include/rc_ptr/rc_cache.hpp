@@ -0,0 +1,348 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_CACHE_HPP
+#define RC_CACHE_HPP
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+/**
+ * @brief Counters of rc_cache lookups and evictions.
+ *
+ */
+struct rc_cache_stats {
+    std::size_t hits          = 0; // Found in the strong segment.
+    std::size_t resurrections = 0; // Found alive in the weak segment.
+    std::size_t misses        = 0; // Not found or expired.
+    std::size_t evictions     = 0; // Moved from the strong to the weak segment.
+    std::size_t pruned        = 0; // Expired entries removed.
+};
+
+/**
+ * @brief rc_cache class template maps keys to rc_ptr<V> objects. The most
+ * recently used entries, up to the given capacity, are kept alive by the
+ * cache. The least recently used ones are demoted to weak_rc_ptr and stay
+ * available for as long as someone else owns them. Looking up a demoted
+ * entry which is still alive brings it back to the strong segment.
+ *
+ * The expired weak entries are pruned incrementally, a few per operation,
+ * so the cache never sweeps the whole map at once.
+ *
+ * @tparam K
+ * @tparam V
+ * @tparam Hash Default is std::hash<K>.
+ * @tparam Eq Default is std::equal_to<K>.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>,
+         typename Eq = std::equal_to<K>>
+class rc_cache
+{
+public:
+    using key_type   = K;
+    using rc_type    = rc_ptr<V>;
+    using weak_type  = weak_rc_ptr<V>;
+    using hasher     = Hash;
+    using key_equal  = Eq;
+    using stats_type = rc_cache_stats;
+
+    /**
+     * @brief Constructs an empty cache.
+     *
+     * @param capacity Maximum number of entries kept alive by the cache
+     * @param prune_step Number of weak entries checked per operation
+     */
+    explicit rc_cache(std::size_t capacity, std::size_t prune_step = 2) :
+        m_capacity{ capacity },
+        m_prune_step{ prune_step }
+    {
+    }
+
+    rc_cache(const rc_cache&) = delete;
+
+    rc_cache& operator=(const rc_cache&) = delete;
+
+    /**
+     * @brief Returns the value of key or empty rc_ptr. A hit moves the entry
+     * to the front of the strong segment.
+     *
+     * @param key
+     * @return rc_type
+     */
+    rc_type get(const K& key)
+    {
+        auto result = lookup(key);
+        prune(m_prune_step);
+        return result;
+    }
+
+    /**
+     * @brief Returns the value of key. On a miss, value is created by
+     * factory() and inserted.
+     *
+     * @tparam Factory
+     * @param key
+     * @param factory
+     * @return rc_type
+     */
+    template<typename Factory>
+    rc_type get_or_create(const K& key, Factory factory)
+    {
+        auto result = lookup(key);
+
+        if (!result)
+        {
+            result = factory();
+            insert(key, result);
+        }
+
+        prune(m_prune_step);
+        return result;
+    }
+
+    /**
+     * @brief Inserts or replaces the value of key, in the front of the
+     * strong segment. Empty value removes the entry.
+     *
+     * @param key
+     * @param value
+     */
+    void put(const K& key, rc_type value)
+    {
+        insert(key, std::move(value));
+        prune(m_prune_step);
+    }
+
+    /**
+     * @brief Removes the entry of key.
+     *
+     * @param key
+     * @return true if the entry was found
+     * @return false otherwise
+     */
+    bool erase(const K& key)
+    {
+        auto it = m_entries.find(key);
+
+        if (it == m_entries.end())
+        {
+            return false;
+        }
+
+        erase_entry(it);
+        return true;
+    }
+
+    /**
+     * @brief Checks up to count weak entries, removing the expired ones.
+     *
+     * @param count
+     */
+    void prune(std::size_t count)
+    {
+        for (; count != 0 && !m_weak.empty(); --count)
+        {
+            auto node = m_weak.front();
+
+            if (node->second.weak.expired())
+            {
+                ++m_stats.pruned;
+                erase_entry(m_entries.find(node->first));
+                continue;
+            }
+
+            // Checked again once the other entries have been visited.
+            m_weak.splice(m_weak.end(), m_weak, m_weak.begin());
+        }
+    }
+
+    /**
+     * @brief Removes all the entries.
+     *
+     */
+    void clear() noexcept
+    {
+        m_strong.clear();
+        m_weak.clear();
+        m_entries.clear();
+    }
+
+    /**
+     * @brief Returns the number of entries, including the expired ones not
+     * pruned yet.
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * @brief Returns the number of entries kept alive by the cache.
+     *
+     * @return std::size_t
+     */
+    std::size_t strong_size() const noexcept
+    {
+        return m_strong.size();
+    }
+
+    /**
+     * @brief Returns the maximum number of entries kept alive by the cache.
+     *
+     * @return std::size_t
+     */
+    std::size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    /**
+     * @brief Returns the lookup and eviction counters.
+     *
+     * @return const stats_type&
+     */
+    const stats_type& stats() const noexcept
+    {
+        return m_stats;
+    }
+
+private:
+    struct entry;
+
+    using map_type  = std::unordered_map<K, entry, Hash, Eq>;
+    using node_type = typename map_type::value_type;
+    using list_type = std::list<node_type*>;
+    using list_iter = typename list_type::iterator;
+    using map_iter  = typename map_type::iterator;
+
+    struct entry
+    {
+        rc_type   strong;
+        weak_type weak;
+        list_iter position;
+    };
+
+    rc_type lookup(const K& key)
+    {
+        auto it = m_entries.find(key);
+
+        if (it == m_entries.end())
+        {
+            ++m_stats.misses;
+            return rc_type{};
+        }
+
+        auto& value = it->second;
+
+        if (value.strong)
+        {
+            ++m_stats.hits;
+            m_strong.splice(m_strong.begin(), m_strong, value.position);
+            return value.strong;
+        }
+
+        auto locked = value.weak.lock();
+
+        if (!locked)
+        {
+            ++m_stats.misses;
+            erase_entry(it);
+            return rc_type{};
+        }
+
+        ++m_stats.resurrections;
+        value.strong = locked;
+        m_strong.splice(m_strong.begin(), m_weak, value.position);
+        evict();
+        return locked;
+    }
+
+    void insert(const K& key, rc_type value)
+    {
+        if (!value)
+        {
+            erase(key);
+            return;
+        }
+
+        auto it = m_entries.find(key);
+
+        if (it == m_entries.end())
+        {
+            it = m_entries.emplace(key, entry{}).first;
+
+            try
+            {
+                m_strong.push_front(&*it);
+            }
+            catch (...)
+            {
+                m_entries.erase(it);
+                throw;
+            }
+        }
+        else if (it->second.strong)
+        {
+            m_strong.splice(m_strong.begin(), m_strong, it->second.position);
+        }
+        else
+        {
+            m_strong.splice(m_strong.begin(), m_weak, it->second.position);
+        }
+
+        it->second.weak     = value;
+        it->second.strong   = std::move(value);
+        it->second.position = m_strong.begin();
+        evict();
+    }
+
+    // Demotes the least recently used entries over the capacity.
+    void evict() noexcept
+    {
+        while (m_strong.size() > m_capacity)
+        {
+            auto node = m_strong.back();
+            m_weak.splice(m_weak.end(), m_strong, std::prev(m_strong.end()));
+            node->second.strong.reset();
+            ++m_stats.evictions;
+        }
+    }
+
+    void erase_entry(map_iter it) noexcept
+    {
+        auto& value = it->second;
+
+        if (value.strong)
+        {
+            m_strong.erase(value.position);
+        }
+        else
+        {
+            m_weak.erase(value.position);
+        }
+
+        m_entries.erase(it);
+    }
+
+    std::size_t m_capacity;
+    std::size_t m_prune_step;
+    map_type    m_entries;
+    list_type   m_strong;
+    list_type   m_weak;
+    stats_type  m_stats;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
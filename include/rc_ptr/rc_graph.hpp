@@ -0,0 +1,397 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_GRAPH_HPP
+#define RC_GRAPH_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rc_ptr/rc_group.hpp"
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+class rc_graph_writer;
+class rc_graph_reader;
+
+/**
+ * @brief rc_graph_traits class template describes how the objects of type T
+ * are written by rc_graph_writer and read by rc_graph_reader. It must be
+ * specialized for each type of the nodes of the graph:
+ *
+ *     template<>
+ *     struct rc_graph_traits<node>
+ *     {
+ *         static void save(rc_graph_writer& out, const node& value);
+ *         static node load(rc_graph_reader& in);
+ *     };
+ *
+ * load reads the fields in the order save wrote them and returns the object,
+ * which is then moved into its fused allocation.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct rc_graph_traits;
+
+namespace detail
+{
+// Unique address for each node type, checked when a node is referenced again.
+template<typename T>
+const void* graph_type_id() noexcept
+{
+    static const char id = 0;
+    return &id;
+}
+
+struct graph_node_key
+{
+    const control_block_base* block;
+    const void*               object;
+
+    bool operator==(const graph_node_key& other) const noexcept
+    {
+        return block == other.block && object == other.object;
+    }
+};
+
+struct graph_node_key_hash
+{
+    std::size_t operator()(const graph_node_key& key) const noexcept
+    {
+        const auto block = std::hash<const void*>{}(key.block);
+        return block ^ (std::hash<const void*>{}(key.object) + 0x9e3779b9 +
+                        (block << 6) + (block >> 2));
+    }
+};
+
+// Tags of the references: null, the node follows, or the id of a node
+// already written, offset by graph_first_id.
+constexpr std::size_t graph_null_tag = 0;
+constexpr std::size_t graph_node_tag = 1;
+constexpr std::size_t graph_first_id = 2;
+} // namespace detail
+
+/**
+ * @brief rc_graph_writer class writes the graphs of rc_ptr objects in a
+ * compact binary format, each node once. Nodes are identified by their
+ * control block and the stored pointer, the following references to a node
+ * are written as its id.
+ *
+ * A node is written in place of its first reference, after the nodes it
+ * refers to, so the nesting of save calls follows the depth of the graph.
+ * The graph must not have cycles of rc_ptr references, write_rc throws on
+ * reaching a node being written.
+ *
+ */
+class rc_graph_writer
+{
+public:
+    /**
+     * @brief Creates the writer appending to the buffer of out.
+     *
+     * @param out
+     */
+    explicit rc_graph_writer(std::ostream& out) : m_out{ *out.rdbuf() } { }
+
+    rc_graph_writer(const rc_graph_writer&) = delete;
+    rc_graph_writer& operator=(const rc_graph_writer&) = delete;
+
+    /**
+     * @brief Writes the bytes of the trivially copyable value.
+     *
+     * @tparam T
+     * @param value
+     */
+    template<typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "T must be trivially copyable.");
+        write_bytes(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Writes the size in 1 to 10 bytes, 7 bits per byte.
+     *
+     * @param size
+     */
+    void write_size(std::size_t size)
+    {
+        char        bytes[10];
+        std::size_t count = 0;
+
+        while (size >= 0x80)
+        {
+            bytes[count++] = static_cast<char>(size | 0x80);
+            size >>= 7;
+        }
+        bytes[count++] = static_cast<char>(size);
+
+        write_bytes(bytes, count);
+    }
+
+    void write_bytes(const void* bytes, std::size_t count)
+    {
+        const auto written =
+            m_out.sputn(static_cast<const char*>(bytes),
+                        static_cast<std::streamsize>(count));
+        if (written != static_cast<std::streamsize>(count))
+        {
+            throw std::ios_base::failure("rc_graph_writer: write failed.");
+        }
+    }
+
+    /**
+     * @brief Writes the reference to the node. The node is written with
+     * rc_graph_traits<T>::save on its first reference only.
+     *
+     * @tparam T
+     * @param ptr
+     * @throws std::ios_base::failure when ptr refers to a node being written,
+     * i.e. the graph has a cycle
+     */
+    template<typename T>
+    void write_rc(const rc_ptr<T>& ptr)
+    {
+        static_assert(!std::is_array_v<T>, "T must not be an array.");
+
+        if (!ptr)
+        {
+            write_size(detail::graph_null_tag);
+            return;
+        }
+
+        const detail::graph_node_key key{
+            detail::rc_ptr_access::get_control_block(ptr),
+            ptr.get()
+        };
+
+        const auto [it, inserted] = m_ids.try_emplace(key, in_progress);
+        if (!inserted)
+        {
+            if (it->second == in_progress)
+            {
+                throw std::ios_base::failure(
+                    "rc_graph_writer: cycle of rc_ptr references.");
+            }
+
+            write_size(detail::graph_first_id + it->second);
+            return;
+        }
+
+        write_size(detail::graph_node_tag);
+        rc_graph_traits<T>::save(*this, *ptr);
+
+        // The iterator may be invalidated by the nodes written by save.
+        m_ids[key] = m_node_count++;
+    }
+
+    /**
+     * @brief Returns the number of nodes written.
+     *
+     * @return std::size_t
+     */
+    std::size_t node_count() const noexcept
+    {
+        return m_node_count;
+    }
+
+private:
+    using id_map = std::unordered_map<detail::graph_node_key,
+                                      std::size_t,
+                                      detail::graph_node_key_hash>;
+
+    static constexpr std::size_t in_progress = ~std::size_t{ 0 };
+
+    std::streambuf& m_out;
+    id_map          m_ids;
+    std::size_t     m_node_count = 0;
+};
+
+/**
+ * @brief rc_graph_reader class reads the graphs written by rc_graph_writer,
+ * restoring the sharing of the nodes. Each node is created by make_rc, or in
+ * the rc_group given to use_arena for its type.
+ *
+ * The reader keeps all the nodes read alive until it is destroyed, so the
+ * references to them read later stay valid.
+ *
+ */
+class rc_graph_reader
+{
+public:
+    /**
+     * @brief Creates the reader consuming the buffer of in.
+     *
+     * @param in
+     */
+    explicit rc_graph_reader(std::istream& in) : m_in{ *in.rdbuf() } { }
+
+    rc_graph_reader(const rc_graph_reader&) = delete;
+    rc_graph_reader& operator=(const rc_graph_reader&) = delete;
+
+    ~rc_graph_reader()
+    {
+        for (const auto& node : m_nodes)
+        {
+            node.block->release_ref();
+        }
+    }
+
+    /**
+     * @brief Creates the nodes of type T in the group instead of separate
+     * allocations. All the nodes share the reference count of the group, so
+     * they must not hold rc_ptr to other nodes of the group, which would keep
+     * it alive forever. The arena suits the leaf types of the graph.
+     *
+     * @tparam T
+     * @param group Must outlive the reader
+     */
+    template<typename T>
+    void use_arena(rc_group<T>& group)
+    {
+        m_arenas[detail::graph_type_id<T>()] = &group;
+    }
+
+    /**
+     * @brief Reads the value written by rc_graph_writer::write.
+     *
+     * @tparam T
+     * @return T
+     */
+    template<typename T>
+    T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "T must be trivially copyable.");
+        T value;
+        read_bytes(&value, sizeof(T));
+        return value;
+    }
+
+    std::size_t read_size()
+    {
+        std::size_t size  = 0;
+        unsigned    shift = 0;
+
+        for (;;)
+        {
+            const auto byte = m_in.sbumpc();
+            if (byte == std::streambuf::traits_type::eof() || shift > 63)
+            {
+                throw std::ios_base::failure("rc_graph_reader: bad size.");
+            }
+
+            size |= static_cast<std::size_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return size;
+            }
+            shift += 7;
+        }
+    }
+
+    void read_bytes(void* bytes, std::size_t count)
+    {
+        const auto read = m_in.sgetn(static_cast<char*>(bytes),
+                                     static_cast<std::streamsize>(count));
+        if (read != static_cast<std::streamsize>(count))
+        {
+            throw std::ios_base::failure("rc_graph_reader: unexpected end.");
+        }
+    }
+
+    /**
+     * @brief Reads the reference written by rc_graph_writer::write_rc.
+     *
+     * @tparam T
+     * @return rc_ptr<T>
+     */
+    template<typename T>
+    rc_ptr<T> read_rc()
+    {
+        using block_type = detail::
+            control_block<T, std::default_delete<T>, std::allocator<T>>;
+
+        const auto tag = read_size();
+        if (tag == detail::graph_null_tag)
+        {
+            return rc_ptr<T>{};
+        }
+
+        if (tag != detail::graph_node_tag)
+        {
+            const auto id = tag - detail::graph_first_id;
+            if (id >= m_nodes.size() ||
+                m_nodes[id].type != detail::graph_type_id<T>())
+            {
+                throw std::ios_base::failure("rc_graph_reader: bad node.");
+            }
+
+            return detail::rc_ptr_access::share(
+                static_cast<T*>(m_nodes[id].object),
+                static_cast<block_type*>(m_nodes[id].block));
+        }
+
+        auto node = create(rc_graph_traits<T>::load(*this));
+
+        auto block = detail::rc_ptr_access::get_control_block(node);
+        m_nodes.push_back({ block, node.get(), detail::graph_type_id<T>() });
+        block->increase_ref_count();
+
+        return node;
+    }
+
+    /**
+     * @brief Returns the number of nodes read.
+     *
+     * @return std::size_t
+     */
+    std::size_t node_count() const noexcept
+    {
+        return m_nodes.size();
+    }
+
+private:
+    struct node_entry
+    {
+        detail::control_block_base* block;
+        void*                       object;
+        const void*                 type;
+    };
+
+    template<typename T>
+    rc_ptr<T> create(T&& value)
+    {
+        const auto arena = m_arenas.find(detail::graph_type_id<T>());
+        if (arena == m_arenas.end())
+        {
+            return make_rc<T>(std::move(value));
+        }
+
+        auto group = static_cast<rc_group<T>*>(arena->second);
+        return group->share(group->emplace(std::move(value)));
+    }
+
+    std::streambuf&                        m_in;
+    std::vector<node_entry>                m_nodes;
+    std::unordered_map<const void*, void*> m_arenas;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
@@ -0,0 +1,340 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_GROUP_HPP
+#define RC_GROUP_HPP
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+namespace detail
+{
+/**
+ * @brief Control block owning the arena of objects of type T. The objects are
+ * stored in chunks and destroyed together when the reference count of the
+ * group reaches zero.
+ *
+ * @tparam T
+ * @tparam Alloc
+ */
+template<typename T, typename Alloc>
+class group_control_block :
+    public control_block<T, std::default_delete<T>, Alloc>
+{
+public:
+    using base_type = control_block<T, std::default_delete<T>, Alloc>;
+
+    group_control_block(std::size_t chunk_size, const Alloc& allocator) :
+        base_type{ nullptr,
+                   std::default_delete<T>{},
+                   allocator,
+                   &group_control_block::manage },
+        m_chunk_size{ chunk_size },
+        m_size{ 0 },
+        m_head{ nullptr }
+    {
+        assert(m_chunk_size);
+
+        // Throws std::bad_array_new_length for the chunk sizes overflowing
+        // std::size_t, before any chunk is allocated.
+        layout_type::units_for(m_chunk_size);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    // Checks whether object is one of the constructed objects of the chunks.
+    bool contains(const T* object) const noexcept
+    {
+        const auto less = std::less<const T*>{};
+
+        for (auto chunk = m_head; chunk; chunk = chunk->next)
+        {
+            const T* first = layout_type::object(chunk);
+            if (!less(object, first) && less(object, first + chunk->size))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template<typename... ArgsT>
+    T* emplace(ArgsT&&... args)
+    {
+        if (!m_head || m_head->size == m_head->capacity)
+        {
+            allocate_chunk();
+        }
+
+        T* object = layout_type::object(m_head) + m_head->size;
+        construct_object(object, std::forward<ArgsT>(args)...);
+        ++m_head->size;
+        ++m_size;
+        return object;
+    }
+
+private:
+    struct chunk
+    {
+        chunk*      next;
+        std::size_t capacity;
+        std::size_t size;
+    };
+
+    using layout_type = inplace_layout<chunk, T>;
+    using unit_type   = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    using block_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<group_control_block>;
+    using block_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<group_control_block>;
+
+    void allocate_chunk()
+    {
+        auto unit_allocator = unit_allocator_type{ this->get_allocator() };
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator,
+                                                 layout_type::units(
+                                                     m_chunk_size));
+
+        assert(mem);
+        m_head = ::new (static_cast<void*>(mem))
+            chunk{ m_head, m_chunk_size, 0 };
+    }
+
+    void release_chunks() noexcept
+    {
+        auto unit_allocator = unit_allocator_type{ this->get_allocator() };
+
+        while (m_head)
+        {
+            auto next = m_head->next;
+            std::destroy_n(layout_type::object(m_head), m_head->size);
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(m_head),
+                layout_type::units(m_head->capacity));
+            m_head = next;
+        }
+
+        m_size = 0;
+    }
+
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
+    {
+        auto block = static_cast<group_control_block*>(base);
+
+        switch (operation)
+        {
+        case block_operation::dispose:
+            block->release_chunks();
+            break;
+        case block_operation::destroy:
+        {
+            auto block_allocator =
+                block_allocator_type{ block->get_allocator() };
+            block_allocator_traits_type::destroy(block_allocator, block);
+            block_allocator_traits_type::deallocate(block_allocator, block, 1);
+            break;
+        }
+        }
+    }
+
+    std::size_t m_chunk_size;
+    std::size_t m_size;
+    chunk*      m_head;
+};
+} // namespace detail
+
+/**
+ * @brief rc_group class template allocates objects of type T from an arena
+ * owned by a single reference count. The objects of the group may refer to
+ * each other with raw pointers or rc_borrow objects, without any reference
+ * counting. rc_ptr objects handed out by share() alias the count of the
+ * whole group.
+ *
+ * All the objects are destroyed and the arena is released when both the
+ * rc_group and the last rc_ptr obtained from it are gone.
+ *
+ * @tparam T
+ * @tparam Alloc Type of the allocator used for the arena and the control
+ * block. Default is std::allocator<T>.
+ */
+template<typename T, typename Alloc = std::allocator<T>>
+class rc_group
+{
+public:
+    using value_type     = T;
+    using pointer        = T*;
+    using allocator_type = Alloc;
+    using rc_type        = rc_ptr<T, std::default_delete<T>, allocator_type>;
+
+    /**
+     * @brief Constructs an empty group.
+     *
+     * @param chunk_size Number of objects allocated at once
+     * @param allocator
+     * @throws std::bad_array_new_length if the size of a chunk overflows
+     * std::size_t
+     */
+    explicit rc_group(std::size_t           chunk_size = 64,
+                      const allocator_type& allocator  = allocator_type{}) :
+        m_control_block{ nullptr }
+    {
+        auto block_allocator = block_allocator_type{ allocator };
+        auto mem = block_allocator_traits_type::allocate(block_allocator, 1);
+
+        assert(mem);
+
+        try
+        {
+            block_allocator_traits_type::construct(block_allocator,
+                                                   mem,
+                                                   chunk_size,
+                                                   allocator);
+        }
+        catch (...)
+        {
+            block_allocator_traits_type::deallocate(block_allocator, mem, 1);
+            throw;
+        }
+
+        m_control_block = mem;
+        m_control_block->increase_ref_count();
+    }
+
+    rc_group(const rc_group&) = delete;
+
+    /**
+     * @brief Move constructor.
+     *
+     * @param other
+     */
+    rc_group(rc_group&& other) noexcept :
+        m_control_block{ other.m_control_block }
+    {
+        other.m_control_block = nullptr;
+    }
+
+    rc_group& operator=(const rc_group&) = delete;
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * @param other
+     * @return rc_group&
+     */
+    rc_group& operator=(rc_group&& other) noexcept
+    {
+        std::swap(m_control_block, other.m_control_block);
+        return *this;
+    }
+
+    /**
+     * @brief Releases the reference of the group. The objects stay alive as
+     * long as any rc_ptr obtained by share() does.
+     *
+     */
+    ~rc_group()
+    {
+        if (!m_control_block)
+        {
+            return;
+        }
+
+        m_control_block->release_ref();
+    }
+
+    /**
+     * @brief Creates the object in the arena, forwarding the arguments to the
+     * constructor of type T. The returned pointer stays valid as long as the
+     * group is alive.
+     *
+     * @tparam ArgsT
+     * @param args
+     * @return pointer
+     */
+    template<typename... ArgsT>
+    pointer emplace(ArgsT&&... args)
+    {
+        static_assert(
+            !std::is_base_of_v<detail::enable_inplace_rc_from_this_base, T>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "by make_rc or allocate_rc.");
+
+        assert(m_control_block);
+        return m_control_block->emplace(std::forward<ArgsT>(args)...);
+    }
+
+    /**
+     * @brief Creates rc_ptr to the object of the group. The rc_ptr shares the
+     * ownership of the whole group.
+     *
+     * object must have been created by emplace() of this group, otherwise the
+     * rc_ptr keeps the wrong group alive. Debug builds assert on it, walking
+     * the chunks of the group.
+     *
+     * @param object
+     * @return rc_type
+     */
+    rc_type share(pointer object) const noexcept
+    {
+        assert(m_control_block);
+        assert(object);
+        assert(m_control_block->contains(object) &&
+               "Object does not belong to the group.");
+        return detail::rc_ptr_access::share(
+            object,
+            static_cast<typename control_block_type::base_type*>(
+                m_control_block));
+    }
+
+    /**
+     * @brief Returns the number of objects in the group.
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const noexcept
+    {
+        return m_control_block ? m_control_block->size() : 0;
+    }
+
+    /**
+     * @brief Returns the number of owners of the group, including this.
+     *
+     * @return std::size_t
+     */
+    std::size_t use_count() const noexcept
+    {
+        return m_control_block ? m_control_block->get_ref_count() : 0;
+    }
+
+private:
+    using control_block_type = detail::group_control_block<T, allocator_type>;
+
+    using block_allocator_type = typename std::allocator_traits<
+        allocator_type>::template rebind_alloc<control_block_type>;
+    using block_allocator_traits_type = typename std::allocator_traits<
+        allocator_type>::template rebind_traits<control_block_type>;
+
+    control_block_type* m_control_block;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
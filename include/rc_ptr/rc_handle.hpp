@@ -0,0 +1,479 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_HANDLE_HPP
+#define RC_HANDLE_HPP
+
+#include <cstdint>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+template<typename T, typename Alloc>
+class rc_slot_map;
+
+/**
+ * @brief rc_handle class template is a weak reference to the object created
+ * by rc_slot_map. Unlike weak_rc_ptr it does not keep the control block
+ * alive, so the memory of the object is released together with the last
+ * rc_ptr. The handle consists of the slot index and its generation, and is
+ * resolved by rc_slot_map::lock in constant time.
+ *
+ * @tparam T
+ */
+template<typename T>
+class rc_handle
+{
+public:
+    using index_type = std::uint32_t;
+
+    // Index of the default constructed handles, never resolved.
+    static constexpr index_type npos = std::numeric_limits<index_type>::max();
+
+    /**
+     * @brief Constructs the handle referring to no object.
+     *
+     */
+    constexpr rc_handle() noexcept : m_index{ npos }, m_generation{ 0 }
+    {
+    }
+
+    constexpr rc_handle(index_type index, index_type generation) noexcept :
+        m_index{ index },
+        m_generation{ generation }
+    {
+    }
+
+    constexpr index_type index() const noexcept
+    {
+        return m_index;
+    }
+
+    constexpr index_type generation() const noexcept
+    {
+        return m_generation;
+    }
+
+    /**
+     * @brief Checks if the handle was obtained from rc_slot_map. The object
+     * may be gone anyway.
+     *
+     */
+    explicit constexpr operator bool() const noexcept
+    {
+        return (m_index != npos);
+    }
+
+    friend constexpr bool operator==(rc_handle left, rc_handle right) noexcept
+    {
+        return (left.m_index == right.m_index &&
+                left.m_generation == right.m_generation);
+    }
+
+    friend constexpr bool operator!=(rc_handle left, rc_handle right) noexcept
+    {
+        return !(left == right);
+    }
+
+private:
+    index_type m_index;
+    index_type m_generation;
+};
+
+namespace detail
+{
+/**
+ * @brief Control block of the objects created by rc_slot_map. The object
+ * follows the block in the same allocation. The slot of the object is
+ * released as soon as the reference count reaches zero.
+ *
+ * @tparam T
+ * @tparam Alloc
+ */
+template<typename T, typename Alloc>
+class slot_control_block :
+    public control_block<T, std::default_delete<T>, Alloc>
+{
+public:
+    using base_type  = control_block<T, std::default_delete<T>, Alloc>;
+    using table_type = rc_slot_map<T, Alloc>;
+    using index_type = typename rc_handle<T>::index_type;
+
+    slot_control_block(T*          ptr,
+                       const Alloc& allocator,
+                       table_type*  table,
+                       index_type   index) noexcept :
+        base_type{ ptr,
+                   std::default_delete<T>{},
+                   allocator,
+                   &slot_control_block::manage },
+        m_table{ table },
+        m_index{ index }
+    {
+    }
+
+    table_type* get_table() const noexcept
+    {
+        return m_table;
+    }
+
+    index_type get_index() const noexcept
+    {
+        return m_index;
+    }
+
+    void detach() noexcept
+    {
+        m_table = nullptr;
+    }
+
+    using layout_type = inplace_layout<slot_control_block, T>;
+    using unit_type   = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
+    {
+        auto block = static_cast<slot_control_block*>(base);
+
+        switch (operation)
+        {
+        case block_operation::dispose:
+            // The handles are invalidated before the object is destroyed.
+            if (block->m_table)
+            {
+                block->m_table->release(block->m_index);
+            }
+
+            std::destroy_at(block->get_pointer());
+            break;
+        case block_operation::destroy:
+        {
+            auto unit_allocator = unit_allocator_type{ block->get_allocator() };
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(block),
+                layout_type::units(1));
+            break;
+        }
+        }
+    }
+
+private:
+    table_type* m_table;
+    index_type  m_index;
+};
+} // namespace detail
+
+/**
+ * @brief rc_slot_map class template creates objects of type T owned by
+ * rc_ptr and hands out rc_handle objects referring to them. The slots keep
+ * no reference to the objects, only the pointers to their control blocks and
+ * generations stored in separate, contiguous arrays. The slot is freed and
+ * its generation bumped when the last rc_ptr to the object is gone, which
+ * invalidates all the handles.
+ *
+ * The generation is 32 bits wide, a slot reused 2^32 times may resolve a
+ * stale handle again.
+ *
+ * The map may be destroyed before the objects, which stay owned by their
+ * rc_ptr objects. The map cannot be copied nor moved, as the objects refer
+ * to it.
+ *
+ * @tparam T
+ * @tparam Alloc Type of the allocator used for the objects and the slots.
+ * Default is std::allocator<T>.
+ */
+template<typename T, typename Alloc = std::allocator<T>>
+class rc_slot_map
+{
+public:
+    using value_type     = T;
+    using allocator_type = Alloc;
+    using handle_type    = rc_handle<T>;
+    using rc_type        = rc_ptr<T, std::default_delete<T>, allocator_type>;
+
+    explicit rc_slot_map(const allocator_type& allocator = allocator_type{}) :
+        m_allocator{ allocator },
+        m_generations{ generation_allocator_type{ allocator } },
+        m_blocks{ block_pointer_allocator_type{ allocator } },
+        m_free{ generation_allocator_type{ allocator } },
+        m_size{ 0 }
+    {
+    }
+
+    rc_slot_map(const rc_slot_map&) = delete;
+
+    rc_slot_map& operator=(const rc_slot_map&) = delete;
+
+    /**
+     * @brief Detaches the living objects. Their handles cannot be resolved
+     * anymore.
+     *
+     */
+    ~rc_slot_map()
+    {
+        for (auto block : m_blocks)
+        {
+            if (block)
+            {
+                block->detach();
+            }
+        }
+    }
+
+    /**
+     * @brief Creates the object in a new slot, forwarding the arguments to
+     * the constructor of type T.
+     *
+     * @tparam ArgsT
+     * @param args
+     * @return rc_type
+     */
+    template<typename... ArgsT>
+    rc_type emplace(ArgsT&&... args)
+    {
+        static_assert(
+            !std::is_base_of_v<detail::enable_inplace_rc_from_this_base, T>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "by make_rc or allocate_rc.");
+
+        auto unit_allocator = unit_allocator_type{ m_allocator };
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator,
+                                                 layout_type::units(1));
+
+        assert(mem);
+        index_type index;
+
+        try
+        {
+            index = acquire();
+        }
+        catch (...)
+        {
+            unit_allocator_traits_type::deallocate(unit_allocator,
+                                                   mem,
+                                                   layout_type::units(1));
+            throw;
+        }
+
+        T* object = layout_type::object(mem);
+        auto block = ::new (static_cast<void*>(mem))
+            block_type{ object, m_allocator, this, index };
+
+        try
+        {
+            detail::construct_object(object, std::forward<ArgsT>(args)...);
+        }
+        catch (...)
+        {
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(unit_allocator,
+                                                   mem,
+                                                   layout_type::units(1));
+            m_free.push_back(index);
+            throw;
+        }
+
+        m_blocks[index] = block;
+        ++m_size;
+        return detail::rc_ptr_access::share(
+            object,
+            static_cast<typename block_type::base_type*>(block));
+    }
+
+    /**
+     * @brief Returns the handle of the object created by this map.
+     *
+     * @param ptr
+     * @return handle_type
+     */
+    handle_type handle(const rc_type& ptr) const noexcept
+    {
+        assert(ptr);
+
+        auto base = detail::rc_ptr_access::get_control_block(ptr);
+
+        assert(base->get_manager() == &block_type::manage &&
+               "rc_ptr was not created by rc_slot_map.");
+
+        auto block = static_cast<const block_type*>(base);
+
+        assert(block->get_table() == this &&
+               "rc_ptr was not created by this rc_slot_map.");
+
+        const auto index = block->get_index();
+        return handle_type{ index, m_generations[index] };
+    }
+
+    /**
+     * @brief Resolves the handle. Returns empty rc_ptr if the object is gone.
+     *
+     * @param handle
+     * @return rc_type
+     */
+    rc_type lock(handle_type handle) const noexcept
+    {
+        auto block = find(handle);
+
+        if (!block)
+        {
+            return rc_type{};
+        }
+
+        return detail::rc_ptr_access::share(
+            block->get_pointer(),
+            static_cast<typename block_type::base_type*>(block));
+    }
+
+    /**
+     * @brief Checks if the object referred to by handle is alive.
+     *
+     * @param handle
+     * @return true
+     * @return false
+     */
+    bool contains(handle_type handle) const noexcept
+    {
+        return (find(handle) != nullptr);
+    }
+
+    /**
+     * @brief Calls func for every living object, in the order of the slots.
+     * func may emplace objects into the map or release the objects. The
+     * slots are visited by index and reread on every step, so the objects
+     * emplaced into the slots not visited yet are visited as well.
+     *
+     * @tparam Func
+     * @param func
+     */
+    template<typename Func>
+    void for_each(Func func) const
+    {
+        for (std::size_t i = 0; i < m_blocks.size(); ++i)
+        {
+            if (auto block = m_blocks[i])
+            {
+                func(*block->get_pointer());
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of living objects.
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Returns the number of slots, including free ones.
+     *
+     * @return std::size_t
+     */
+    std::size_t slot_count() const noexcept
+    {
+        return m_blocks.size();
+    }
+
+    /**
+     * @brief Returns the allocator.
+     *
+     * @return allocator_type
+     */
+    allocator_type get_allocator() const noexcept
+    {
+        return m_allocator;
+    }
+
+private:
+    using block_type  = detail::slot_control_block<T, allocator_type>;
+    using index_type  = typename handle_type::index_type;
+    using layout_type = typename block_type::layout_type;
+
+    using unit_allocator_type = typename block_type::unit_allocator_type;
+    using unit_allocator_traits_type =
+        typename block_type::unit_allocator_traits_type;
+
+    using generation_allocator_type = typename std::allocator_traits<
+        allocator_type>::template rebind_alloc<index_type>;
+    using block_pointer_allocator_type = typename std::allocator_traits<
+        allocator_type>::template rebind_alloc<block_type*>;
+
+    friend class detail::slot_control_block<T, allocator_type>;
+
+    index_type acquire()
+    {
+        if (!m_free.empty())
+        {
+            const auto index = m_free.back();
+            m_free.pop_back();
+            return index;
+        }
+
+        assert(m_blocks.size() < handle_type::npos);
+
+        // The free list never outgrows the slots. Reserving it along with them
+        // keeps release non-throwing.
+        const auto count = m_blocks.size() + 1;
+
+        if (m_blocks.capacity() < count || m_generations.capacity() < count ||
+            m_free.capacity() < count)
+        {
+            const auto capacity = std::max<std::size_t>(16, 2 * count);
+            m_blocks.reserve(capacity);
+            m_generations.reserve(capacity);
+            m_free.reserve(capacity);
+        }
+
+        m_blocks.push_back(nullptr);
+        m_generations.push_back(0);
+        return static_cast<index_type>(count - 1);
+    }
+
+    // Called by the block when the reference count reaches zero.
+    void release(index_type index) noexcept
+    {
+        m_blocks[index] = nullptr;
+        ++m_generations[index];
+        --m_size;
+        m_free.push_back(index);
+    }
+
+    block_type* find(handle_type handle) const noexcept
+    {
+        const auto index = handle.index();
+
+        if (index >= m_blocks.size() ||
+            m_generations[index] != handle.generation())
+        {
+            return nullptr;
+        }
+
+        return m_blocks[index];
+    }
+
+    allocator_type                                         m_allocator;
+    std::vector<index_type, generation_allocator_type>     m_generations;
+    std::vector<block_type*, block_pointer_allocator_type> m_blocks;
+    std::vector<index_type, generation_allocator_type>     m_free;
+    std::size_t                                            m_size;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
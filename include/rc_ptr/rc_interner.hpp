@@ -0,0 +1,339 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_INTERNER_HPP
+#define RC_INTERNER_HPP
+
+#include <functional>
+#include <unordered_map>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+template<typename T, typename Hash, typename Eq, typename Alloc>
+class rc_interner;
+
+namespace detail
+{
+/**
+ * @brief Control block of the values interned by rc_interner. The value
+ * follows the block in the same allocation. The entry of the value is
+ * removed from the table as soon as the reference count reaches zero.
+ *
+ * @tparam T
+ * @tparam Table
+ * @tparam Alloc
+ */
+template<typename T, typename Table, typename Alloc>
+class intern_control_block :
+    public control_block<const T, std::default_delete<const T>, Alloc>
+{
+public:
+    using base_type =
+        control_block<const T, std::default_delete<const T>, Alloc>;
+
+    intern_control_block(const T*     ptr,
+                         const Alloc& allocator,
+                         Table*       table,
+                         std::size_t  hash) noexcept :
+        base_type{ ptr,
+                   std::default_delete<const T>{},
+                   allocator,
+                   &intern_control_block::manage },
+        m_table{ table },
+        m_hash{ hash }
+    {
+    }
+
+    std::size_t get_hash() const noexcept
+    {
+        return m_hash;
+    }
+
+    void detach() noexcept
+    {
+        m_table = nullptr;
+    }
+
+    using layout_type = inplace_layout<intern_control_block, T>;
+    using unit_type   = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
+    {
+        auto block = static_cast<intern_control_block*>(base);
+
+        switch (operation)
+        {
+        case block_operation::dispose:
+            // Removed first, so the expired value is never found.
+            if (block->m_table)
+            {
+                block->m_table->erase(block);
+            }
+
+            std::destroy_at(block->get_pointer());
+            break;
+        case block_operation::destroy:
+        {
+            auto unit_allocator = unit_allocator_type{ block->get_allocator() };
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(block),
+                layout_type::units(1));
+            break;
+        }
+        }
+    }
+
+private:
+    Table*      m_table;
+    std::size_t m_hash;
+};
+} // namespace detail
+
+/**
+ * @brief rc_interner class template deduplicates equal immutable values.
+ * intern() returns the rc_ptr to the living value equal to the argument, or
+ * creates a new one. The table does not own the values, an entry is removed
+ * when the last rc_ptr to its value is gone. Equal interned values are
+ * therefore stored at the same address and may be compared by pointer.
+ *
+ * The values may outlive the table. The table cannot be copied nor moved, as
+ * the values refer to it.
+ *
+ * @tparam T
+ * @tparam Hash Default is std::hash<T>.
+ * @tparam Eq Default is std::equal_to<T>.
+ * @tparam Alloc Type of the allocator used for the values and the table.
+ * Default is std::allocator<T>.
+ */
+template<typename T, typename Hash = std::hash<T>,
+         typename Eq = std::equal_to<T>, typename Alloc = std::allocator<T>>
+class rc_interner
+{
+public:
+    using value_type     = T;
+    using hasher         = Hash;
+    using key_equal      = Eq;
+    using allocator_type = Alloc;
+    using rc_type = rc_ptr<const T, std::default_delete<const T>, Alloc>;
+
+    explicit rc_interner(const Hash&           hash      = Hash{},
+                         const Eq&             equal     = Eq{},
+                         const allocator_type& allocator = allocator_type{}) :
+        m_hash{ hash },
+        m_equal{ equal },
+        m_allocator{ allocator },
+        m_entries{ entry_allocator_type{ allocator } }
+    {
+    }
+
+    rc_interner(const rc_interner&) = delete;
+
+    rc_interner& operator=(const rc_interner&) = delete;
+
+    /**
+     * @brief Detaches the living values.
+     *
+     */
+    ~rc_interner()
+    {
+        for (auto& entry : m_entries)
+        {
+            entry.second->detach();
+        }
+    }
+
+    /**
+     * @brief Returns the living value equal to value or interns its copy.
+     *
+     * @param value
+     * @return rc_type
+     */
+    rc_type intern(const T& value)
+    {
+        return intern_impl(value);
+    }
+
+    /**
+     * @brief Returns the living value equal to value or interns it, moving
+     * from value.
+     *
+     * @param value
+     * @return rc_type
+     */
+    rc_type intern(T&& value)
+    {
+        return intern_impl(std::move(value));
+    }
+
+    /**
+     * @brief Returns the living value equal to value, or empty rc_ptr.
+     *
+     * @param value
+     * @return rc_type
+     */
+    rc_type find(const T& value) const
+    {
+        auto block = find_block(value, m_hash(value));
+
+        if (!block)
+        {
+            return rc_type{};
+        }
+
+        return share(block);
+    }
+
+    /**
+     * @brief Returns the number of living values.
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * @brief Checks if there are no living values.
+     *
+     * @return true
+     * @return false
+     */
+    bool empty() const noexcept
+    {
+        return m_entries.empty();
+    }
+
+private:
+    using block_type =
+        detail::intern_control_block<T, rc_interner, allocator_type>;
+    using layout_type = typename block_type::layout_type;
+
+    using unit_allocator_type = typename block_type::unit_allocator_type;
+    using unit_allocator_traits_type =
+        typename block_type::unit_allocator_traits_type;
+
+    using entry_type = std::pair<const std::size_t, block_type*>;
+    using entry_allocator_type = typename std::allocator_traits<
+        allocator_type>::template rebind_alloc<entry_type>;
+
+    // Entries keyed by the hash of the value, which is computed once.
+    using table_type = std::unordered_multimap<std::size_t,
+                                               block_type*,
+                                               std::hash<std::size_t>,
+                                               std::equal_to<std::size_t>,
+                                               entry_allocator_type>;
+
+    friend class detail::intern_control_block<T, rc_interner, allocator_type>;
+
+    template<typename U>
+    rc_type intern_impl(U&& value)
+    {
+        static_assert(
+            !std::is_base_of_v<detail::enable_inplace_rc_from_this_base, T>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "by make_rc or allocate_rc.");
+
+        const auto hash = m_hash(value);
+
+        if (auto block = find_block(value, hash))
+        {
+            return share(block);
+        }
+
+        auto unit_allocator = unit_allocator_type{ m_allocator };
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator,
+                                                 layout_type::units(1));
+
+        assert(mem);
+        T*   object = layout_type::object(mem);
+        auto block  = ::new (static_cast<void*>(mem))
+            block_type{ object, m_allocator, this, hash };
+
+        try
+        {
+            ::new (detail::voidify(object)) T(std::forward<U>(value));
+
+            try
+            {
+                m_entries.emplace(hash, block);
+            }
+            catch (...)
+            {
+                std::destroy_at(object);
+                throw;
+            }
+        }
+        catch (...)
+        {
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(unit_allocator,
+                                                   mem,
+                                                   layout_type::units(1));
+            throw;
+        }
+
+        return share(block);
+    }
+
+    block_type* find_block(const T& value, std::size_t hash) const
+    {
+        auto range = m_entries.equal_range(hash);
+
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (m_equal(*it->second->get_pointer(), value))
+            {
+                return it->second;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static rc_type share(block_type* block) noexcept
+    {
+        return detail::rc_ptr_access::share(
+            block->get_pointer(),
+            static_cast<typename block_type::base_type*>(block));
+    }
+
+    // Called by the block when the reference count reaches zero.
+    void erase(block_type* block) noexcept
+    {
+        auto range = m_entries.equal_range(block->get_hash());
+
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == block)
+            {
+                m_entries.erase(it);
+                return;
+            }
+        }
+    }
+
+    Hash           m_hash;
+    Eq             m_equal;
+    allocator_type m_allocator;
+    table_type     m_entries;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
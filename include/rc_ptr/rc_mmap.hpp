@@ -0,0 +1,331 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_MMAP_HPP
+#define RC_MMAP_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <system_error>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+/**
+ * @brief Access pattern hints passed to madvise.
+ *
+ */
+enum class mmap_advice
+{
+    normal,
+    sequential,
+    random,
+    willneed,
+    dontneed,
+    hugepage
+};
+
+namespace detail
+{
+/**
+ * @brief Deleter of the mapped regions, unmaps size bytes.
+ *
+ */
+struct munmap_deleter
+{
+    std::size_t size = 0;
+
+    void operator()(const std::byte* ptr) const noexcept
+    {
+        ::munmap(const_cast<std::byte*>(ptr), size);
+    }
+};
+
+/**
+ * @brief Read-only file descriptor, closed on destruction.
+ *
+ */
+class mmap_file
+{
+public:
+    explicit mmap_file(const char* path) :
+        m_fd{ ::open(path, O_RDONLY | O_CLOEXEC) }
+    {
+        if (m_fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+
+        if (::fstat(m_fd, &m_stat) != 0)
+        {
+            const auto error = errno;
+            ::close(m_fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+    }
+
+    mmap_file(const mmap_file&) = delete;
+    mmap_file& operator=(const mmap_file&) = delete;
+
+    ~mmap_file()
+    {
+        ::close(m_fd);
+    }
+
+    int get() const noexcept
+    {
+        return m_fd;
+    }
+
+    const struct stat& status() const noexcept
+    {
+        return m_stat;
+    }
+
+private:
+    int         m_fd;
+    struct stat m_stat;
+};
+
+inline int madvise_flag(mmap_advice advice) noexcept
+{
+    switch (advice)
+    {
+    case mmap_advice::sequential:
+        return MADV_SEQUENTIAL;
+    case mmap_advice::random:
+        return MADV_RANDOM;
+    case mmap_advice::willneed:
+        return MADV_WILLNEED;
+    case mmap_advice::dontneed:
+        return MADV_DONTNEED;
+    case mmap_advice::hugepage:
+#if defined(MADV_HUGEPAGE)
+        return MADV_HUGEPAGE;
+#else
+        return -1;
+#endif
+    default:
+        return MADV_NORMAL;
+    }
+}
+} // namespace detail
+
+/**
+ * @brief rc_mmap class maps files into memory read-only. The mapping is
+ * owned by rc_ptr<const std::byte[]> with a deleter calling munmap, so it is
+ * unmapped as soon as the last region sharing it is destroyed. Sub-views
+ * are created with slice, which shares the ownership of the whole mapping.
+ *
+ * The file descriptor is closed before open returns, the mapping keeps the
+ * file contents accessible.
+ *
+ */
+class rc_mmap
+{
+public:
+    using region_type = rc_ptr<const std::byte[],
+                               detail::munmap_deleter,
+                               std::allocator<std::byte>>;
+    using weak_type   = region_type::weak_type;
+
+    /**
+     * @brief Maps the whole file at path. An empty file gives an empty
+     * region.
+     *
+     * @param path
+     * @param advice Applied to the whole mapping
+     * @return region_type
+     * @throws std::system_error when the file cannot be opened or mapped
+     */
+    static region_type open(const char* path,
+                            mmap_advice advice = mmap_advice::normal)
+    {
+        detail::mmap_file file{ path };
+        return map(file, path, advice);
+    }
+
+    /**
+     * @brief Passes the access pattern hint for the bytes of view to
+     * madvise. The range is extended to the page boundaries.
+     *
+     * @param view
+     * @param advice
+     * @return true when the hint was accepted
+     * @return false when the hint is not supported
+     */
+    static bool advise(const region_type& view, mmap_advice advice) noexcept
+    {
+        const auto flag = detail::madvise_flag(advice);
+        if (!view || flag < 0)
+        {
+            return !view;
+        }
+
+        const auto page  = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const auto first = reinterpret_cast<std::uintptr_t>(view.get());
+        const auto start = first & ~(page - 1);
+
+        return ::madvise(reinterpret_cast<void*>(start),
+                         first - start + view.size(),
+                         flag) == 0;
+    }
+
+private:
+    friend class rc_mmap_cache;
+
+    static region_type map(const detail::mmap_file& file,
+                           const char*              path,
+                           mmap_advice              advice)
+    {
+        const auto size = static_cast<std::size_t>(file.status().st_size);
+        if (!size)
+        {
+            return region_type{};
+        }
+
+        void* address =
+            ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file.get(), 0);
+        if (address == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+
+        // Unmapped by unique_ptr if the control block cannot be allocated.
+        std::unique_ptr<const std::byte[], detail::munmap_deleter> owner{
+            static_cast<const std::byte*>(address),
+            detail::munmap_deleter{ size }
+        };
+
+        auto region = detail::rc_ptr_access::with_extent(
+            region_type{ std::move(owner) },
+            size);
+
+        if (advice != mmap_advice::normal)
+        {
+            advise(region, advice);
+        }
+
+        return region;
+    }
+};
+
+/**
+ * @brief rc_mmap_cache class maps files like rc_mmap::open, but returns the
+ * mapping created earlier by the cache while any region of it is alive.
+ * Files are identified by the device and the inode, so different paths of
+ * the same file share the mapping. A file whose size changed is mapped
+ * again.
+ *
+ * The cache holds weak_rc_ptr objects only and never keeps a mapping alive.
+ * The entries of the unmapped files are replaced on the next open of the
+ * same file or removed by prune.
+ *
+ */
+class rc_mmap_cache
+{
+public:
+    using region_type = rc_mmap::region_type;
+    using weak_type   = rc_mmap::weak_type;
+    using size_type   = std::size_t;
+
+    /**
+     * @brief Returns the mapping of the file at path, mapping it if no
+     * region of the cached one is alive. advice is applied to new mappings
+     * only.
+     *
+     * @param path
+     * @param advice
+     * @return region_type
+     * @throws std::system_error when the file cannot be opened or mapped
+     */
+    region_type open(const char* path, mmap_advice advice = mmap_advice::normal)
+    {
+        detail::mmap_file file{ path };
+        const auto&       status = file.status();
+
+        auto& entry = m_entries[file_key{ status.st_dev, status.st_ino }];
+        if (entry.size == status.st_size)
+        {
+            if (auto region = entry.region.lock())
+            {
+                return region;
+            }
+        }
+
+        auto region  = rc_mmap::map(file, path, advice);
+        entry.region = region;
+        entry.size   = status.st_size;
+        return region;
+    }
+
+    /**
+     * @brief Removes the entries of the unmapped files.
+     *
+     */
+    void prune()
+    {
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            it = it->second.region.expired() ? m_entries.erase(it) : ++it;
+        }
+    }
+
+    /**
+     * @brief Returns the number of entries, including the unmapped ones not
+     * pruned yet.
+     *
+     * @return size_type
+     */
+    size_type size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+private:
+    struct file_key
+    {
+        dev_t device;
+        ino_t inode;
+
+        bool operator==(const file_key& other) const noexcept
+        {
+            return device == other.device && inode == other.inode;
+        }
+    };
+
+    struct file_key_hash
+    {
+        std::size_t operator()(const file_key& key) const noexcept
+        {
+            const auto device = std::hash<dev_t>{}(key.device);
+            return device ^ (std::hash<ino_t>{}(key.inode) + 0x9e3779b9 +
+                             (device << 6) + (device >> 2));
+        }
+    };
+
+    struct entry
+    {
+        weak_type region;
+        off_t     size = -1;
+    };
+
+    std::unordered_map<file_key, entry, file_key_hash> m_entries;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
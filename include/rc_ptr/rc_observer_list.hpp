@@ -0,0 +1,247 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_OBSERVER_LIST_HPP
+#define RC_OBSERVER_LIST_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+/**
+ * @brief rc_observer_list class template holds weak references to the
+ * subscribers of type T. The subscribers are not kept alive by the list and
+ * the expired ones are removed while iterating.
+ *
+ * The subscribers are stored in a copy-on-write vector. Subscribing and
+ * unsubscribing while the vector is iterated, or held by a snapshot, copies
+ * it, so the iteration in progress is never affected.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ */
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc = std::allocator<T>>
+class rc_observer_list
+{
+public:
+    using rc_type   = rc_ptr<T, Deleter, Alloc>;
+    using weak_type = weak_rc_ptr<T, Deleter, Alloc>;
+
+private:
+    using entries_type = std::vector<weak_type>;
+
+public:
+    /**
+     * @brief Immutable view of the subscribers at the time it was taken.
+     *
+     */
+    class snapshot
+    {
+    public:
+        /**
+         * @brief Calls func for every living subscriber. Each subscriber is
+         * locked for the duration of the call, so func may subscribe,
+         * unsubscribe and release any rc_ptr.
+         *
+         * @tparam Func
+         * @param func
+         */
+        template<typename Func>
+        void for_each(Func func) const
+        {
+            if (!m_entries)
+            {
+                return;
+            }
+
+            for (const auto& entry : *m_entries)
+            {
+                if (auto locked = entry.lock())
+                {
+                    func(*locked);
+                }
+            }
+        }
+
+        /**
+         * @brief Returns the number of entries, including the expired ones.
+         *
+         * @return std::size_t
+         */
+        std::size_t size() const noexcept
+        {
+            return m_entries ? m_entries->size() : 0;
+        }
+
+    private:
+        friend class rc_observer_list;
+
+        explicit snapshot(rc_ptr<entries_type> entries) noexcept :
+            m_entries{ std::move(entries) }
+        {
+        }
+
+        rc_ptr<entries_type> m_entries;
+    };
+
+    /**
+     * @brief Adds the subscriber.
+     *
+     * @param subscriber
+     */
+    void subscribe(const rc_type& subscriber)
+    {
+        assert(subscriber);
+        mutable_entries().emplace_back(subscriber);
+    }
+
+    /**
+     * @brief Removes the subscriber.
+     *
+     * @param subscriber
+     * @return true if the subscriber was found
+     * @return false otherwise
+     */
+    bool unsubscribe(const rc_type& subscriber)
+    {
+        if (!m_entries)
+        {
+            return false;
+        }
+
+        auto& entries = mutable_entries();
+        auto  it      = std::find_if(entries.begin(),
+                               entries.end(),
+                               [&subscriber](const weak_type& entry) {
+                                   return entry.owner_equal(subscriber);
+                               });
+
+        if (it == entries.end())
+        {
+            return false;
+        }
+
+        entries.erase(it);
+        return true;
+    }
+
+    /**
+     * @brief Calls func for every living subscriber, without modifying the
+     * reference counts of the subscribers. Expired entries are compacted
+     * away unless the vector is shared with a snapshot or an outer
+     * iteration.
+     *
+     * func may subscribe and unsubscribe, but must not release the last
+     * rc_ptr owning the subscriber it is called for. Use snapshot() when it
+     * may.
+     *
+     * @tparam Func
+     * @param func
+     */
+    template<typename Func>
+    void for_each(Func func)
+    {
+        if (!m_entries)
+        {
+            return;
+        }
+
+        // Keeps the vector alive when func modifies the list.
+        auto       entries = m_entries;
+        const bool compact = (entries.use_count() == 2);
+
+        auto& items = *entries;
+        auto  kept  = items.begin();
+
+        for (auto it = items.begin(); it != items.end(); ++it)
+        {
+            if (it->expired())
+            {
+                continue;
+            }
+
+            func(*detail::rc_ptr_access::get_pointer(*it));
+
+            if (!compact)
+            {
+                continue;
+            }
+
+            if (kept != it)
+            {
+                *kept = std::move(*it);
+            }
+
+            ++kept;
+        }
+
+        if (compact)
+        {
+            items.erase(kept, items.end());
+        }
+    }
+
+    /**
+     * @brief Returns the snapshot of the subscribers, not affected by the
+     * later changes of the list.
+     *
+     * @return snapshot
+     */
+    snapshot take_snapshot() const noexcept
+    {
+        return snapshot{ m_entries };
+    }
+
+    /**
+     * @brief Returns the number of entries, including the expired ones not
+     * compacted yet.
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const noexcept
+    {
+        return m_entries ? m_entries->size() : 0;
+    }
+
+private:
+    // Copies the living entries when the vector is shared.
+    entries_type& mutable_entries()
+    {
+        if (!m_entries)
+        {
+            m_entries = make_rc<entries_type>();
+        }
+        else if (!m_entries.unique())
+        {
+            auto copy = make_rc<entries_type>();
+            copy->reserve(m_entries->size() + 1);
+
+            for (const auto& entry : *m_entries)
+            {
+                if (!entry.expired())
+                {
+                    copy->push_back(entry);
+                }
+            }
+
+            m_entries = std::move(copy);
+        }
+
+        return *m_entries;
+    }
+
+    rc_ptr<entries_type> m_entries;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
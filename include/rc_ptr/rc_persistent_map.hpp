@@ -0,0 +1,1246 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_PERSISTENT_MAP_HPP
+#define RC_PERSISTENT_MAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+namespace detail
+{
+/**
+ * @brief Returns the number of set bits. Without the popcnt instruction
+ * __builtin_popcount becomes a library call, slower than counting the bits
+ * in parallel.
+ *
+ */
+inline unsigned popcount(std::uint32_t bits) noexcept
+{
+#if defined(__POPCNT__)
+    return static_cast<unsigned>(__builtin_popcount(bits));
+#else
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    bits = (bits + (bits >> 4)) & 0x0f0f0f0fu;
+    return static_cast<unsigned>((bits * 0x01010101u) >> 24);
+#endif
+}
+
+/**
+ * @brief Node of the compressed hash array mapped prefix tree, created by
+ * make_rc_flex. The entries and the children follow the node in the same
+ * allocation as the control block, their positions are given by datamap and
+ * nodemap. A collision node holds the entries with equal hashes and no
+ * bitmaps.
+ *
+ * @tparam K
+ * @tparam V
+ */
+template<typename K, typename V>
+class champ_node
+{
+public:
+    using entry_type = std::pair<K, V>;
+    using node_ptr   = rc_ptr<champ_node>;
+
+    static constexpr std::size_t unit_alignment =
+        std::max(alignof(entry_type), alignof(node_ptr));
+
+    struct alignas(unit_alignment) unit
+    {
+        unsigned char bytes[unit_alignment];
+    };
+
+    static node_ptr create(std::uint32_t datamap, std::uint32_t nodemap)
+    {
+        const auto data_capacity = popcount(datamap);
+        const auto node_capacity = popcount(nodemap);
+
+        return make_rc_flex<champ_node, unit>(
+            units(data_capacity, node_capacity),
+            datamap,
+            nodemap,
+            data_capacity,
+            node_capacity);
+    }
+
+    static node_ptr create_collision(std::uint32_t count)
+    {
+        return make_rc_flex<champ_node, unit>(units(count, 0),
+                                              std::uint32_t{ 0 },
+                                              std::uint32_t{ 0 },
+                                              count,
+                                              std::uint32_t{ 0 });
+    }
+
+    static node_ptr clone(const champ_node& other)
+    {
+        auto node = other.collision() ?
+                        create_collision(other.m_data_capacity) :
+                        create(other.m_datamap, other.m_nodemap);
+
+        for (std::uint32_t i = 0; i != other.m_data_count; ++i)
+        {
+            node->emplace_entry(other.entry(i));
+        }
+
+        for (std::uint32_t i = 0; i != other.m_node_count; ++i)
+        {
+            node->push_child(other.child(i));
+        }
+
+        return node;
+    }
+
+    champ_node(std::uint32_t datamap,
+               std::uint32_t nodemap,
+               std::uint32_t data_capacity,
+               std::uint32_t node_capacity) noexcept :
+        m_datamap{ datamap },
+        m_nodemap{ nodemap },
+        m_data_capacity{ data_capacity },
+        m_node_capacity{ node_capacity },
+        m_data_count{ 0 },
+        m_node_count{ 0 }
+    {
+    }
+
+    champ_node(const champ_node&) = delete;
+    champ_node& operator=(const champ_node&) = delete;
+
+    ~champ_node()
+    {
+        std::destroy_n(entries(), m_data_count);
+        std::destroy_n(children(), m_node_count);
+    }
+
+    std::uint32_t datamap() const noexcept
+    {
+        return m_datamap;
+    }
+
+    std::uint32_t nodemap() const noexcept
+    {
+        return m_nodemap;
+    }
+
+    bool collision() const noexcept
+    {
+        return !m_datamap && !m_nodemap;
+    }
+
+    std::uint32_t data_count() const noexcept
+    {
+        return m_data_count;
+    }
+
+    std::uint32_t node_count() const noexcept
+    {
+        return m_node_count;
+    }
+
+    std::uint32_t data_index(std::uint32_t bit) const noexcept
+    {
+        return popcount(m_datamap & (bit - 1));
+    }
+
+    std::uint32_t node_index(std::uint32_t bit) const noexcept
+    {
+        return popcount(m_nodemap & (bit - 1));
+    }
+
+    entry_type& entry(std::uint32_t index) noexcept
+    {
+        assert(index < m_data_count);
+        return entries()[index];
+    }
+
+    const entry_type& entry(std::uint32_t index) const noexcept
+    {
+        assert(index < m_data_count);
+        return entries()[index];
+    }
+
+    node_ptr& child(std::uint32_t index) noexcept
+    {
+        assert(index < m_node_count);
+        return children()[index];
+    }
+
+    const node_ptr& child(std::uint32_t index) const noexcept
+    {
+        assert(index < m_node_count);
+        return children()[index];
+    }
+
+    // The entries and the children are filled in the order of their bits.
+    template<typename... ArgsT>
+    void emplace_entry(ArgsT&&... args)
+    {
+        assert(m_data_count < m_data_capacity);
+        construct_object(entries() + m_data_count,
+                         std::forward<ArgsT>(args)...);
+        ++m_data_count;
+    }
+
+    void push_child(node_ptr child) noexcept
+    {
+        assert(m_node_count < m_node_capacity);
+        ::new (static_cast<void*>(children() + m_node_count))
+            node_ptr{ std::move(child) };
+        ++m_node_count;
+    }
+
+private:
+    static std::size_t children_offset(std::size_t data_capacity) noexcept
+    {
+        const auto size = data_capacity * sizeof(entry_type);
+        return (size + alignof(node_ptr) - 1) / alignof(node_ptr) *
+               alignof(node_ptr);
+    }
+
+    static std::size_t units(std::size_t data_capacity,
+                             std::size_t node_capacity) noexcept
+    {
+        const auto size = children_offset(data_capacity) +
+                          node_capacity * sizeof(node_ptr);
+        return (size + sizeof(unit) - 1) / sizeof(unit);
+    }
+
+    unsigned char* trailer() const noexcept
+    {
+        return reinterpret_cast<unsigned char*>(
+            flex_data<unit>(const_cast<champ_node*>(this)));
+    }
+
+    entry_type* entries() const noexcept
+    {
+        return std::launder(reinterpret_cast<entry_type*>(trailer()));
+    }
+
+    node_ptr* children() const noexcept
+    {
+        return std::launder(reinterpret_cast<node_ptr*>(
+            trailer() + children_offset(m_data_capacity)));
+    }
+
+    std::uint32_t m_datamap;
+    std::uint32_t m_nodemap;
+    std::uint32_t m_data_capacity;
+    std::uint32_t m_node_capacity;
+    std::uint32_t m_data_count;
+    std::uint32_t m_node_count;
+};
+
+/**
+ * @brief Compressed hash array mapped prefix tree shared by
+ * rc_persistent_map and rc_transient_map. Every mutation copies only the
+ * nodes that are shared with another tree. A uniquely owned node is updated
+ * in place when its shape does not change, otherwise its entries are moved
+ * to the resized node.
+ *
+ * The tree is kept in the canonical form, a subtree holding a single entry
+ * is always inlined into its parent, so equal maps built from a common
+ * ancestor share their unchanged nodes.
+ *
+ * @tparam K
+ * @tparam V
+ * @tparam Hash
+ * @tparam KeyEqual
+ */
+template<typename K, typename V, typename Hash, typename KeyEqual>
+class champ_tree
+{
+public:
+    using node_type  = champ_node<K, V>;
+    using node_ptr   = typename node_type::node_ptr;
+    using entry_type = typename node_type::entry_type;
+
+    static constexpr unsigned bits = 5;
+    static constexpr unsigned hash_bits =
+        std::numeric_limits<std::size_t>::digits;
+
+    champ_tree() = default;
+
+    champ_tree(const champ_tree& other) = default;
+
+    champ_tree(champ_tree&& other) noexcept :
+        m_root{ std::move(other.m_root) },
+        m_size{ std::exchange(other.m_size, 0) },
+        m_hash{ other.m_hash },
+        m_equal{ other.m_equal }
+    {
+    }
+
+    champ_tree& operator=(const champ_tree& other) = default;
+
+    champ_tree& operator=(champ_tree&& other) noexcept
+    {
+        m_root  = std::move(other.m_root);
+        m_size  = std::exchange(other.m_size, 0);
+        m_hash  = other.m_hash;
+        m_equal = other.m_equal;
+        return *this;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    const V* find(const K& key) const
+    {
+        if (!m_root)
+        {
+            return nullptr;
+        }
+
+        const auto hash  = m_hash(key);
+        auto       node  = m_root.get();
+        unsigned   shift = 0;
+
+        while (!node->collision())
+        {
+            const auto bit = bit_of(hash, shift);
+
+            if (node->datamap() & bit)
+            {
+                const auto& entry = node->entry(node->data_index(bit));
+                return m_equal(entry.first, key) ? &entry.second : nullptr;
+            }
+
+            if (!(node->nodemap() & bit))
+            {
+                return nullptr;
+            }
+
+            node = node->child(node->node_index(bit)).get();
+            shift += bits;
+        }
+
+        for (std::uint32_t i = 0; i != node->data_count(); ++i)
+        {
+            if (m_equal(node->entry(i).first, key))
+            {
+                return &node->entry(i).second;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void set(const K& key, V value)
+    {
+        entry_type entry{ key, std::move(value) };
+
+        if (!m_root)
+        {
+            m_root = node_type::create(bit_of(m_hash(key), 0), 0);
+            m_root->emplace_entry(std::move(entry));
+            m_size = 1;
+            return;
+        }
+
+        if (insert(m_root, entry, m_hash(key), 0))
+        {
+            ++m_size;
+        }
+    }
+
+    bool erase(const K& key)
+    {
+        if (!find(key))
+        {
+            return false;
+        }
+
+        remove(m_root, key, m_hash(key), 0);
+        if (!--m_size)
+        {
+            m_root.reset();
+        }
+
+        return true;
+    }
+
+    template<typename Func>
+    void for_each(Func& func) const
+    {
+        if (m_root)
+        {
+            for_each(*m_root, func);
+        }
+    }
+
+    // Builds the tree bottom up from the entries sorted by the chunks of
+    // their hashes, the first level in the most significant bits.
+    template<typename InputIt>
+    void build_sorted(InputIt first, InputIt last)
+    {
+        std::vector<item> items;
+        for (; first != last; ++first)
+        {
+            if (!items.empty() && m_equal(items.back().entry.first,
+                                          first->first))
+            {
+                items.back().entry.second = first->second;
+                continue;
+            }
+
+            const auto hash = m_hash(first->first);
+            items.push_back(item{ sort_key(hash), hash, entry_type(*first) });
+        }
+
+        std::sort(items.begin(),
+                  items.end(),
+                  [](const item& lhs, const item& rhs) {
+                      return lhs.key < rhs.key;
+                  });
+
+        m_root = items.empty() ? node_ptr{} : build(items, 0, items.size(), 0);
+        m_size = items.size();
+    }
+
+    template<typename Added, typename Removed, typename Changed>
+    void diff(const champ_tree& newer,
+              Added&            added,
+              Removed&          removed,
+              Changed&          changed) const
+    {
+        if (m_root && newer.m_root)
+        {
+            diff_nodes(m_root, newer.m_root, added, removed, changed);
+        }
+        else if (m_root)
+        {
+            for_each(*m_root, removed);
+        }
+        else if (newer.m_root)
+        {
+            for_each(*newer.m_root, added);
+        }
+    }
+
+private:
+    struct item
+    {
+        std::size_t key;
+        std::size_t hash;
+        entry_type  entry;
+    };
+
+    static constexpr bool move_entries =
+        std::is_nothrow_move_constructible_v<entry_type>;
+
+    static std::uint32_t bit_of(std::size_t hash, unsigned shift) noexcept
+    {
+        return std::uint32_t{ 1 } << ((hash >> shift) & 31);
+    }
+
+    static std::size_t sort_key(std::size_t hash) noexcept
+    {
+        std::size_t key = 0;
+        for (unsigned shift = 0; shift < hash_bits; shift += bits)
+        {
+            const auto width = std::min(bits, hash_bits - shift);
+            key = (key << width) | ((hash >> shift) & ((1u << width) - 1));
+        }
+        return key;
+    }
+
+    static node_type& mutable_node(node_ptr& ptr)
+    {
+        if (!ptr.unique())
+        {
+            ptr = node_type::clone(*ptr);
+        }
+
+        return *ptr;
+    }
+
+    // Moves the entry out of a uniquely owned node, copies it otherwise.
+    static void transfer_entry(node_type&  to,
+                               node_type&  from,
+                               std::size_t index,
+                               bool        move)
+    {
+        if (move)
+        {
+            to.emplace_entry(std::move(from.entry(index)));
+        }
+        else
+        {
+            to.emplace_entry(std::as_const(from.entry(index)));
+        }
+    }
+
+    // Replaces the node with the one of the given bitmaps. The entry at
+    // entry_bit and the child at child_bit are taken from the arguments,
+    // the rest from the old node.
+    static void reshape(node_ptr&     ptr,
+                        std::uint32_t datamap,
+                        std::uint32_t nodemap,
+                        entry_type*   entry,
+                        std::uint32_t entry_bit,
+                        node_ptr*     child,
+                        std::uint32_t child_bit)
+    {
+        auto&      source = *ptr;
+        const bool move   = move_entries && ptr.unique();
+        auto       result = node_type::create(datamap, nodemap);
+
+        for (auto rest = datamap; rest; rest &= rest - 1)
+        {
+            const auto bit = rest & (~rest + 1);
+            if (bit == entry_bit)
+            {
+                result->emplace_entry(std::move(*entry));
+            }
+            else
+            {
+                transfer_entry(*result, source, source.data_index(bit), move);
+            }
+        }
+
+        for (auto rest = nodemap; rest; rest &= rest - 1)
+        {
+            const auto bit = rest & (~rest + 1);
+            if (bit == child_bit)
+            {
+                result->push_child(std::move(*child));
+            }
+            else
+            {
+                result->push_child(source.child(source.node_index(bit)));
+            }
+        }
+
+        ptr = std::move(result);
+    }
+
+    static node_ptr merge_entries(entry_type  first,
+                                  std::size_t first_hash,
+                                  entry_type  second,
+                                  std::size_t second_hash,
+                                  unsigned    shift)
+    {
+        if (shift >= hash_bits)
+        {
+            auto node = node_type::create_collision(2);
+            node->emplace_entry(std::move(first));
+            node->emplace_entry(std::move(second));
+            return node;
+        }
+
+        const auto first_bit  = bit_of(first_hash, shift);
+        const auto second_bit = bit_of(second_hash, shift);
+
+        if (first_bit == second_bit)
+        {
+            auto node = node_type::create(0, first_bit);
+            node->push_child(merge_entries(std::move(first),
+                                           first_hash,
+                                           std::move(second),
+                                           second_hash,
+                                           shift + bits));
+            return node;
+        }
+
+        auto node = node_type::create(first_bit | second_bit, 0);
+        if (first_bit < second_bit)
+        {
+            node->emplace_entry(std::move(first));
+            node->emplace_entry(std::move(second));
+        }
+        else
+        {
+            node->emplace_entry(std::move(second));
+            node->emplace_entry(std::move(first));
+        }
+        return node;
+    }
+
+    // Returns true when the entry was added, false when the value of an
+    // existing entry was replaced.
+    bool insert(node_ptr&   ptr,
+                entry_type& entry,
+                std::size_t hash,
+                unsigned    shift)
+    {
+        auto& node = *ptr;
+
+        if (node.collision())
+        {
+            for (std::uint32_t i = 0; i != node.data_count(); ++i)
+            {
+                if (m_equal(node.entry(i).first, entry.first))
+                {
+                    mutable_node(ptr).entry(i).second =
+                        std::move(entry.second);
+                    return false;
+                }
+            }
+
+            const bool move   = move_entries && ptr.unique();
+            auto       result = node_type::create_collision(
+                node.data_count() + 1);
+            for (std::uint32_t i = 0; i != node.data_count(); ++i)
+            {
+                transfer_entry(*result, node, i, move);
+            }
+            result->emplace_entry(std::move(entry));
+            ptr = std::move(result);
+            return true;
+        }
+
+        const auto bit = bit_of(hash, shift);
+
+        if (node.datamap() & bit)
+        {
+            const auto index    = node.data_index(bit);
+            auto&      existing = node.entry(index);
+
+            if (m_equal(existing.first, entry.first))
+            {
+                mutable_node(ptr).entry(index).second =
+                    std::move(entry.second);
+                return false;
+            }
+
+            const auto existing_hash = m_hash(existing.first);
+            auto       child         = merge_entries(
+                move_entries && ptr.unique() ? std::move(existing) : existing,
+                existing_hash,
+                std::move(entry),
+                hash,
+                shift + bits);
+
+            reshape(ptr,
+                    node.datamap() & ~bit,
+                    node.nodemap() | bit,
+                    nullptr,
+                    0,
+                    &child,
+                    bit);
+            return true;
+        }
+
+        if (node.nodemap() & bit)
+        {
+            auto& parent = mutable_node(ptr);
+            return insert(parent.child(parent.node_index(bit)),
+                          entry,
+                          hash,
+                          shift + bits);
+        }
+
+        reshape(ptr,
+                node.datamap() | bit,
+                node.nodemap(),
+                &entry,
+                bit,
+                nullptr,
+                0);
+        return true;
+    }
+
+    // Removes the entry of key, which must be present.
+    void remove(node_ptr& ptr, const K& key, std::size_t hash, unsigned shift)
+    {
+        auto& node = *ptr;
+
+        if (node.collision())
+        {
+            const bool move   = move_entries && ptr.unique();
+            auto       result = node_type::create_collision(
+                node.data_count() - 1);
+            for (std::uint32_t i = 0; i != node.data_count(); ++i)
+            {
+                if (!m_equal(node.entry(i).first, key))
+                {
+                    transfer_entry(*result, node, i, move);
+                }
+            }
+            ptr = std::move(result);
+            return;
+        }
+
+        const auto bit = bit_of(hash, shift);
+
+        if (node.datamap() & bit)
+        {
+            reshape(ptr,
+                    node.datamap() & ~bit,
+                    node.nodemap(),
+                    nullptr,
+                    0,
+                    nullptr,
+                    0);
+            return;
+        }
+
+        auto& parent = mutable_node(ptr);
+        auto& child  = parent.child(parent.node_index(bit));
+        remove(child, key, hash, shift + bits);
+
+        if (!child->node_count() && child->data_count() == 1)
+        {
+            auto&      single = child->entry(0);
+            entry_type entry  = move_entries && child.unique() ?
+                                    std::move(single) :
+                                    single;
+            reshape(ptr,
+                    parent.datamap() | bit,
+                    parent.nodemap() & ~bit,
+                    &entry,
+                    bit,
+                    nullptr,
+                    0);
+        }
+    }
+
+    node_ptr build(std::vector<item>& items,
+                   std::size_t        first,
+                   std::size_t        last,
+                   unsigned           shift)
+    {
+        if (shift >= hash_bits)
+        {
+            auto node = node_type::create_collision(
+                static_cast<std::uint32_t>(last - first));
+            for (; first != last; ++first)
+            {
+                node->emplace_entry(std::move(items[first].entry));
+            }
+            return node;
+        }
+
+        auto group_end = [&items, last, shift](std::size_t begin) {
+            const auto bit = bit_of(items[begin].hash, shift);
+            while (++begin != last && bit_of(items[begin].hash, shift) == bit)
+            {
+            }
+            return begin;
+        };
+
+        std::uint32_t            datamap = 0;
+        std::uint32_t            nodemap = 0;
+        std::array<node_ptr, 32> children;
+        std::size_t              count = 0;
+
+        for (auto begin = first; begin != last;)
+        {
+            const auto end = group_end(begin);
+            const auto bit = bit_of(items[begin].hash, shift);
+
+            if (end - begin == 1)
+            {
+                datamap |= bit;
+            }
+            else
+            {
+                nodemap |= bit;
+                children[count++] = build(items, begin, end, shift + bits);
+            }
+
+            begin = end;
+        }
+
+        auto node = node_type::create(datamap, nodemap);
+        for (auto begin = first; begin != last;)
+        {
+            const auto end = group_end(begin);
+            if (end - begin == 1)
+            {
+                node->emplace_entry(std::move(items[begin].entry));
+            }
+            begin = end;
+        }
+
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            node->push_child(std::move(children[i]));
+        }
+
+        return node;
+    }
+
+    template<typename Func>
+    static void for_each(const node_type& node, Func& func)
+    {
+        for (std::uint32_t i = 0; i != node.data_count(); ++i)
+        {
+            func(node.entry(i).first, node.entry(i).second);
+        }
+
+        for (std::uint32_t i = 0; i != node.node_count(); ++i)
+        {
+            for_each(*node.child(i), func);
+        }
+    }
+
+    // Compares the entry with the entries of the subtree on the other side.
+    template<typename Added, typename Removed, typename Changed>
+    void diff_entry(const entry_type& entry,
+                    bool              entry_is_older,
+                    const node_type&  subtree,
+                    Added&            added,
+                    Removed&          removed,
+                    Changed&          changed) const
+    {
+        bool found = false;
+
+        auto visit = [&](const K& key, const V& value) {
+            if (!found && m_equal(key, entry.first))
+            {
+                found = true;
+                if (!(value == entry.second))
+                {
+                    entry_is_older ? changed(key, entry.second, value) :
+                                     changed(key, value, entry.second);
+                }
+            }
+            else
+            {
+                entry_is_older ? added(key, value) : removed(key, value);
+            }
+        };
+        for_each(subtree, visit);
+
+        if (!found)
+        {
+            entry_is_older ? removed(entry.first, entry.second) :
+                             added(entry.first, entry.second);
+        }
+    }
+
+    template<typename Added, typename Removed, typename Changed>
+    void diff_collisions(const node_type& older,
+                         const node_type& newer,
+                         Added&           added,
+                         Removed&         removed,
+                         Changed&         changed) const
+    {
+        auto find = [this](const node_type& node, const K& key) {
+            for (std::uint32_t i = 0; i != node.data_count(); ++i)
+            {
+                if (m_equal(node.entry(i).first, key))
+                {
+                    return &node.entry(i);
+                }
+            }
+            return static_cast<const entry_type*>(nullptr);
+        };
+
+        for (std::uint32_t i = 0; i != older.data_count(); ++i)
+        {
+            const auto& entry = older.entry(i);
+            const auto  other = find(newer, entry.first);
+
+            if (!other)
+            {
+                removed(entry.first, entry.second);
+            }
+            else if (!(other->second == entry.second))
+            {
+                changed(entry.first, entry.second, other->second);
+            }
+        }
+
+        for (std::uint32_t i = 0; i != newer.data_count(); ++i)
+        {
+            const auto& entry = newer.entry(i);
+            if (!find(older, entry.first))
+            {
+                added(entry.first, entry.second);
+            }
+        }
+    }
+
+    // Visits the differences between two subtrees at the same position,
+    // skipping the children shared by both.
+    template<typename Added, typename Removed, typename Changed>
+    void diff_nodes(const node_ptr& older,
+                    const node_ptr& newer,
+                    Added&          added,
+                    Removed&        removed,
+                    Changed&        changed) const
+    {
+        if (older.get() == newer.get())
+        {
+            return;
+        }
+
+        if (older->collision())
+        {
+            diff_collisions(*older, *newer, added, removed, changed);
+            return;
+        }
+
+        const auto all = older->datamap() | older->nodemap() |
+                         newer->datamap() | newer->nodemap();
+
+        for (auto rest = all; rest; rest &= rest - 1)
+        {
+            const auto bit = rest & (~rest + 1);
+
+            if (older->datamap() & bit)
+            {
+                const auto& entry = older->entry(older->data_index(bit));
+
+                if (newer->datamap() & bit)
+                {
+                    const auto& other = newer->entry(newer->data_index(bit));
+                    if (!m_equal(entry.first, other.first))
+                    {
+                        removed(entry.first, entry.second);
+                        added(other.first, other.second);
+                    }
+                    else if (!(entry.second == other.second))
+                    {
+                        changed(entry.first, entry.second, other.second);
+                    }
+                }
+                else if (newer->nodemap() & bit)
+                {
+                    diff_entry(entry,
+                               true,
+                               *newer->child(newer->node_index(bit)),
+                               added,
+                               removed,
+                               changed);
+                }
+                else
+                {
+                    removed(entry.first, entry.second);
+                }
+            }
+            else if (older->nodemap() & bit)
+            {
+                const auto& child = older->child(older->node_index(bit));
+
+                if (newer->datamap() & bit)
+                {
+                    diff_entry(newer->entry(newer->data_index(bit)),
+                               false,
+                               *child,
+                               added,
+                               removed,
+                               changed);
+                }
+                else if (newer->nodemap() & bit)
+                {
+                    diff_nodes(child,
+                               newer->child(newer->node_index(bit)),
+                               added,
+                               removed,
+                               changed);
+                }
+                else
+                {
+                    for_each(*child, removed);
+                }
+            }
+            else if (newer->datamap() & bit)
+            {
+                const auto& entry = newer->entry(newer->data_index(bit));
+                added(entry.first, entry.second);
+            }
+            else
+            {
+                for_each(*newer->child(newer->node_index(bit)), added);
+            }
+        }
+    }
+
+    node_ptr    m_root;
+    std::size_t m_size = 0;
+    Hash        m_hash;
+    KeyEqual    m_equal;
+};
+} // namespace detail
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+class rc_transient_map;
+
+/**
+ * @brief rc_persistent_map class template is an immutable hash map stored in
+ * a compressed hash array mapped prefix tree (CHAMP) of rc_ptr managed
+ * nodes. Each node keeps its entries and children in the same allocation as
+ * its control block, positioned by two 32 bit bitmaps. Modifying operations
+ * return a new map sharing all but O(log n) nodes with the original one, so
+ * a snapshot is a copy of the root pointer.
+ *
+ * diff visits the differences between two versions, skipping the subtrees
+ * shared by both. For batches of modifications use rc_transient_map.
+ *
+ * @tparam K
+ * @tparam V
+ * @tparam Hash
+ * @tparam KeyEqual
+ */
+template<typename K, typename V, typename Hash = std::hash<K>,
+         typename KeyEqual = std::equal_to<K>>
+class rc_persistent_map
+{
+public:
+    using key_type       = K;
+    using mapped_type    = V;
+    using value_type     = std::pair<K, V>;
+    using size_type      = std::size_t;
+    using transient_type = rc_transient_map<K, V, Hash, KeyEqual>;
+
+    rc_persistent_map() = default;
+
+    rc_persistent_map(std::initializer_list<value_type> init) :
+        rc_persistent_map(init.begin(), init.end())
+    {
+    }
+
+    template<typename InputIt>
+    rc_persistent_map(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+        {
+            m_tree.set(first->first, first->second);
+        }
+    }
+
+    /**
+     * @brief Builds the map bottom up from the range of key-value pairs
+     * sorted by key, without a lookup per entry. Of the adjacent pairs with
+     * equal keys the last one is kept.
+     *
+     * @tparam InputIt
+     * @param first
+     * @param last
+     * @return rc_persistent_map
+     */
+    template<typename InputIt>
+    static rc_persistent_map from_sorted(InputIt first, InputIt last)
+    {
+        rc_persistent_map result;
+        result.m_tree.build_sorted(first, last);
+        return result;
+    }
+
+    size_type size() const noexcept
+    {
+        return m_tree.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return !m_tree.size();
+    }
+
+    /**
+     * @brief Returns the pointer to the value of key or nullptr.
+     *
+     * @param key
+     * @return const V*
+     */
+    const V* find(const K& key) const
+    {
+        return m_tree.find(key);
+    }
+
+    bool contains(const K& key) const
+    {
+        return m_tree.find(key) != nullptr;
+    }
+
+    /**
+     * @brief Returns the map with the value of key set.
+     *
+     * @param key
+     * @param value
+     * @return rc_persistent_map
+     */
+    rc_persistent_map set(const K& key, V value) const
+    {
+        auto result = *this;
+        result.m_tree.set(key, std::move(value));
+        return result;
+    }
+
+    /**
+     * @brief Returns the map without key.
+     *
+     * @param key
+     * @return rc_persistent_map
+     */
+    rc_persistent_map erase(const K& key) const
+    {
+        auto result = *this;
+        result.m_tree.erase(key);
+        return result;
+    }
+
+    /**
+     * @brief Calls func with the key and the value of every entry, in an
+     * unspecified order.
+     *
+     * @tparam Func
+     * @param func
+     */
+    template<typename Func>
+    void for_each(Func func) const
+    {
+        m_tree.for_each(func);
+    }
+
+    /**
+     * @brief Visits the differences between this and newer. added and
+     * removed are called with the key and the value, changed with the key,
+     * the old value and the new value. Subtrees shared by both maps are
+     * skipped, so comparing versions derived from each other costs in
+     * proportion to the number of changes.
+     *
+     * @tparam Added
+     * @tparam Removed
+     * @tparam Changed
+     * @param newer
+     * @param added
+     * @param removed
+     * @param changed
+     */
+    template<typename Added, typename Removed, typename Changed>
+    void diff(const rc_persistent_map& newer,
+              Added                    added,
+              Removed                  removed,
+              Changed                  changed) const
+    {
+        m_tree.diff(newer.m_tree, added, removed, changed);
+    }
+
+    /**
+     * @brief Returns the transient map starting from the entries of this.
+     * Nodes are shared until the transient map modifies them.
+     *
+     * @return transient_type
+     */
+    transient_type transient() const
+    {
+        return transient_type{ m_tree };
+    }
+
+private:
+    friend class rc_transient_map<K, V, Hash, KeyEqual>;
+
+    using tree_type = detail::champ_tree<K, V, Hash, KeyEqual>;
+
+    explicit rc_persistent_map(tree_type tree) noexcept :
+        m_tree{ std::move(tree) }
+    {
+    }
+
+    tree_type m_tree;
+};
+
+/**
+ * @brief rc_transient_map class template is the mutable builder of
+ * rc_persistent_map. A node is modified in place when its use_count() is 1,
+ * otherwise it is copied first, so the persistent maps sharing the node are
+ * never affected.
+ *
+ * @tparam K
+ * @tparam V
+ * @tparam Hash
+ * @tparam KeyEqual
+ */
+template<typename K, typename V, typename Hash = std::hash<K>,
+         typename KeyEqual = std::equal_to<K>>
+class rc_transient_map
+{
+public:
+    using key_type    = K;
+    using mapped_type = V;
+    using size_type   = std::size_t;
+
+    rc_transient_map() = default;
+
+    size_type size() const noexcept
+    {
+        return m_tree.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return !m_tree.size();
+    }
+
+    const V* find(const K& key) const
+    {
+        return m_tree.find(key);
+    }
+
+    bool contains(const K& key) const
+    {
+        return m_tree.find(key) != nullptr;
+    }
+
+    void set(const K& key, V value)
+    {
+        m_tree.set(key, std::move(value));
+    }
+
+    /**
+     * @brief Removes key.
+     *
+     * @param key
+     * @return true if key was present
+     * @return false otherwise
+     */
+    bool erase(const K& key)
+    {
+        return m_tree.erase(key);
+    }
+
+    /**
+     * @brief Returns the persistent map with the current entries. The
+     * transient map may still be modified afterwards, the shared nodes are
+     * then copied.
+     *
+     * @return rc_persistent_map<K, V, Hash, KeyEqual>
+     */
+    rc_persistent_map<K, V, Hash, KeyEqual> persistent() const&
+    {
+        return rc_persistent_map<K, V, Hash, KeyEqual>{ m_tree };
+    }
+
+    rc_persistent_map<K, V, Hash, KeyEqual> persistent() &&
+    {
+        return rc_persistent_map<K, V, Hash, KeyEqual>{ std::move(m_tree) };
+    }
+
+private:
+    friend class rc_persistent_map<K, V, Hash, KeyEqual>;
+
+    using tree_type = detail::champ_tree<K, V, Hash, KeyEqual>;
+
+    explicit rc_transient_map(const tree_type& tree) : m_tree{ tree }
+    {
+    }
+
+    tree_type m_tree;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
@@ -0,0 +1,1341 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_PERSISTENT_VECTOR_HPP
+#define RC_PERSISTENT_VECTOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+namespace detail
+{
+/**
+ * @brief Node of the relaxed radix balanced tree, created by make_rc_flex. A
+ * leaf stores up to width values, an inner node stores up to width children
+ * and the size of its subtree. Only the nodes created as sized also keep the
+ * cumulative sizes of the subtrees of their children, which relaxed nodes
+ * need. The values, the children and the size table follow the node in the
+ * same allocation as the control block.
+ *
+ * @tparam T
+ */
+template<typename T>
+class pvector_node
+{
+public:
+    using node_ptr = rc_ptr<pvector_node>;
+
+    static constexpr unsigned    bits  = 5;
+    static constexpr std::size_t width = std::size_t{ 1 } << bits;
+
+    static constexpr std::size_t unit_alignment = std::max(
+        { alignof(T), alignof(node_ptr), alignof(std::size_t) });
+
+    struct alignas(unit_alignment) unit
+    {
+        unsigned char bytes[unit_alignment];
+    };
+
+    static node_ptr create_leaf()
+    {
+        return make_rc_flex<pvector_node, unit>(units(true, false),
+                                                true,
+                                                false);
+    }
+
+    static node_ptr create_inner(bool sized)
+    {
+        return make_rc_flex<pvector_node, unit>(units(false, sized),
+                                                false,
+                                                sized);
+    }
+
+    // Copies other into a new node, which keeps the size table when sized.
+    static node_ptr clone(const pvector_node& other, bool sized)
+    {
+        assert(!sized || !other.m_leaf);
+        assert(sized || !other.m_relaxed);
+
+        if (other.m_leaf)
+        {
+            auto node = create_leaf();
+            node->append_values(other, 0, other.m_count);
+            return node;
+        }
+
+        auto node = create_inner(sized);
+        node->append_children(other, 0, other.m_count);
+        node->m_relaxed = other.m_relaxed;
+        node->m_size    = other.m_size;
+        if (other.m_relaxed)
+        {
+            std::copy_n(other.sizes(), other.m_count, node->sizes());
+        }
+
+        return node;
+    }
+
+    pvector_node(bool leaf, bool sized) noexcept :
+        m_leaf{ leaf },
+        m_sized{ sized },
+        m_relaxed{ false },
+        m_count{ 0 },
+        m_size{ 0 }
+    {
+    }
+
+    pvector_node(const pvector_node&) = delete;
+    pvector_node& operator=(const pvector_node&) = delete;
+
+    ~pvector_node()
+    {
+        truncate(0);
+    }
+
+    bool leaf() const noexcept
+    {
+        return m_leaf;
+    }
+
+    bool sized() const noexcept
+    {
+        return m_sized;
+    }
+
+    bool relaxed() const noexcept
+    {
+        return m_relaxed;
+    }
+
+    // Marks the node relaxed, the size table must be filled by the caller.
+    void set_relaxed(bool relaxed) noexcept
+    {
+        assert(!relaxed || m_sized);
+        m_relaxed = relaxed;
+    }
+
+    std::size_t count() const noexcept
+    {
+        return m_count;
+    }
+
+    // Returns the number of values in the subtree.
+    std::size_t size() const noexcept
+    {
+        return m_leaf ? m_count : m_size;
+    }
+
+    void set_size(std::size_t size) noexcept
+    {
+        assert(!m_leaf);
+        m_size = size;
+    }
+
+    T& value(std::size_t index) noexcept
+    {
+        assert(m_leaf && index < m_count);
+        return values()[index];
+    }
+
+    const T& value(std::size_t index) const noexcept
+    {
+        assert(m_leaf && index < m_count);
+        return values()[index];
+    }
+
+    node_ptr& child(std::size_t index) noexcept
+    {
+        assert(!m_leaf && index < m_count);
+        return children()[index];
+    }
+
+    const node_ptr& child(std::size_t index) const noexcept
+    {
+        assert(!m_leaf && index < m_count);
+        return children()[index];
+    }
+
+    std::size_t* sizes() const noexcept
+    {
+        assert(m_sized);
+        return std::launder(
+            reinterpret_cast<std::size_t*>(trailer() + sizes_offset));
+    }
+
+    template<typename... ArgsT>
+    void emplace_value(ArgsT&&... args)
+    {
+        assert(m_leaf && m_count < width);
+        construct_object(values() + m_count, std::forward<ArgsT>(args)...);
+        ++m_count;
+    }
+
+    void push_child(node_ptr child) noexcept
+    {
+        assert(!m_leaf && m_count < width);
+        ::new (static_cast<void*>(children() + m_count))
+            node_ptr{ std::move(child) };
+        ++m_count;
+    }
+
+    // Copies the values [first, last) of other, destroying the already
+    // copied ones when a copy throws.
+    void append_values(const pvector_node& other,
+                       std::size_t         first,
+                       std::size_t         last)
+    {
+        const auto count = m_count;
+
+        try
+        {
+            for (; first != last; ++first)
+            {
+                emplace_value(other.value(first));
+            }
+        }
+        catch (...)
+        {
+            truncate(count);
+            throw;
+        }
+    }
+
+    void append_children(const pvector_node& other,
+                         std::size_t         first,
+                         std::size_t         last) noexcept
+    {
+        for (; first != last; ++first)
+        {
+            push_child(other.child(first));
+        }
+    }
+
+    void truncate(std::size_t count) noexcept
+    {
+        assert(count <= m_count);
+
+        if (m_leaf)
+        {
+            std::destroy(values() + count, values() + m_count);
+        }
+        else
+        {
+            std::destroy(children() + count, children() + m_count);
+        }
+
+        m_count = static_cast<std::uint32_t>(count);
+    }
+
+private:
+    static constexpr std::size_t sizes_offset =
+        (sizeof(node_ptr) * width + alignof(std::size_t) - 1) /
+        alignof(std::size_t) * alignof(std::size_t);
+
+    static std::size_t units(bool leaf, bool sized) noexcept
+    {
+        const auto size =
+            leaf ? sizeof(T) * width :
+                   (sized ? sizes_offset + sizeof(std::size_t) * width :
+                            sizeof(node_ptr) * width);
+        return (size + sizeof(unit) - 1) / sizeof(unit);
+    }
+
+    unsigned char* trailer() const noexcept
+    {
+        return reinterpret_cast<unsigned char*>(
+            flex_data<unit>(const_cast<pvector_node*>(this)));
+    }
+
+    T* values() const noexcept
+    {
+        return std::launder(reinterpret_cast<T*>(trailer()));
+    }
+
+    node_ptr* children() const noexcept
+    {
+        return std::launder(reinterpret_cast<node_ptr*>(trailer()));
+    }
+
+    bool          m_leaf;
+    bool          m_sized;
+    bool          m_relaxed;
+    std::uint32_t m_count;
+    std::size_t   m_size;
+};
+
+/**
+ * @brief Relaxed radix balanced tree with a tail buffer, shared by
+ * rc_persistent_vector and rc_transient_vector. Every mutation copies only
+ * the nodes that are shared with another tree, so a uniquely owned tree is
+ * updated in place.
+ *
+ * @tparam T
+ */
+template<typename T>
+class pvector_tree
+{
+public:
+    using node_type = pvector_node<T>;
+    using node_ptr  = typename node_type::node_ptr;
+
+    static constexpr unsigned    bits  = node_type::bits;
+    static constexpr std::size_t width = node_type::width;
+
+    pvector_tree() noexcept = default;
+
+    pvector_tree(const pvector_tree& other) = default;
+
+    pvector_tree(pvector_tree&& other) noexcept :
+        m_root{ std::move(other.m_root) },
+        m_tail{ std::move(other.m_tail) },
+        m_size{ std::exchange(other.m_size, 0) },
+        m_shift{ std::exchange(other.m_shift, 0) }
+    {
+    }
+
+    pvector_tree& operator=(const pvector_tree& other) = default;
+
+    pvector_tree& operator=(pvector_tree&& other) noexcept
+    {
+        m_root  = std::move(other.m_root);
+        m_tail  = std::move(other.m_tail);
+        m_size  = std::exchange(other.m_size, 0);
+        m_shift = std::exchange(other.m_shift, 0);
+        return *this;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    std::size_t height() const noexcept
+    {
+        return m_root ? m_shift / bits + 1 : 0;
+    }
+
+    const T& get(std::size_t index) const noexcept
+    {
+        std::size_t first = 0;
+        const auto  leaf  = leaf_at(index, first);
+        return leaf->value(index - first);
+    }
+
+    // Returns the leaf holding index and the index of its first value.
+    const node_type* leaf_at(std::size_t  index,
+                             std::size_t& first) const noexcept
+    {
+        assert(index < m_size);
+
+        const auto offset = tail_offset();
+        if (index >= offset)
+        {
+            first = offset;
+            return m_tail.get();
+        }
+
+        first     = index;
+        auto node = m_root.get();
+        for (auto shift = m_shift; shift; shift -= bits)
+        {
+            node = node->child(child_index(*node, shift, index)).get();
+        }
+
+        first -= index;
+        return node;
+    }
+
+    T& mutable_value(std::size_t index)
+    {
+        assert(index < m_size);
+
+        const auto offset = tail_offset();
+        if (index >= offset)
+        {
+            return mutable_node(m_tail).value(index - offset);
+        }
+
+        auto ptr = &m_root;
+        for (auto shift = m_shift; shift; shift -= bits)
+        {
+            auto& node = mutable_node(*ptr);
+            ptr        = &node.child(child_index(node, shift, index));
+        }
+
+        return mutable_node(*ptr).value(index);
+    }
+
+    template<typename... ArgsT>
+    void emplace_back(ArgsT&&... args)
+    {
+        if (tail_size() == width)
+        {
+            push_tail();
+        }
+
+        if (!m_tail)
+        {
+            m_tail = node_type::create_leaf();
+        }
+
+        mutable_node(m_tail).emplace_value(std::forward<ArgsT>(args)...);
+        ++m_size;
+    }
+
+    void truncate(std::size_t count)
+    {
+        assert(count <= m_size);
+
+        const auto offset = tail_offset();
+        if (count > offset)
+        {
+            if (count != m_size)
+            {
+                mutable_node(m_tail).truncate(count - offset);
+            }
+        }
+        else if (!count)
+        {
+            m_root.reset();
+            m_shift = 0;
+            m_tail.reset();
+        }
+        else
+        {
+            trim_right(m_root, m_shift, count);
+            m_tail.reset();
+            collapse();
+        }
+
+        m_size = count;
+    }
+
+    void drop_front(std::size_t count)
+    {
+        assert(count <= m_size);
+
+        if (!count)
+        {
+            return;
+        }
+
+        const auto offset = tail_offset();
+        if (count >= offset)
+        {
+            node_ptr tail;
+            if (count != m_size)
+            {
+                tail = node_type::create_leaf();
+                tail->append_values(*m_tail, count - offset, tail_size());
+            }
+
+            m_root.reset();
+            m_shift = 0;
+            m_tail  = std::move(tail);
+        }
+        else
+        {
+            auto root = m_root;
+            trim_left(root, m_shift, count);
+            m_root = std::move(root);
+            collapse();
+        }
+
+        m_size -= count;
+    }
+
+    void append(const pvector_tree& other)
+    {
+        if (!other.m_size)
+        {
+            return;
+        }
+
+        if (!m_size)
+        {
+            *this = other;
+            return;
+        }
+
+        if (!other.m_root)
+        {
+            for (std::size_t i = 0; i != other.tail_size(); ++i)
+            {
+                emplace_back(other.m_tail->value(i));
+            }
+            return;
+        }
+
+        if (m_tail)
+        {
+            push_tail();
+        }
+
+        auto merged =
+            merge(m_root, m_shift, other.m_root, other.m_shift);
+        m_root  = std::move(merged.first);
+        m_shift = merged.second;
+        m_tail  = other.m_tail;
+        m_size += other.m_size;
+    }
+
+private:
+    std::size_t tail_size() const noexcept
+    {
+        return m_tail ? m_tail->count() : 0;
+    }
+
+    std::size_t tail_offset() const noexcept
+    {
+        return m_size - tail_size();
+    }
+
+    // Makes the node referenced by ptr uniquely owned, copying it if shared.
+    static node_type& mutable_node(node_ptr& ptr)
+    {
+        if (!ptr.unique())
+        {
+            ptr = node_type::clone(*ptr, ptr->relaxed());
+        }
+
+        return *ptr;
+    }
+
+    // Selects the child holding index and makes index relative to it. Each
+    // subtree at shift holds at most 1 << shift values, so index >> shift is
+    // exact for balanced nodes and a lower bound for relaxed ones.
+    static std::size_t child_index(const node_type& node,
+                                   unsigned         shift,
+                                   std::size_t&     index) noexcept
+    {
+        auto child = index >> shift;
+
+        if (!node.relaxed())
+        {
+            index -= child << shift;
+            return child;
+        }
+
+        const auto sizes = node.sizes();
+        while (sizes[child] <= index)
+        {
+            ++child;
+        }
+
+        if (child)
+        {
+            index -= sizes[child - 1];
+        }
+
+        return child;
+    }
+
+    static std::size_t subtree_size(const node_type& node) noexcept
+    {
+        return node.size();
+    }
+
+    // Recomputes the size of the subtree and, for a relaxed node, the size
+    // table. The node stays balanced only while every child but the last one
+    // is full. A node turning relaxed without room for the table is moved to
+    // a sized copy, so balanced nodes never pay for it.
+    static void update_sizes(node_ptr& ptr, unsigned shift)
+    {
+        assert(ptr.unique());
+
+        const auto  full    = std::size_t{ 1 } << shift;
+        const auto  count   = ptr->count();
+        std::size_t total   = 0;
+        bool        relaxed = false;
+
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            const auto size = subtree_size(*ptr->child(i));
+            relaxed         = relaxed || (i + 1 != count && size != full);
+            total += size;
+        }
+
+        if (relaxed)
+        {
+            if (!ptr->sized())
+            {
+                ptr = node_type::clone(*ptr, true);
+            }
+
+            const auto  sizes = ptr->sizes();
+            std::size_t sum   = 0;
+            for (std::size_t i = 0; i != count; ++i)
+            {
+                sum += subtree_size(*ptr->child(i));
+                sizes[i] = sum;
+            }
+        }
+
+        ptr->set_size(total);
+        ptr->set_relaxed(relaxed);
+    }
+
+    static node_ptr new_path(node_ptr node, unsigned shift)
+    {
+        for (unsigned level = bits; level <= shift; level += bits)
+        {
+            auto parent = node_type::create_inner(false);
+            parent->push_child(std::move(node));
+            update_sizes(parent, level);
+            node = std::move(parent);
+        }
+
+        return node;
+    }
+
+    static bool has_room(const node_type& node, unsigned shift) noexcept
+    {
+        return node.count() != width ||
+               (shift != bits && has_room(*node.child(width - 1),
+                                          shift - bits));
+    }
+
+    static bool push_leaf(node_ptr& ptr, unsigned shift, const node_ptr& leaf)
+    {
+        if (!has_room(*ptr, shift))
+        {
+            return false;
+        }
+
+        auto& node = mutable_node(ptr);
+        if (shift == bits ||
+            !push_leaf(node.child(node.count() - 1), shift - bits, leaf))
+        {
+            node.push_child(new_path(leaf, shift - bits));
+        }
+
+        update_sizes(ptr, shift);
+        return true;
+    }
+
+    // Moves the tail, which may be partially filled, into the tree.
+    void push_tail()
+    {
+        assert(m_tail);
+
+        if (!m_root)
+        {
+            m_root = m_tail;
+        }
+        else if (!m_shift || !push_leaf(m_root, m_shift, m_tail))
+        {
+            auto root = node_type::create_inner(false);
+            root->push_child(m_root);
+            root->push_child(new_path(m_tail, m_shift));
+            update_sizes(root, m_shift + bits);
+            m_root = std::move(root);
+            m_shift += bits;
+        }
+
+        m_tail.reset();
+    }
+
+    void collapse()
+    {
+        while (m_shift && m_root->count() == 1)
+        {
+            auto child = m_root->child(0);
+            m_root     = std::move(child);
+            m_shift -= bits;
+        }
+    }
+
+    // Keeps the first count values of the subtree.
+    static void trim_right(node_ptr& ptr, unsigned shift, std::size_t count)
+    {
+        if (subtree_size(*ptr) == count)
+        {
+            return;
+        }
+
+        auto& node = mutable_node(ptr);
+        if (!shift)
+        {
+            node.truncate(count);
+            return;
+        }
+
+        auto       index = count - 1;
+        const auto child = child_index(node, shift, index);
+        node.truncate(child + 1);
+        trim_right(node.child(child), shift - bits, index + 1);
+        update_sizes(ptr, shift);
+    }
+
+    // Removes the first count values of the subtree.
+    static void trim_left(node_ptr& ptr, unsigned shift, std::size_t count)
+    {
+        if (!count)
+        {
+            return;
+        }
+
+        if (!shift)
+        {
+            auto leaf = node_type::create_leaf();
+            leaf->append_values(*ptr, count, ptr->count());
+            ptr = std::move(leaf);
+            return;
+        }
+
+        auto       index = count;
+        const auto child = child_index(*ptr, shift, index);
+        auto       node  = node_type::create_inner(false);
+        node->append_children(*ptr, child, ptr->count());
+        trim_left(node->child(0), shift - bits, index);
+        update_sizes(node, shift);
+        ptr = std::move(node);
+    }
+
+    struct child_list
+    {
+        std::array<node_ptr, 2 * width> nodes;
+        std::size_t                     count = 0;
+
+        void push(node_ptr node) noexcept
+        {
+            nodes[count++] = std::move(node);
+        }
+
+        void push_children(const node_type& node,
+                           std::size_t      first,
+                           std::size_t      last) noexcept
+        {
+            for (; first != last; ++first)
+            {
+                push(node.child(first));
+            }
+        }
+    };
+
+    // A concatenation may leave at most extra_nodes more nodes than needed to
+    // hold their contents. Nodes with at most max_gap free slots are kept.
+    static constexpr std::size_t extra_nodes = 2;
+    static constexpr std::size_t max_gap     = 1;
+
+    // Redistributes the contents of the nodes at shift, the concatenation
+    // rebalancing of relaxed radix balanced trees. Without it, the short
+    // nodes along the seams pile up and every concat can add a level.
+    static void rebalance(child_list& nodes, unsigned shift)
+    {
+        std::array<std::size_t, 2 * width + 1> counts{};
+        std::size_t                            total = 0;
+
+        for (std::size_t i = 0; i != nodes.count; ++i)
+        {
+            counts[i] = nodes.nodes[i]->count();
+            total += counts[i];
+        }
+
+        const auto optimal = (total + width - 1) / width;
+        auto       count   = nodes.count;
+        if (count <= optimal + extra_nodes)
+        {
+            return;
+        }
+
+        // Spreads the contents of the first short node over the following
+        // ones, until one of them absorbs the rest and can be dropped.
+        std::size_t i = 0;
+        while (count > optimal + extra_nodes)
+        {
+            while (counts[i] + max_gap >= width)
+            {
+                ++i;
+            }
+
+            auto remaining = counts[i];
+            do
+            {
+                const auto size = std::min(remaining + counts[i + 1], width);
+                remaining       = remaining + counts[i + 1] - size;
+                counts[i]       = size;
+                ++i;
+            } while (remaining);
+
+            std::copy(counts.begin() + i + 1,
+                      counts.begin() + count,
+                      counts.begin() + i);
+            counts[--count] = 0;
+            --i;
+        }
+
+        child_list  result;
+        std::size_t source = 0;
+        std::size_t offset = 0;
+
+        for (std::size_t k = 0; k != count; ++k)
+        {
+            if (!offset && nodes.nodes[source]->count() == counts[k])
+            {
+                result.push(nodes.nodes[source++]);
+                continue;
+            }
+
+            auto node = shift ? node_type::create_inner(false) :
+                                node_type::create_leaf();
+            while (node->count() != counts[k])
+            {
+                const auto& from = *nodes.nodes[source];
+                const auto  last =
+                    std::min(from.count(), offset + counts[k] - node->count());
+
+                if (shift)
+                {
+                    node->append_children(from, offset, last);
+                }
+                else
+                {
+                    node->append_values(from, offset, last);
+                }
+
+                offset = last;
+                if (offset == from.count())
+                {
+                    ++source;
+                    offset = 0;
+                }
+            }
+
+            if (shift)
+            {
+                update_sizes(node, shift);
+            }
+
+            result.push(std::move(node));
+        }
+
+        nodes = std::move(result);
+    }
+
+    // Builds the parent of children at shift, adding a level when they do
+    // not fit in a single node.
+    static std::pair<node_ptr, unsigned> join(child_list& children,
+                                              unsigned    shift)
+    {
+        assert(shift < std::numeric_limits<std::size_t>::digits);
+        rebalance(children, shift - bits);
+
+        auto make_node = [&children, shift](std::size_t first,
+                                            std::size_t last) {
+            auto node = node_type::create_inner(false);
+            for (; first != last; ++first)
+            {
+                node->push_child(std::move(children.nodes[first]));
+            }
+            update_sizes(node, shift);
+            return node;
+        };
+
+        if (children.count <= width)
+        {
+            return { make_node(0, children.count), shift };
+        }
+
+        auto left  = make_node(0, width);
+        auto right = make_node(width, children.count);
+
+        child_list parent;
+        parent.push(std::move(left));
+        parent.push(std::move(right));
+        return join(parent, shift + bits);
+    }
+
+    // Concatenates two trees along the seam between the right edge of left
+    // and the left edge of right. The result is at the shift of the higher
+    // tree or one level above it.
+    static std::pair<node_ptr, unsigned> merge(const node_ptr& left,
+                                               unsigned        left_shift,
+                                               const node_ptr& right,
+                                               unsigned        right_shift)
+    {
+        child_list children;
+
+        if (left_shift > right_shift)
+        {
+            const auto last   = left->count() - 1;
+            auto       merged = merge(left->child(last),
+                                left_shift - bits,
+                                right,
+                                right_shift);
+
+            children.push_children(*left, 0, last);
+            push_merged(children, std::move(merged), left_shift);
+            return join(children, left_shift);
+        }
+
+        if (left_shift < right_shift)
+        {
+            auto merged =
+                merge(left, left_shift, right->child(0), right_shift - bits);
+
+            push_merged(children, std::move(merged), right_shift);
+            children.push_children(*right, 1, right->count());
+            return join(children, right_shift);
+        }
+
+        if (!left_shift)
+        {
+            if (left->count() + right->count() <= width)
+            {
+                auto leaf = node_type::create_leaf();
+                leaf->append_values(*left, 0, left->count());
+                leaf->append_values(*right, 0, right->count());
+                return { std::move(leaf), 0 };
+            }
+
+            children.push(left);
+            children.push(right);
+            return join(children, bits);
+        }
+
+        children.push_children(*left, 0, left->count());
+        children.push_children(*right, 0, right->count());
+        return join(children, left_shift);
+    }
+
+    static void push_merged(child_list&                     children,
+                            std::pair<node_ptr, unsigned>&& merged,
+                            unsigned                        shift) noexcept
+    {
+        if (merged.second == shift)
+        {
+            children.push_children(*merged.first, 0, merged.first->count());
+        }
+        else
+        {
+            children.push(std::move(merged.first));
+        }
+    }
+
+    node_ptr    m_root;
+    node_ptr    m_tail;
+    std::size_t m_size  = 0;
+    unsigned    m_shift = 0;
+};
+} // namespace detail
+
+template<typename T>
+class rc_transient_vector;
+
+/**
+ * @brief rc_persistent_vector class template is an immutable sequence of T
+ * stored in a relaxed radix balanced tree of rc_ptr managed nodes. Modifying
+ * operations return a new vector sharing all but O(log n) nodes with the
+ * original one, so keeping many versions of a large sequence costs far less
+ * than copying it.
+ *
+ * The nodes branch 32 ways and the last values are kept in a separate tail
+ * buffer, so push_back copies the path to the tree once every 32 values.
+ * concat and slice run in O(log n), the nodes along the seam become relaxed
+ * and keep a table of the sizes of their subtrees.
+ *
+ * For batches of modifications use rc_transient_vector, which updates the
+ * nodes in place when they are not shared with another vector.
+ *
+ * @tparam T
+ */
+template<typename T>
+class rc_persistent_vector
+{
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using const_reference = const T&;
+    using transient_type  = rc_transient_vector<T>;
+
+    /**
+     * @brief Forward iterator visiting the values leaf by leaf.
+     *
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const T*;
+        using reference         = const T&;
+
+        const_iterator() noexcept = default;
+
+        reference operator*() const noexcept
+        {
+            return m_leaf->value(m_index - m_first);
+        }
+
+        pointer operator->() const noexcept
+        {
+            return &**this;
+        }
+
+        const_iterator& operator++() noexcept
+        {
+            ++m_index;
+            if (m_index == m_last && m_index != m_tree->size())
+            {
+                load();
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept
+        {
+            auto result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const const_iterator& other) const noexcept
+        {
+            return (m_index == other.m_index);
+        }
+
+        bool operator!=(const const_iterator& other) const noexcept
+        {
+            return (m_index != other.m_index);
+        }
+
+    private:
+        friend class rc_persistent_vector;
+
+        const_iterator(const detail::pvector_tree<T>& tree,
+                       std::size_t                    index) noexcept :
+            m_tree{ &tree },
+            m_index{ index }
+        {
+            if (m_index != m_tree->size())
+            {
+                load();
+            }
+        }
+
+        void load() noexcept
+        {
+            m_leaf = m_tree->leaf_at(m_index, m_first);
+            m_last = m_first + m_leaf->count();
+        }
+
+        const detail::pvector_tree<T>*  m_tree  = nullptr;
+        const detail::pvector_node<T>* m_leaf  = nullptr;
+        std::size_t                    m_index = 0;
+        std::size_t                    m_first = 0;
+        std::size_t                    m_last  = 0;
+    };
+
+    rc_persistent_vector() noexcept = default;
+
+    rc_persistent_vector(std::initializer_list<T> init) :
+        rc_persistent_vector(init.begin(), init.end())
+    {
+    }
+
+    template<typename InputIt>
+    rc_persistent_vector(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+        {
+            m_tree.emplace_back(*first);
+        }
+    }
+
+    size_type size() const noexcept
+    {
+        return m_tree.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return !m_tree.size();
+    }
+
+    /**
+     * @brief Returns the number of levels of the tree, not counting the tail
+     * buffer. It grows with the logarithm of size(), also for vectors built
+     * by concat.
+     *
+     * @return size_type
+     */
+    size_type height() const noexcept
+    {
+        return m_tree.height();
+    }
+
+    const_reference operator[](size_type index) const noexcept
+    {
+        return m_tree.get(index);
+    }
+
+    const_reference front() const noexcept
+    {
+        return m_tree.get(0);
+    }
+
+    const_reference back() const noexcept
+    {
+        return m_tree.get(size() - 1);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator{ m_tree, 0 };
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator{ m_tree, size() };
+    }
+
+    /**
+     * @brief Returns the vector with value appended.
+     *
+     * @param value
+     * @return rc_persistent_vector
+     */
+    rc_persistent_vector push_back(T value) const
+    {
+        auto result = *this;
+        result.m_tree.emplace_back(std::move(value));
+        return result;
+    }
+
+    /**
+     * @brief Returns the vector with the value at index replaced.
+     *
+     * @param index
+     * @param value
+     * @return rc_persistent_vector
+     */
+    rc_persistent_vector set(size_type index, T value) const
+    {
+        auto result                      = *this;
+        result.m_tree.mutable_value(index) = std::move(value);
+        return result;
+    }
+
+    /**
+     * @brief Returns the vector with the value at index modified by func.
+     *
+     * @tparam Func
+     * @param index
+     * @param func
+     * @return rc_persistent_vector
+     */
+    template<typename Func>
+    rc_persistent_vector update(size_type index, Func&& func) const
+    {
+        auto result = *this;
+        std::forward<Func>(func)(result.m_tree.mutable_value(index));
+        return result;
+    }
+
+    /**
+     * @brief Returns the first count values.
+     *
+     * @param count
+     * @return rc_persistent_vector
+     */
+    rc_persistent_vector take(size_type count) const
+    {
+        auto result = *this;
+        result.m_tree.truncate(std::min(count, size()));
+        return result;
+    }
+
+    /**
+     * @brief Returns the vector without the first count values.
+     *
+     * @param count
+     * @return rc_persistent_vector
+     */
+    rc_persistent_vector drop(size_type count) const
+    {
+        auto result = *this;
+        result.m_tree.drop_front(std::min(count, size()));
+        return result;
+    }
+
+    /**
+     * @brief Returns the values [first, last).
+     *
+     * @param first
+     * @param last
+     * @return rc_persistent_vector
+     */
+    rc_persistent_vector slice(size_type first, size_type last) const
+    {
+        assert(first <= last);
+        return take(last).drop(first);
+    }
+
+    /**
+     * @brief Returns the concatenation of this and other.
+     *
+     * @param other
+     * @return rc_persistent_vector
+     */
+    rc_persistent_vector concat(const rc_persistent_vector& other) const
+    {
+        auto result = *this;
+        result.m_tree.append(other.m_tree);
+        return result;
+    }
+
+    /**
+     * @brief Returns the transient vector starting from the values of this.
+     * Nodes are shared until the transient vector modifies them.
+     *
+     * @return transient_type
+     */
+    transient_type transient() const
+    {
+        return transient_type{ m_tree };
+    }
+
+private:
+    friend class rc_transient_vector<T>;
+
+    explicit rc_persistent_vector(detail::pvector_tree<T> tree) noexcept :
+        m_tree{ std::move(tree) }
+    {
+    }
+
+    detail::pvector_tree<T> m_tree;
+};
+
+/**
+ * @brief rc_transient_vector class template is the mutable builder of
+ * rc_persistent_vector. A node is modified in place when its use_count() is
+ * 1, otherwise it is copied first, so the persistent vectors sharing the
+ * node are never affected.
+ *
+ * @tparam T
+ */
+template<typename T>
+class rc_transient_vector
+{
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using const_reference = const T&;
+
+    rc_transient_vector() noexcept = default;
+
+    size_type size() const noexcept
+    {
+        return m_tree.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return !m_tree.size();
+    }
+
+    const_reference operator[](size_type index) const noexcept
+    {
+        return m_tree.get(index);
+    }
+
+    void push_back(const T& value)
+    {
+        m_tree.emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        m_tree.emplace_back(std::move(value));
+    }
+
+    template<typename... ArgsT>
+    void emplace_back(ArgsT&&... args)
+    {
+        m_tree.emplace_back(std::forward<ArgsT>(args)...);
+    }
+
+    void set(size_type index, T value)
+    {
+        m_tree.mutable_value(index) = std::move(value);
+    }
+
+    template<typename Func>
+    void update(size_type index, Func&& func)
+    {
+        std::forward<Func>(func)(m_tree.mutable_value(index));
+    }
+
+    /**
+     * @brief Keeps the first count values.
+     *
+     * @param count
+     */
+    void truncate(size_type count)
+    {
+        m_tree.truncate(std::min(count, size()));
+    }
+
+    /**
+     * @brief Removes the first count values.
+     *
+     * @param count
+     */
+    void drop_front(size_type count)
+    {
+        m_tree.drop_front(std::min(count, size()));
+    }
+
+    void append(const rc_persistent_vector<T>& other)
+    {
+        m_tree.append(other.m_tree);
+    }
+
+    /**
+     * @brief Returns the persistent vector with the current values. The
+     * transient vector may still be modified afterwards, the shared nodes are
+     * then copied.
+     *
+     * @return rc_persistent_vector<T>
+     */
+    rc_persistent_vector<T> persistent() const&
+    {
+        return rc_persistent_vector<T>{ m_tree };
+    }
+
+    rc_persistent_vector<T> persistent() &&
+    {
+        return rc_persistent_vector<T>{ std::move(m_tree) };
+    }
+
+private:
+    friend class rc_persistent_vector<T>;
+
+    explicit rc_transient_vector(const detail::pvector_tree<T>& tree) :
+        m_tree{ tree }
+    {
+    }
+
+    detail::pvector_tree<T> m_tree;
+};
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
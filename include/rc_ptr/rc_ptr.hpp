@@ -11,9 +11,20 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <new>
 #include <ostream>
 #include <stdexcept>
+#include <vector>
+
+#if __has_include(<span>)
+#include <span>
+#endif
 
 /**
  * @brief Macro controlling the namespace name. Default is "memory".
@@ -23,6 +34,21 @@
 #define RC_PTR_NAMESPACE memory
 #endif
 
+/**
+ * @brief Macro enabling the detection of rc_borrow objects used after the
+ * borrowed object was destroyed. Disabled by default, independently of
+ * NDEBUG, and must be set to the same value in all translation units.
+ *
+ * When enabled, each rc_borrow holds a weak reference, so rc_borrow is not
+ * trivially copyable and the behaviour depending on the weak count changes,
+ * e.g. rc_ptr::emplace allocates a new object while a borrow is alive. The
+ * use of a dangling rc_borrow aborts the program.
+ *
+ */
+#ifndef RC_PTR_CHECK_BORROWS
+#define RC_PTR_CHECK_BORROWS 0
+#endif
+
 /**
  * @brief Namespace name set by RC_PTR_NAMESPACE macro. Default is "memory".
  *
@@ -31,22 +57,43 @@ namespace RC_PTR_NAMESPACE
 {
 namespace detail
 {
-template<typename T, typename Deleter, typename Alloc>
-class control_block
+/**
+ * @brief Operations requested from the control block manager.
+ *
+ */
+enum class block_operation
+{
+    dispose, // Destroy the managed object.
+    destroy  // Destroy the control block and release its memory.
+};
+
+/**
+ * @brief Reference counts shared by all control blocks. The way the managed
+ * object and the block itself are released is decided by the manager function
+ * set by whoever created the block.
+ *
+ */
+class control_block_base
 {
 public:
-    control_block() = delete;
+    using manager_type = void (*)(control_block_base*,
+                                  block_operation) noexcept;
 
-    template<typename D, typename A>
-    control_block(D&& deleter, A allocator) :
+    // Reference count of the blocks that are never released.
+    static constexpr std::size_t immortal_count =
+        std::numeric_limits<std::size_t>::max();
+
+    control_block_base() = delete;
+
+    explicit control_block_base(manager_type manager) noexcept :
         m_ref_count{ 0 },
         m_weak_count{ 0 },
-        m_deleter{ std::forward<D>(deleter) },
-        m_allocator{ allocator }
+        m_manager{ manager }
     {
+        assert(m_manager);
     }
 
-    ~control_block() = default;
+    ~control_block_base() = default;
 
     std::size_t get_ref_count() const noexcept
     {
@@ -60,6 +107,11 @@ public:
 
     void increase_ref_count() noexcept
     {
+        if (m_ref_count == immortal_count)
+        {
+            return;
+        }
+
         ++m_ref_count;
     }
 
@@ -70,6 +122,11 @@ public:
 
     void decrease_ref_count() noexcept
     {
+        if (m_ref_count == immortal_count)
+        {
+            return;
+        }
+
         --m_ref_count;
     }
 
@@ -78,931 +135,3171 @@ public:
         --m_weak_count;
     }
 
-    Deleter& get_deleter() noexcept
+    void increase_ref_count(std::size_t count) noexcept
     {
-        return m_deleter;
+        if (m_ref_count == immortal_count)
+        {
+            return;
+        }
+
+        m_ref_count += count;
     }
 
-    const Deleter& get_deleter() const noexcept
+    // Must not drop the last reference, use release_ref for that.
+    void decrease_ref_count(std::size_t count) noexcept
     {
-        return m_deleter;
+        if (m_ref_count == immortal_count)
+        {
+            return;
+        }
+
+        assert(m_ref_count > count);
+        m_ref_count -= count;
     }
 
-    Alloc get_allocator() noexcept
+    manager_type get_manager() const noexcept
     {
-        return m_allocator;
+        return m_manager;
     }
 
-private:
-    std::size_t m_ref_count;
-    std::size_t m_weak_count;
-    Deleter     m_deleter;
-    Alloc       m_allocator;
-};
-} // namespace detail
-
-/**
- * @brief Exception thrown when rc_ptr is created from expired weak_rc_ptr.
- *
- */
-struct bad_weak_rc_ptr : public std::runtime_error {
-    using base = std::runtime_error;
-    bad_weak_rc_ptr(std::string msg) : base{ std::move(msg) } { }
-};
-
-template<typename T, typename Deleter = std::default_delete<T>,
-         typename Alloc = std::allocator<T>>
-class weak_rc_ptr;
-
-template<typename T>
-class enable_rc_from_this;
-
-/**
- * @brief rc_ptr class template manages shared ownership of an object of
- * type T via the pointer. Multiple rc_ptr objects can manage the
- * single object. The managed object is deleted when the last remaining
- * rc_ptr object is either destroyed or reset.
- *
- * rc_ptr meets CopyConstructible, CopyAssignable, MoveConstructible and
- * MoveAssignable requirements.
- *
- * rc_ptr keeps track of the reference count by allocating the control block
- * internally. By default, it is allocated and deallocated using the
- * std::allocator<T>. The control block is deallocated w1hen the count of both
- * rc_ptr and weak_rc_ptr objects managing a single object reaches zero.
- *
- * Custom deleters may be used to customize the objects
- * destruction.
- *
- * Custom allocator may be provided for internal use to allocate
- * and later deallocate the control block.
- *
- * The class methods are not thread safe.
- *
- * @tparam T Type of the managed object
- * @tparam Deleter Type of the deleter for the destruction of the managed
- * object. Default is std::default_delete<T>.
- * @tparam Alloc Type of the allocator used for allocation and deallocation of
- * the internal control block. Default is std::allocator<T>.
- */
-template<typename T, typename Deleter = std::default_delete<T>,
-         typename Alloc = std::allocator<T>>
-class rc_ptr
-{
-public:
-    using element_type   = std::remove_extent_t<T>;
-    using pointer        = element_type*;
-    using reference      = element_type&;
-    using deleter_type   = Deleter;
-    using allocator_type = Alloc;
-    using weak_type      = weak_rc_ptr<T, deleter_type, allocator_type>;
-
-    /**
-     * @brief Default constructor. Constructs rc_ptr that owns nothing.
-     *
-     */
-    constexpr rc_ptr() noexcept : m_ptr{ pointer() }, m_control_block{ nullptr }
+    bool is_immortal() const noexcept
     {
+        return (m_ref_count == immortal_count);
     }
 
     /**
-     * @brief Constructs rc_ptr that owns nothing.
+     * @brief Pins the block for the rest of the program. The reference count
+     * is not modified afterwards, so neither the managed object nor the block
+     * are ever released.
      *
      */
-    constexpr rc_ptr(std::nullptr_t) noexcept :
-        m_ptr{ pointer() },
-        m_control_block{ nullptr }
+    void make_immortal() noexcept
     {
+        m_ref_count = immortal_count;
     }
 
     /**
-     * @brief Constructs rc_ptr object from the pointer ptr. Takes ownership
-     * over the pointer. Custom deleter and/or custom allocator may be
-     * provided.
+     * @brief Drops one strong reference. Destroys the managed object when it
+     * was the last one and releases the block if no weak references remain.
+     * The manager may instead take a new strong reference while disposing,
+     * which resurrects the object.
      *
-     * @tparam D
-     * @tparam A
-     * @param ptr
-     * @param deleter
-     * @param allocator
      */
-    template<typename D = deleter_type, typename A = allocator_type>
-    rc_ptr(pointer ptr, D&& deleter = D{}, A allocator = A{}) :
-        m_ptr{ ptr },
-        m_control_block{ nullptr }
+    void release_ref() noexcept
     {
-        if (!m_ptr)
+        if (m_ref_count != 1)
         {
+            decrease_ref_count();
             return;
         }
 
-        {
-            auto control_block_allocator =
-                control_block_allocator_type{ allocator };
-            auto mem = control_block_allocator_traits_type::allocate(
-                control_block_allocator,
-                1);
-
-            assert(mem);
-            control_block_allocator_traits_type::construct(
-                control_block_allocator,
-                mem,
-                std::forward<D>(deleter),
-                control_block_allocator);
-
-            m_control_block = mem;
-        }
+        decrease_ref_count();
 
-        m_control_block->increase_ref_count();
-
-        // Additional step for classes deriving from enable_rc_from_this.
-        if constexpr (std::is_base_of_v<enable_rc_from_this<T>, T>)
-        {
-            ptr->m_weak = weak_rc_ptr<T>(*this);
-        }
+        // The object is already expired while being destroyed. The weak
+        // reference held meanwhile keeps the block alive when the object
+        // refers to itself through weak_rc_ptr.
+        increase_weak_count();
+        m_manager(this, block_operation::dispose);
+        release_weak();
     }
 
     /**
-     * @brief Constructs the rc_ptr from the std::unique_ptr. Stored object and
-     * the deleter is transfered to the newly created rc_ptr object.
+     * @brief Drops one weak reference. Releases the block when neither strong
+     * nor weak references remain.
      *
-     * @tparam D
-     * @tparam A
-     * @param ptr
-     * @param allocator
      */
-    template<typename D = deleter_type, typename A = allocator_type>
-    rc_ptr(std::unique_ptr<T, D>&& ptr, A allocator = A{}) :
-        m_ptr{ ptr.get() },
-        m_control_block{ nullptr }
+    void release_weak() noexcept
     {
-        if (!m_ptr)
-        {
-            return;
-        }
+        decrease_weak_count();
 
+        if (m_ref_count != 0 || m_weak_count != 0)
         {
-            auto control_block_allocator =
-                control_block_allocator_type{ allocator };
-            auto mem = control_block_allocator_traits_type::allocate(
-                control_block_allocator,
-                1);
-
-            assert(mem);
-            control_block_allocator_traits_type::construct(
-                control_block_allocator,
-                mem,
-                std::forward<D>(ptr.get_deleter()),
-                control_block_allocator);
-
-            m_control_block = mem;
+            return;
         }
 
-        m_control_block->increase_ref_count();
-        ptr.release(); // Now rc_ptr owns the resource
+        m_manager(this, block_operation::destroy);
     }
 
     /**
-     * @brief Copy constructor.
+     * @brief Releases the block without touching the managed object. Used
+     * when the managed object is already gone.
      *
-     * @param other
      */
-    rc_ptr(const rc_ptr& other) noexcept :
-        m_ptr{ pointer() },
-        m_control_block{ nullptr }
+    void destroy() noexcept
     {
-        *this = other;
+        m_manager(this, block_operation::destroy);
     }
 
-    /**
-     * @brief Move constructor.
-     *
-     * @param other
-     */
-    rc_ptr(rc_ptr&& other) noexcept :
-        m_ptr{ pointer() },
-        m_control_block{ nullptr }
+private:
+    std::size_t  m_ref_count;
+    std::size_t  m_weak_count;
+    manager_type m_manager;
+};
+
+template<typename T, typename Deleter, typename Alloc>
+class control_block : public control_block_base
+{
+public:
+    using pointer = std::remove_extent_t<T>*;
+
+    control_block() = delete;
+
+    template<typename D, typename A>
+    control_block(pointer ptr, D&& deleter, A allocator,
+                  manager_type manager = &control_block::manage) :
+        control_block_base{ manager },
+        m_ptr{ ptr },
+        m_deleter{ std::forward<D>(deleter) },
+        m_allocator{ allocator }
     {
-        *this = std::move(other);
     }
 
-    /**
-     * @brief Constructs rc_ptr from weak_rc_ptr.
-     *
-     * @param other
-     * @throws bad_weak_rc_ptr when other.expired() == true
-     */
-    rc_ptr(const weak_rc_ptr<T, deleter_type, allocator_type>& other) :
-        m_ptr{ pointer() },
-        m_control_block{ nullptr }
+    ~control_block() = default;
+
+    pointer get_pointer() const noexcept
     {
-        *this = other;
+        return m_ptr;
     }
 
-    /**
-     * @brief Copy assignment operator.
-     *
-     * @param other
-     * @return rc_ptr&
-     */
-    rc_ptr& operator=(const rc_ptr& other) noexcept
+    Deleter& get_deleter() noexcept
     {
-        m_control_block = other.m_control_block;
-        m_ptr           = other.get();
-
-        if (!m_control_block)
-        {
-            return *this;
-        }
-
-        m_control_block->increase_ref_count();
-        return *this;
+        return m_deleter;
     }
 
-    /**
-     * @brief Move assignment operator.
-     *
-     * @param other
-     * @return rc_ptr&
-     */
-    rc_ptr& operator=(rc_ptr&& other) noexcept
+    const Deleter& get_deleter() const noexcept
     {
-        if (this == &other)
-        {
-            return *this;
-        }
-
-        m_control_block       = other.m_control_block;
-        other.m_control_block = nullptr;
-        m_ptr                 = other.get();
-        other.m_ptr           = pointer();
-        return *this;
+        return m_deleter;
     }
 
-    /**
-     * @brief Assignment of weak_rc_ptr to rc_tr.
-     *
-     * @param other
-     * @throws bad_weak_rc_ptr when other.expired() == true
-     */
-    rc_ptr& operator=(const weak_rc_ptr<T, deleter_type, allocator_type>& other)
+    Alloc get_allocator() noexcept
     {
-        if (other.expired())
-        {
-            throw bad_weak_rc_ptr("rc_ptr expired.");
-        }
-
-        *this = other.lock();
-        return *this;
+        return m_allocator;
     }
 
-    /**
-     * @brief Destroys rc_ptr object. The managed object is destroyed and the
-     * memory is deallocated when the last remaining rc_ptr managing the object
-     * is destroyed.
-     *
-     */
-    ~rc_ptr()
-    {
-        static_assert(std::is_invocable_v<deleter_type&, pointer>,
-                      "Deleter must be invocable with a pointer.");
-
-        if (!m_control_block)
-        {
-            assert(!m_ptr);
-            return;
-        }
-
-        if (m_control_block->get_ref_count() != 1)
-        {
-            m_control_block->decrease_ref_count();
-            return;
-        }
-
-        if (m_ptr)
-        {
-            get_deleter()(get());
-            m_ptr = pointer();
-        }
+private:
+    using control_block_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<control_block>;
+    using control_block_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<control_block>;
 
-        m_control_block->decrease_ref_count();
+    // Manager of the blocks adopting a pointer, allocated separately from the
+    // managed object.
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
+    {
+        auto block = static_cast<control_block*>(base);
 
-        if (m_control_block->get_weak_count() != 0)
+        switch (operation)
         {
-            return;
-        }
-
+        case block_operation::dispose:
+            block->m_deleter(block->m_ptr);
+            break;
+        case block_operation::destroy:
         {
-            assert(m_control_block);
-            auto control_block_allocator = control_block_allocator_type{
-                m_control_block->get_allocator()
-            };
+            auto control_block_allocator =
+                control_block_allocator_type{ block->get_allocator() };
             control_block_allocator_traits_type::destroy(
                 control_block_allocator,
-                m_control_block);
+                block);
             control_block_allocator_traits_type::deallocate(
                 control_block_allocator,
-                m_control_block,
+                block,
                 1);
+            break;
+        }
         }
-
-        m_control_block = nullptr;
     }
 
-    /**
-     * @brief Returns the stored pointer.
-     *
-     * @return pointer
-     */
-    pointer get() const noexcept
+    pointer m_ptr;
+    Deleter m_deleter;
+    Alloc   m_allocator;
+};
+
+/**
+ * @brief Returns ptr as a void pointer suitable for the placement new.
+ *
+ */
+template<typename U>
+void* voidify(U* ptr) noexcept
+{
+    return const_cast<void*>(static_cast<const volatile void*>(ptr));
+}
+
+/**
+ * @brief Hints the processor to fetch the cache line at ptr for writing.
+ *
+ */
+inline void prefetch_for_write(const void* ptr) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr, 1);
+#else
+    static_cast<void>(ptr);
+#endif
+}
+
+/**
+ * @brief Tag selecting the constructors taking over a reference already
+ * counted by the caller.
+ *
+ */
+struct adopt_ref_t {
+};
+
+inline constexpr adopt_ref_t adopt_ref{};
+
+/**
+ * @brief Constructs the object of type U at ptr. Falls back to the list
+ * initialization when U is not constructible from args, for aggregates.
+ *
+ */
+template<typename U, typename... ArgsT>
+U* construct_object(U* ptr, ArgsT&&... args)
+{
+    if constexpr (std::is_constructible_v<U, ArgsT...>)
     {
-        return m_ptr;
+        return ::new (voidify(ptr)) U(std::forward<ArgsT>(args)...);
     }
-
-    /**
-     * @brief Returns a reference to the deleter.
-     *
-     * @return const deleter_type&
-     */
-    const deleter_type& get_deleter() const noexcept
+    else
     {
-        assert(m_control_block);
-        return m_control_block->get_deleter();
+        return ::new (voidify(ptr)) U{ std::forward<ArgsT>(args)... };
     }
+}
 
-    /**
-     * @brief Returns a reference to the deleter.
-     *
-     * @return deleter_type&
-     */
-    deleter_type& get_deleter() noexcept
+/**
+ * @brief Constructs the object of type U at ptr with the list initialization
+ * used by make_rc. Without arguments the object is value initialized, so
+ * aggregates deriving from a base with a protected constructor, e.g.
+ * enable_inplace_rc_from_this, can be created.
+ *
+ */
+template<typename U, typename... ArgsT>
+U* list_construct_object(U* ptr, ArgsT&&... args)
+{
+    if constexpr (sizeof...(ArgsT) == 0)
     {
-        assert(m_control_block);
-        return m_control_block->get_deleter();
+        return ::new (voidify(ptr)) U();
     }
-
-    /**
-     * @brief Returns a copy of the allocator.
-     *
-     * @return deleter_type&
-     */
-    allocator_type get_allocator() noexcept
+    else
     {
-        assert(m_control_block);
-        return m_control_block->get_allocator();
+        return ::new (voidify(ptr)) U{ std::forward<ArgsT>(args)... };
     }
+}
 
-    /**
-     * @brief Returns the current number of rc_ptr objects owning the
-     * resource.
-     *
-     * @return std::size_t
-     */
-    std::size_t use_count() const noexcept
+/**
+ * @brief Describes the fused allocation placing the managed object(s) of type
+ * U directly behind the control block of type Block. The memory is
+ * allocated in units aligned for both of the types.
+ *
+ * @tparam Block
+ * @tparam U
+ */
+template<typename Block, typename U>
+struct inplace_layout
+{
+    static constexpr std::size_t alignment =
+        std::max(alignof(Block), alignof(U));
+
+    static constexpr std::size_t offset =
+        (sizeof(Block) + alignof(U) - 1) / alignof(U) * alignof(U);
+
+    struct alignas(alignment) unit
     {
-        return (!m_control_block) ? 0 : m_control_block->get_ref_count();
-    }
+        unsigned char bytes[alignment];
+    };
 
-    /**
-     * @brief Checks whether the instance of rc_ptr is the only one managing
-     * the resource.
-     *
-     * @return true if reference count is equal to zero
-     * @return false otherwise
-     */
-    bool unique() const noexcept
+    static constexpr std::size_t units(std::size_t count) noexcept
     {
-        return (use_count() == 1);
+        return (offset + count * sizeof(U) + alignment - 1) / alignment;
     }
 
-    /**
-     * @brief Releases the ownerhip of the managed object.
-     *
-     */
-    void reset() noexcept
+    // Returns the number of units holding count objects, throwing
+    // std::bad_array_new_length if it overflows std::size_t.
+    static std::size_t units_for(std::size_t count)
     {
-        rc_ptr().swap(*this);
+        constexpr auto max_bytes =
+            std::numeric_limits<std::size_t>::max() / alignment * alignment;
+        if (count > (max_bytes - offset) / sizeof(U))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        return units(count);
     }
 
-    /**
-     * @brief Swaps contents with other rc_ptr object.
-     *
-     * @param other
-     */
-    void swap(rc_ptr& other) noexcept
+    static U* object(void* block) noexcept
     {
-        std::swap(m_control_block, other.m_control_block);
-        std::swap(m_ptr, other.m_ptr);
+        return reinterpret_cast<U*>(static_cast<unsigned char*>(block) +
+                                    offset);
     }
 
-    /**
-     * @brief Checks whether the current rc_ptr object precedes other.
-     *
-     * @tparam U
-     * @tparam D
-     * @tparam A
-     * @param other
-     * @return true
-     * @return false
-     */
-    template<typename U, typename D, typename A>
-    bool owner_before(const rc_ptr<U, D, A>& other) const noexcept
+    static Block* block(U* object) noexcept
     {
-        return other.m_control_block < m_control_block;
+        return reinterpret_cast<Block*>(
+            static_cast<unsigned char*>(voidify(object)) - offset);
     }
+};
 
-    /**
-     * @brief Checks whether the current rc_ptr object precedes other.
-     *
-     * @tparam U
-     * @tparam D
-     * @tparam A
-     * @param other
-     * @return true
-     * @return false
-     */
-    template<typename U, typename D, typename A>
-    bool owner_before(const weak_rc_ptr<U, D, A>& other) const noexcept
+/**
+ * @brief Control block sharing one allocation with the managed object.
+ * Created by make_rc.
+ *
+ * @tparam T
+ * @tparam Deleter Stored only for the rc_ptr interface, never invoked.
+ * @tparam Alloc
+ */
+template<typename T, typename Deleter, typename Alloc>
+struct inplace_block
+{
+    using block_type  = control_block<T, Deleter, Alloc>;
+    using layout_type = inplace_layout<block_type, T>;
+    using unit_type   = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    template<typename... ArgsT>
+    static block_type* create(const Alloc& allocator, ArgsT&&... args)
     {
-        return other.m_control_block < m_control_block;
+        auto unit_allocator = unit_allocator_type{ allocator };
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator,
+                                                 layout_type::units(1));
+
+        assert(mem);
+        T* object = layout_type::object(mem);
+
+        // The block is constructed first, so the object under construction
+        // can find it with no references taken yet.
+        auto block = ::new (static_cast<void*>(mem))
+            block_type{ object, Deleter{}, allocator, &inplace_block::manage };
+
+        try
+        {
+            list_construct_object(object, std::forward<ArgsT>(args)...);
+        }
+        catch (...)
+        {
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(unit_allocator,
+                                                   mem,
+                                                   layout_type::units(1));
+            throw;
+        }
+
+        return block;
     }
 
-    /**
-     * @brief Implicit conversion to bool. Compares the stored pointer to
-     * nullptr.
-     *
-     * @return true if stored pointer is not nullptr.
-     * @return false otherwise
-     */
-    operator bool() const noexcept
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
     {
-        return static_cast<bool>(get());
+        auto block = static_cast<block_type*>(base);
+
+        switch (operation)
+        {
+        case block_operation::dispose:
+            std::destroy_at(block->get_pointer());
+            break;
+        case block_operation::destroy:
+        {
+            auto unit_allocator = unit_allocator_type{ block->get_allocator() };
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(block),
+                layout_type::units(1));
+            break;
+        }
+        }
     }
+};
 
-    /**
-     * @brief Dereferences the stored pointer and returns a reference to the
-     * value. Undefined behaviour if the stored pointer is not valid.
-     *
-     * @return reference
-     */
-    reference operator*() const noexcept
+/**
+ * @brief Number of elements referred to by rc_ptr<T[]> and weak_rc_ptr<T[]>.
+ * Empty for other types.
+ *
+ * @tparam T
+ */
+template<typename T>
+class extent_storage
+{
+protected:
+    constexpr extent_storage(std::size_t = 0) noexcept { }
+
+    constexpr std::size_t get_extent() const noexcept
     {
-        assert(get());
-        return *get();
+        return 0;
     }
 
-    /**
-     * @brief Dereferences the stored pointer and returns a reference to the
-     * value. Undefined behaviour if the stored pointer is not valid.
-     *
-     * @return pointer
-     */
-    pointer operator->() const noexcept
+    void swap_extent(extent_storage&) noexcept { }
+};
+
+template<typename T>
+class extent_storage<T[]>
+{
+protected:
+    constexpr extent_storage(std::size_t extent = 0) noexcept :
+        m_extent{ extent }
     {
-        assert(get());
-        return get();
     }
 
-    /**
-     * @brief Provides index based access to the stored array.
-     *
-     * @param index
-     * @return element_type&
-     */
-    element_type& operator[](const std::ptrdiff_t index) const
+    constexpr std::size_t get_extent() const noexcept
     {
-        assert(get());
-        return get()[index];
+        return m_extent;
+    }
+
+    void swap_extent(extent_storage& other) noexcept
+    {
+        std::swap(m_extent, other.m_extent);
     }
 
 private:
-    using allocator_traits = std::allocator_traits<allocator_type>;
-    using control_block_type =
-        detail::control_block<T, deleter_type, allocator_type>;
+    std::size_t m_extent;
+};
 
-    using control_block_allocator_type = typename std::allocator_traits<
-        allocator_type>::template rebind_alloc<control_block_type>;
-    using control_block_allocator_traits_type = typename std::allocator_traits<
-        allocator_type>::template rebind_traits<control_block_type>;
+/**
+ * @brief Control block of an array sharing one allocation with its elements.
+ *
+ */
+template<typename T, typename Deleter, typename Alloc>
+class array_control_block : public control_block<T, Deleter, Alloc>
+{
+public:
+    using base_type = control_block<T, Deleter, Alloc>;
+    using pointer   = typename base_type::pointer;
 
-    friend class weak_rc_ptr<T, deleter_type, allocator_type>;
+    template<typename D, typename A>
+    array_control_block(pointer                              ptr,
+                        std::size_t                          size,
+                        D&&                                  deleter,
+                        A                                    allocator,
+                        control_block_base::manager_type     manager) :
+        base_type{ ptr, std::forward<D>(deleter), allocator, manager },
+        m_size{ size }
+    {
+    }
 
-    rc_ptr(pointer ptr, control_block_type* control_block) :
-        m_ptr{ ptr },
-        m_control_block{ control_block }
+    std::size_t get_size() const noexcept
     {
-        assert(m_ptr);
-        assert(m_control_block);
-        m_control_block->increase_ref_count();
+        return m_size;
     }
 
-    pointer             m_ptr;
-    control_block_type* m_control_block;
+private:
+    std::size_t m_size;
 };
 
 /**
- * @brief Outputs the value of get() to the output stream.
+ * @brief Control block followed by the array of elements of type
+ * std::remove_extent_t<T>, in a single allocation. Created by make_rc<T[]>.
  *
- * @tparam CharT
- * @tparam Traits
- * @tparam U
- * @tparam D
- * @tparam A
- * @param os
- * @param ptr
- * @return std::basic_ostream<CharT, Traits>&
+ * @tparam T Array type
+ * @tparam Deleter Stored only for the rc_ptr interface, never invoked.
+ * @tparam Alloc
  */
-template<typename CharT, typename Traits, typename U, typename D, typename A>
-std::basic_ostream<CharT, Traits>&
-    operator<<(std::basic_ostream<CharT, Traits>& os,
-               const rc_ptr<U, D, A>&             ptr)
+template<typename T, typename Deleter, typename Alloc>
+struct inplace_array_block
 {
-    return os << ptr.get();
-}
+    using element_type = std::remove_extent_t<T>;
+    using value_type   = std::remove_cv_t<element_type>;
+    using block_type   = array_control_block<T, Deleter, Alloc>;
+    using layout_type  = inplace_layout<block_type, element_type>;
+    using unit_type    = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    // Initializer is invoked with the pointer to uninitialized elements and
+    // must construct all of them.
+    template<typename Initializer>
+    static block_type* create(const Alloc& allocator, std::size_t size,
+                              Initializer&& initializer)
+    {
+        auto unit_allocator = unit_allocator_type{ allocator };
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator,
+                                                 layout_type::units_for(size));
+
+        assert(mem);
+        element_type* elements = layout_type::object(mem);
+
+        try
+        {
+            initializer(const_cast<value_type*>(elements));
+        }
+        catch (...)
+        {
+            unit_allocator_traits_type::deallocate(unit_allocator,
+                                                   mem,
+                                                   layout_type::units(size));
+            throw;
+        }
+
+        return ::new (static_cast<void*>(mem)) block_type{
+            elements, size, Deleter{}, allocator, &inplace_array_block::manage
+        };
+    }
+
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
+    {
+        auto block = static_cast<block_type*>(base);
+
+        switch (operation)
+        {
+        case block_operation::dispose:
+            std::destroy_n(block->get_pointer(), block->get_size());
+            break;
+        case block_operation::destroy:
+        {
+            auto unit_allocator = unit_allocator_type{ block->get_allocator() };
+            auto size           = block->get_size();
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(block),
+                layout_type::units(size));
+            break;
+        }
+        }
+    }
+};
 
 /**
- * @brief weak_rc_ptr is a smart pointer that represents a weak reference to the
- * resource.
+ * @brief Describes the fused allocation of the control block of type Block,
+ * the header of type Header and the trailing array of elements of type Elem.
+ * The number of elements is stored right in front of the header, so the
+ * trailer can be found from the header alone.
  *
- * rc_ptr object can be constructed from weak_rc_ptr object by using the
- * lock() method or by assignment.
- *
- * @tparam T
- * @tparam Deleter
- * @tparam Alloc
+ * @tparam Block
+ * @tparam Header
+ * @tparam Elem
  */
-template<typename T, typename Deleter, typename Alloc>
-class weak_rc_ptr
+template<typename Block, typename Header, typename Elem>
+struct flex_layout
 {
-public:
-    using element_type   = std::remove_extent_t<T>;
-    using pointer        = element_type*;
-    using reference      = element_type&;
-    using deleter_type   = Deleter;
-    using allocator_type = Alloc;
+    static constexpr std::size_t header_alignment =
+        std::max({ alignof(Header), alignof(Elem), alignof(std::size_t) });
 
-    /**
-     * @brief Default constructor. Constructs an empty weak_rc_ptr object.
-     *
-     */
-    constexpr weak_rc_ptr() : m_ptr{ pointer() }, m_control_block{ nullptr } { }
+    static constexpr std::size_t alignment =
+        std::max(alignof(Block), header_alignment);
 
-    /**
-     * @brief Copy constructor.
-     *
-     * @param other
-     */
-    weak_rc_ptr(const weak_rc_ptr& other) :
-        m_ptr{ pointer() },
-        m_control_block{ nullptr }
+    static constexpr std::size_t header_offset =
+        (sizeof(Block) + sizeof(std::size_t) + header_alignment - 1) /
+        header_alignment * header_alignment;
+
+    // Offset of the trailer relative to the header.
+    static constexpr std::size_t trailer_offset =
+        (sizeof(Header) + alignof(Elem) - 1) / alignof(Elem) * alignof(Elem);
+
+    struct alignas(alignment) unit
     {
-        *this = other;
-    }
+        unsigned char bytes[alignment];
+    };
 
-    /**
-     * @brief Move constructor.
-     *
-     * @param other
-     */
-    weak_rc_ptr(weak_rc_ptr&& other) :
-        m_ptr{ pointer() },
-        m_control_block{ nullptr }
+    static constexpr std::size_t units(std::size_t count) noexcept
     {
-        *this = std::move(other);
+        return (header_offset + trailer_offset + count * sizeof(Elem) +
+                alignment - 1) /
+               alignment;
     }
 
-    /**
-     * @brief Constructs the weak_rc_ptr from the rc_ptr.
-     *
-     * @param other
-     */
-    weak_rc_ptr(const rc_ptr<T, deleter_type, allocator_type>& other) :
-        m_ptr{ pointer() },
-        m_control_block{ nullptr }
+    // Returns the number of units holding the header and count trailing
+    // elements, throwing std::bad_array_new_length if it overflows
+    // std::size_t.
+    static std::size_t units_for(std::size_t count)
     {
-        if (!other.get())
+        constexpr auto max_bytes =
+            std::numeric_limits<std::size_t>::max() / alignment * alignment;
+        if (count > (max_bytes - header_offset - trailer_offset) / sizeof(Elem))
         {
-            return;
+            throw std::bad_array_new_length();
         }
 
-        assert(other.m_control_block);
-        m_ptr           = other.get();
-        m_control_block = other.m_control_block;
-        m_control_block->increase_weak_count();
+        return units(count);
     }
 
-    /**
-     * @brief Destroys weak_rc_ptr.
-     *
-     */
-    ~weak_rc_ptr()
+    static Header* header(void* block) noexcept
     {
-        if (!m_control_block)
-        {
-            assert(!m_ptr);
-            return;
-        }
+        return reinterpret_cast<Header*>(static_cast<unsigned char*>(block) +
+                                         header_offset);
+    }
 
-        m_control_block->decrease_weak_count();
+    static std::size_t* count(const volatile void* header) noexcept
+    {
+        return reinterpret_cast<std::size_t*>(
+                   const_cast<unsigned char*>(
+                       static_cast<const volatile unsigned char*>(header))) -
+               1;
+    }
 
-        if (m_control_block->get_ref_count() != 0)
-        {
-            return;
-        }
+    static Elem* trailer(const volatile void* header) noexcept
+    {
+        return reinterpret_cast<Elem*>(
+            const_cast<unsigned char*>(
+                static_cast<const volatile unsigned char*>(header)) +
+            trailer_offset);
+    }
+};
 
-        if (m_control_block->get_weak_count() != 0)
+/**
+ * @brief Control block followed by the header of type T and the array of
+ * elements of type Elem, in a single allocation. Created by make_rc_flex.
+ *
+ * @tparam T Header type
+ * @tparam Elem
+ * @tparam Deleter Stored only for the rc_ptr interface, never invoked.
+ * @tparam Alloc
+ */
+template<typename T, typename Elem, typename Deleter, typename Alloc>
+struct inplace_flex_block
+{
+    using value_type  = std::remove_cv_t<Elem>;
+    using block_type  = control_block<T, Deleter, Alloc>;
+    using layout_type = flex_layout<block_type, T, Elem>;
+    using unit_type   = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    // The trailer is value initialized before the header, so the constructor
+    // of the header may fill it.
+    template<typename... ArgsT>
+    static block_type* create(const Alloc& allocator, std::size_t count,
+                              ArgsT&&... args)
+    {
+        auto unit_allocator = unit_allocator_type{ allocator };
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator,
+                                                 layout_type::units_for(count));
+
+        assert(mem);
+        T*    header  = layout_type::header(mem);
+        auto* trailer = const_cast<value_type*>(layout_type::trailer(header));
+        ::new (static_cast<void*>(layout_type::count(header)))
+            std::size_t{ count };
+
+        auto block = ::new (static_cast<void*>(mem)) block_type{
+            header, Deleter{}, allocator, &inplace_flex_block::manage
+        };
+
+        try
         {
-            return;
+            std::uninitialized_value_construct_n(trailer, count);
+
+            try
+            {
+                construct_object(header, std::forward<ArgsT>(args)...);
+            }
+            catch (...)
+            {
+                std::destroy_n(trailer, count);
+                throw;
+            }
         }
-
+        catch (...)
         {
-            assert(m_control_block);
-            auto control_block_allocator = control_block_allocator_type{
-                m_control_block->get_allocator()
-            };
-            control_block_allocator_traits_type::destroy(
-                control_block_allocator,
-                m_control_block);
-            control_block_allocator_traits_type::deallocate(
-                control_block_allocator,
-                m_control_block,
-                1);
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(unit_allocator,
+                                                   mem,
+                                                   layout_type::units(count));
+            throw;
         }
 
-        m_control_block = nullptr;
+        return block;
     }
 
-    /**
-     * @brief Copy assignment operator.
-     *
-     * @param other
-     * @return weak_rc_ptr&
-     */
-    weak_rc_ptr& operator=(const weak_rc_ptr& other)
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
     {
-        if (!other.m_control_block)
+        auto block  = static_cast<block_type*>(base);
+        auto header = block->get_pointer();
+        auto count  = *layout_type::count(header);
+
+        switch (operation)
         {
-            assert(!other.m_ptr);
-            return *this;
+        case block_operation::dispose:
+            std::destroy_at(header);
+            std::destroy_n(layout_type::trailer(header), count);
+            break;
+        case block_operation::destroy:
+        {
+            auto unit_allocator = unit_allocator_type{ block->get_allocator() };
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(block),
+                layout_type::units(count));
+            break;
         }
+        }
+    }
+};
 
-        m_ptr           = other.m_ptr;
-        m_control_block = other.m_control_block;
-        m_control_block->increase_weak_count();
-        return *this;
+/**
+ * @brief Control block of an object placed in a slab shared with other
+ * independently owned objects.
+ *
+ */
+template<typename T, typename Deleter, typename Alloc>
+class slab_control_block : public control_block<T, Deleter, Alloc>
+{
+public:
+    using base_type = control_block<T, Deleter, Alloc>;
+    using pointer   = typename base_type::pointer;
+
+    struct slab_header
+    {
+        std::size_t live_blocks;
+        std::size_t units;
+    };
+
+    template<typename D, typename A>
+    slab_control_block(pointer                          ptr,
+                       slab_header*                     slab,
+                       D&&                              deleter,
+                       A                                allocator,
+                       control_block_base::manager_type manager) :
+        base_type{ ptr, std::forward<D>(deleter), allocator, manager },
+        m_slab{ slab }
+    {
     }
 
-    /**
-     * @brief Move assignment operator.
-     *
-     * @param other
-     * @return weak_rc_ptr&
-     */
-    weak_rc_ptr& operator=(weak_rc_ptr&& other)
+    slab_header* get_slab() const noexcept
     {
-        if (this == &other)
+        return m_slab;
+    }
+
+private:
+    slab_header* m_slab;
+};
+
+/**
+ * @brief Single allocation holding count control blocks, each followed by
+ * its object. The objects are owned and destroyed independently, the
+ * allocation is released together with the last control block. Created by
+ * make_rc_n.
+ *
+ * @tparam T
+ * @tparam Deleter Stored only for the rc_ptr interface, never invoked.
+ * @tparam Alloc
+ */
+template<typename T, typename Deleter, typename Alloc>
+struct slab_block
+{
+    using block_type  = slab_control_block<T, Deleter, Alloc>;
+    using slab_header = typename block_type::slab_header;
+    using layout_type = inplace_layout<block_type, T>;
+    using unit_type   = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    static constexpr std::size_t header_units =
+        (sizeof(slab_header) + sizeof(unit_type) - 1) / sizeof(unit_type);
+
+    static constexpr std::size_t stride = layout_type::units(1);
+
+    // Creates count blocks, constructing the object i from init(i). Once all
+    // of them are constructed, each block is passed to emit, which must not
+    // throw.
+    template<typename Init, typename Emit>
+    static void create(const Alloc& allocator, std::size_t count, Init& init,
+                       Emit&& emit)
+    {
+        if (count == 0)
         {
-            return *this;
+            return;
         }
 
-        m_ptr                 = other.m_ptr;
-        other.m_ptr           = pointer();
-        m_control_block       = other.m_control_block;
-        other.m_control_block = nullptr;
-        return *this;
-    }
+        auto unit_allocator = unit_allocator_type{ allocator };
+        auto units          = units_for(count);
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator, units);
 
-    /**
-     * @brief Assigns rc_ptr to weak_rc_ptr.
-     *
-     * @param other
-     */
-    weak_rc_ptr& operator=(const rc_ptr<T, deleter_type, allocator_type>& other)
-    {
-        m_ptr           = other.m_ptr;
-        m_control_block = other.m_control_block;
+        assert(mem);
+        auto slab = ::new (static_cast<void*>(mem)) slab_header{ count, units };
 
-        if (!m_control_block)
+        std::size_t constructed = 0;
+
+        try
         {
-            return *this;
+            for (; constructed < count; ++constructed)
+            {
+                auto place  = mem + header_units + constructed * stride;
+                T*   object = layout_type::object(place);
+                ::new (voidify(object)) T(init(constructed));
+                ::new (static_cast<void*>(place))
+                    block_type{ object,
+                                slab,
+                                Deleter{},
+                                allocator,
+                                &slab_block::manage };
+            }
+        }
+        catch (...)
+        {
+            for (std::size_t i = 0; i < constructed; ++i)
+            {
+                auto block = block_at(mem, i);
+                std::destroy_at(block->get_pointer());
+                std::destroy_at(block);
+            }
+
+            unit_allocator_traits_type::deallocate(unit_allocator, mem, units);
+            throw;
         }
 
-        m_control_block->increase_weak_count();
-        return *this;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            emit(block_at(mem, i));
+        }
     }
 
-    /**
-     * @brief Checks if the managed object was deleted.
-     *
-     * @return true
-     * @return false
-     */
-    bool expired() const noexcept
+    // Returns the size of the slab holding count blocks, throwing
+    // std::bad_array_new_length if it overflows std::size_t.
+    static std::size_t units_for(std::size_t count)
     {
-        return (!m_control_block || m_control_block->get_ref_count() == 0);
+        constexpr auto max_units =
+            std::numeric_limits<std::size_t>::max() / sizeof(unit_type);
+        if (count > (max_units - header_units) / stride)
+        {
+            throw std::bad_array_new_length();
+        }
+
+        return header_units + count * stride;
     }
 
-    /**
-     * @brief Returns a reference to the deleter.
-     *
-     * @return const deleter_type&
-     */
-    const deleter_type& get_deleter() const noexcept
+    static block_type* block_at(unit_type* mem, std::size_t index) noexcept
     {
-        assert(m_control_block);
-        return m_control_block->get_deleter();
+        return std::launder(reinterpret_cast<block_type*>(
+            mem + header_units + index * stride));
     }
 
-    /**
-     * @brief Returns a reference to the deleter.
-     *
-     * @return deleter_type&
-     */
-    deleter_type& get_deleter() noexcept
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
     {
-        assert(m_control_block);
-        return m_control_block->get_deleter();
+        auto block = static_cast<block_type*>(base);
+
+        switch (operation)
+        {
+        case block_operation::dispose:
+            std::destroy_at(block->get_pointer());
+            break;
+        case block_operation::destroy:
+        {
+            auto unit_allocator = unit_allocator_type{ block->get_allocator() };
+            auto slab           = block->get_slab();
+            std::destroy_at(block);
+
+            if (--slab->live_blocks != 0)
+            {
+                return;
+            }
+
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(slab),
+                slab->units);
+            break;
+        }
+        }
     }
+};
 
-    /**
-     * @brief Returns a copy of the allocator.
-     *
-     * @return deleter_type&
+template<typename T>
+constexpr bool is_unbounded_array_v =
+    std::is_array_v<T> && std::extent_v<T> == 0;
+
+struct rc_ptr_access;
+
+// Common base of enable_inplace_rc_from_this specializations.
+struct enable_inplace_rc_from_this_base
+{
+};
+} // namespace detail
+
+/**
+ * @brief Exception thrown when rc_ptr is created from expired weak_rc_ptr.
+ *
+ */
+struct bad_weak_rc_ptr : public std::runtime_error {
+    using base = std::runtime_error;
+    bad_weak_rc_ptr(std::string msg) : base{ std::move(msg) } { }
+};
+
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc = std::allocator<T>>
+class weak_rc_ptr;
+
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc = std::allocator<T>>
+class rc_borrow;
+
+template<typename T>
+class enable_rc_from_this;
+
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc = std::allocator<T>>
+class enable_inplace_rc_from_this;
+
+namespace detail
+{
+// True unless T derives from enable_inplace_rc_from_this with other template
+// arguments, e.g. through a base class, so rc_from_this would not find the
+// control block in front of the object.
+template<typename T, typename Deleter, typename Alloc>
+inline constexpr bool is_inplace_rc_from_this_compatible_v =
+    !std::is_base_of_v<enable_inplace_rc_from_this_base, T> ||
+    std::is_base_of_v<enable_inplace_rc_from_this<T, Deleter, Alloc>, T>;
+} // namespace detail
+
+/**
+ * @brief rc_ptr class template manages shared ownership of an object of
+ * type T via the pointer. Multiple rc_ptr objects can manage the
+ * single object. The managed object is deleted when the last remaining
+ * rc_ptr object is either destroyed or reset.
+ *
+ * rc_ptr meets CopyConstructible, CopyAssignable, MoveConstructible and
+ * MoveAssignable requirements.
+ *
+ * rc_ptr keeps track of the reference count by allocating the control block
+ * internally. By default, it is allocated and deallocated using the
+ * std::allocator<T>. The control block is deallocated w1hen the count of both
+ * rc_ptr and weak_rc_ptr objects managing a single object reaches zero.
+ *
+ * Custom deleters may be used to customize the objects
+ * destruction.
+ *
+ * Custom allocator may be provided for internal use to allocate
+ * and later deallocate the control block.
+ *
+ * rc_ptr<T[]> created by make_rc<T[]> or allocate_rc<T[]> knows the number
+ * of elements, exposes them as a range and checks the indices in debug
+ * builds. The size of arrays adopted from a raw pointer is unknown and
+ * reported as zero.
+ *
+ * The class methods are not thread safe.
+ *
+ * @tparam T Type of the managed object
+ * @tparam Deleter Type of the deleter for the destruction of the managed
+ * object. Default is std::default_delete<T>.
+ * @tparam Alloc Type of the allocator used for allocation and deallocation of
+ * the internal control block. Default is std::allocator<T>.
+ */
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc = std::allocator<T>>
+class rc_ptr : private detail::extent_storage<T>
+{
+public:
+    using element_type   = std::remove_extent_t<T>;
+    using pointer        = element_type*;
+    using reference      = element_type&;
+    using deleter_type   = Deleter;
+    using allocator_type = Alloc;
+    using weak_type      = weak_rc_ptr<T, deleter_type, allocator_type>;
+
+    /**
+     * @brief Default constructor. Constructs rc_ptr that owns nothing.
+     *
      */
-    allocator_type get_allocator() noexcept
+    constexpr rc_ptr() noexcept : m_ptr{ pointer() }, m_control_block{ nullptr }
     {
-        assert(m_control_block);
-        return m_control_block->get_allocator();
     }
 
     /**
-     * @brief Returns the current number of rc_ptr objects owning the
-     * resource.
+     * @brief Constructs rc_ptr that owns nothing.
      *
-     * @return std::size_t
      */
-    std::size_t use_count() const noexcept
+    constexpr rc_ptr(std::nullptr_t) noexcept :
+        m_ptr{ pointer() },
+        m_control_block{ nullptr }
     {
-        return (!m_control_block) ? 0 : m_control_block->get_ref_count();
     }
 
     /**
-     * @brief Creates rc_ptr managing the stored object. If expired() == true,
-     * the default constructed rc_ptr is returned.
+     * @brief Constructs rc_ptr object from the pointer ptr. Takes ownership
+     * over the pointer. Custom deleter and/or custom allocator may be
+     * provided.
      *
-     * @return rc_ptr<T, deleter_type, allocator_type>
+     * @tparam D
+     * @tparam A
+     * @param ptr
+     * @param deleter
+     * @param allocator
      */
-    rc_ptr<T, deleter_type, allocator_type> lock() const noexcept
+    template<typename D = deleter_type, typename A = allocator_type>
+    rc_ptr(pointer ptr, D&& deleter = D{}, A allocator = A{}) :
+        m_ptr{ ptr },
+        m_control_block{ nullptr }
     {
-        return expired() ?
-                   rc_ptr<T, deleter_type, allocator_type>{} :
-                   rc_ptr<T, deleter_type, allocator_type>{ m_ptr,
-                                                            m_control_block };
+        static_assert(
+            !std::is_base_of_v<detail::enable_inplace_rc_from_this_base, T>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "by make_rc or allocate_rc.");
+
+        if (!m_ptr)
+        {
+            return;
+        }
+
+        {
+            auto control_block_allocator =
+                control_block_allocator_type{ allocator };
+            auto mem = control_block_allocator_traits_type::allocate(
+                control_block_allocator,
+                1);
+
+            assert(mem);
+            control_block_allocator_traits_type::construct(
+                control_block_allocator,
+                mem,
+                ptr,
+                std::forward<D>(deleter),
+                control_block_allocator);
+
+            m_control_block = mem;
+        }
+
+        m_control_block->increase_ref_count();
+        enable_rc_from_this_hook();
     }
 
     /**
-     * @brief Releases the ownerhip of the managed object.
+     * @brief Constructs the rc_ptr from the std::unique_ptr. Stored object and
+     * the deleter is transfered to the newly created rc_ptr object.
      *
+     * @tparam D
+     * @tparam A
+     * @param ptr
+     * @param allocator
      */
-    void reset() noexcept
+    template<typename D = deleter_type, typename A = allocator_type>
+    rc_ptr(std::unique_ptr<T, D>&& ptr, A allocator = A{}) :
+        m_ptr{ ptr.get() },
+        m_control_block{ nullptr }
     {
-        weak_rc_ptr().swap(*this);
+        static_assert(
+            !std::is_base_of_v<detail::enable_inplace_rc_from_this_base, T>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "by make_rc or allocate_rc.");
+
+        if (!m_ptr)
+        {
+            return;
+        }
+
+        {
+            auto control_block_allocator =
+                control_block_allocator_type{ allocator };
+            auto mem = control_block_allocator_traits_type::allocate(
+                control_block_allocator,
+                1);
+
+            assert(mem);
+            control_block_allocator_traits_type::construct(
+                control_block_allocator,
+                mem,
+                ptr.get(),
+                std::forward<D>(ptr.get_deleter()),
+                control_block_allocator);
+
+            m_control_block = mem;
+        }
+
+        m_control_block->increase_ref_count();
+        ptr.release(); // Now rc_ptr owns the resource
     }
 
     /**
-     * @brief Swaps contents with other weak_rc_ptr object.
+     * @brief Copy constructor.
      *
      * @param other
      */
-    void swap(weak_rc_ptr& other) noexcept
+    rc_ptr(const rc_ptr& other) noexcept :
+        extent_storage_type{ other.get_extent() },
+        m_ptr{ other.m_ptr },
+        m_control_block{ other.m_control_block }
     {
-        std::swap(m_control_block, other.m_control_block);
-        std::swap(m_ptr, other.m_ptr);
+        if (!m_control_block)
+        {
+            return;
+        }
+
+        m_control_block->increase_ref_count();
     }
 
     /**
-     * @brief Checks whether the current rc_ptr object precedes other.
+     * @brief Move constructor.
      *
-     * @tparam U
-     * @tparam D
-     * @tparam A
      * @param other
-     * @return true
-     * @return false
      */
-    template<typename U, typename D, typename A>
-    bool owner_before(const rc_ptr<U, D, A>& other) const noexcept
+    rc_ptr(rc_ptr&& other) noexcept :
+        m_ptr{ pointer() },
+        m_control_block{ nullptr }
     {
-        return other.m_control_block < m_control_block;
+        swap(other);
     }
 
     /**
-     * @brief Checks whether the current rc_ptr object precedes other.
+     * @brief Aliasing constructor. Constructs rc_ptr sharing the ownership
+     * with owner, but storing ptr. Usually ptr points to a member or a part of
+     * the object managed by owner. When owner is empty, the constructed rc_ptr
+     * is empty as well.
+     *
+     * @param owner
+     * @param ptr
+     */
+    rc_ptr(const rc_ptr& owner, pointer ptr) noexcept :
+        m_ptr{ owner.m_control_block ? ptr : pointer() },
+        m_control_block{ owner.m_control_block }
+    {
+        if (!m_control_block)
+        {
+            return;
+        }
+
+        m_control_block->increase_ref_count();
+    }
+
+    /**
+     * @brief Constructs rc_ptr from weak_rc_ptr.
      *
-     * @tparam U
-     * @tparam D
-     * @tparam A
      * @param other
-     * @return true
-     * @return false
+     * @throws bad_weak_rc_ptr when other.expired() == true
      */
-    template<typename U, typename D, typename A>
-    bool owner_before(const weak_rc_ptr<U, D, A>& other) const noexcept
+    rc_ptr(const weak_rc_ptr<T, deleter_type, allocator_type>& other) :
+        m_ptr{ pointer() },
+        m_control_block{ nullptr }
     {
-        return other.m_control_block < m_control_block;
+        *this = other;
     }
 
-private:
-    using control_block_type =
-        detail::control_block<T, deleter_type, allocator_type>;
+    /**
+     * @brief Copy assignment operator.
+     *
+     * @param other
+     * @return rc_ptr&
+     */
+    rc_ptr& operator=(const rc_ptr& other) noexcept
+    {
+        rc_ptr(other).swap(*this);
+        return *this;
+    }
 
-    using control_block_allocator_type = typename std::allocator_traits<
-        allocator_type>::template rebind_alloc<control_block_type>;
-    using control_block_allocator_traits_type = typename std::allocator_traits<
-        allocator_type>::template rebind_traits<control_block_type>;
+    /**
+     * @brief Move assignment operator.
+     *
+     * @param other
+     * @return rc_ptr&
+     */
+    rc_ptr& operator=(rc_ptr&& other) noexcept
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
 
-    pointer             m_ptr;
-    control_block_type* m_control_block;
-};
+        rc_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Assignment of weak_rc_ptr to rc_tr.
+     *
+     * @param other
+     * @throws bad_weak_rc_ptr when other.expired() == true
+     */
+    rc_ptr& operator=(const weak_rc_ptr<T, deleter_type, allocator_type>& other)
+    {
+        if (other.expired())
+        {
+            throw bad_weak_rc_ptr("rc_ptr expired.");
+        }
+
+        *this = other.lock();
+        return *this;
+    }
+
+    /**
+     * @brief Destroys rc_ptr object. The managed object is destroyed and the
+     * memory is deallocated when the last remaining rc_ptr managing the object
+     * is destroyed.
+     *
+     */
+    ~rc_ptr()
+    {
+        static_assert(std::is_invocable_v<deleter_type&, pointer>,
+                      "Deleter must be invocable with a pointer.");
+
+        if (!m_control_block)
+        {
+            assert(!m_ptr);
+            return;
+        }
+
+        m_control_block->release_ref();
+    }
+
+    /**
+     * @brief Returns the stored pointer.
+     *
+     * @return pointer
+     */
+    pointer get() const noexcept
+    {
+        return m_ptr;
+    }
+
+    /**
+     * @brief Returns a reference to the deleter.
+     *
+     * @return const deleter_type&
+     */
+    const deleter_type& get_deleter() const noexcept
+    {
+        assert(m_control_block);
+        return m_control_block->get_deleter();
+    }
+
+    /**
+     * @brief Returns a reference to the deleter.
+     *
+     * @return deleter_type&
+     */
+    deleter_type& get_deleter() noexcept
+    {
+        assert(m_control_block);
+        return m_control_block->get_deleter();
+    }
+
+    /**
+     * @brief Returns a copy of the allocator.
+     *
+     * @return deleter_type&
+     */
+    allocator_type get_allocator() noexcept
+    {
+        assert(m_control_block);
+        return m_control_block->get_allocator();
+    }
+
+    /**
+     * @brief Returns the current number of rc_ptr objects owning the
+     * resource. For the objects created by make_immortal_rc, the returned
+     * value is std::numeric_limits<std::size_t>::max().
+     *
+     * @return std::size_t
+     */
+    std::size_t use_count() const noexcept
+    {
+        return (!m_control_block) ? 0 : m_control_block->get_ref_count();
+    }
+
+    /**
+     * @brief Checks whether the managed object was created by
+     * make_immortal_rc.
+     *
+     * @return true if the managed object is never destroyed
+     * @return false otherwise
+     */
+    bool immortal() const noexcept
+    {
+        return (m_control_block && m_control_block->is_immortal());
+    }
+
+    /**
+     * @brief Checks whether the instance of rc_ptr is the only one managing
+     * the resource.
+     *
+     * @return true if reference count is equal to zero
+     * @return false otherwise
+     */
+    bool unique() const noexcept
+    {
+        return (use_count() == 1);
+    }
+
+    /**
+     * @brief Releases the ownerhip of the managed object.
+     *
+     */
+    void reset() noexcept
+    {
+        rc_ptr().swap(*this);
+    }
+
+    /**
+     * @brief Swaps contents with other rc_ptr object.
+     *
+     * @param other
+     */
+    void swap(rc_ptr& other) noexcept
+    {
+        std::swap(m_control_block, other.m_control_block);
+        std::swap(m_ptr, other.m_ptr);
+        this->swap_extent(other);
+    }
+
+    /**
+     * @brief Assigns n copies of this to the elements at out. The reference
+     * count is increased once by n instead of once per copy.
+     *
+     * @tparam OutputIt
+     * @param out
+     * @param n
+     * @return OutputIt Iterator following the last assigned element.
+     */
+    template<typename OutputIt>
+    OutputIt share_n(OutputIt out, std::size_t n) const
+    {
+        if (m_control_block)
+        {
+            m_control_block->increase_ref_count(n);
+        }
+
+        std::size_t remaining = n;
+
+        try
+        {
+            for (; remaining != 0; ++out)
+            {
+                --remaining;
+                *out = rc_ptr{ detail::adopt_ref,
+                               m_ptr,
+                               m_control_block,
+                               this->get_extent() };
+            }
+        }
+        catch (...)
+        {
+            if (m_control_block)
+            {
+                m_control_block->decrease_ref_count(remaining);
+            }
+
+            throw;
+        }
+
+        return out;
+    }
+
+    /**
+     * @brief Replaces the managed object with a new one, constructed from
+     * args. If the rc_ptr is the only owner of an object created by make_rc
+     * and no weak_rc_ptr refers to it, the object is reconstructed in the
+     * existing storage without any allocation. Otherwise, the new object is
+     * created as if by make_rc and the ownership of the old one is released.
+     *
+     * If the in-place construction throws, the rc_ptr is left empty.
+     *
+     * @tparam ArgsT
+     * @param args
+     * @return reference to the new object
+     */
+    template<typename... ArgsT>
+    reference emplace(ArgsT&&... args)
+    {
+        static_assert(!std::is_array_v<T>,
+                      "emplace is not supported for arrays.");
+        static_assert(std::is_default_constructible_v<deleter_type>,
+                      "Deleter must be default constructible.");
+
+        using inplace_block_type =
+            detail::inplace_block<T, deleter_type, allocator_type>;
+
+        const bool reusable =
+            m_control_block &&
+            m_control_block->get_manager() == &inplace_block_type::manage &&
+            m_control_block->get_ref_count() == 1 &&
+            m_control_block->get_weak_count() == 0 &&
+            m_control_block->get_pointer() == m_ptr;
+
+        if (!reusable)
+        {
+            auto allocator =
+                m_control_block ? get_allocator() : allocator_type{};
+            from_block(inplace_block_type::create(
+                           allocator,
+                           std::forward<ArgsT>(args)...))
+                .swap(*this);
+            return *get();
+        }
+
+        std::destroy_at(m_ptr);
+
+        try
+        {
+            detail::list_construct_object(m_ptr,
+                                          std::forward<ArgsT>(args)...);
+        }
+        catch (...)
+        {
+            // The old object is gone, only the storage is left to release.
+            m_control_block->decrease_ref_count();
+            m_control_block->destroy();
+            m_control_block = nullptr;
+            m_ptr           = pointer();
+            throw;
+        }
+
+        return *get();
+    }
+
+    /**
+     * @brief Checks whether the current rc_ptr object precedes other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_before(const rc_ptr<U, D, A>& other) const noexcept
+    {
+        return other.m_control_block < m_control_block;
+    }
+
+    /**
+     * @brief Checks whether the current rc_ptr object precedes other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_before(const weak_rc_ptr<U, D, A>& other) const noexcept
+    {
+        return other.m_control_block < m_control_block;
+    }
+
+    /**
+     * @brief Returns the hash of the control block. Equal for all rc_ptr and
+     * weak_rc_ptr objects sharing the ownership.
+     *
+     * @return std::size_t
+     */
+    std::size_t owner_hash() const noexcept
+    {
+        return std::hash<const detail::control_block_base*>{}(
+            m_control_block);
+    }
+
+    /**
+     * @brief Checks whether the current object shares the ownership with
+     * other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_equal(const rc_ptr<U, D, A>& other) const noexcept
+    {
+        return (static_cast<const detail::control_block_base*>(
+                    m_control_block) ==
+                static_cast<const detail::control_block_base*>(
+                    other.m_control_block));
+    }
+
+    /**
+     * @brief Checks whether the current object shares the ownership with
+     * other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_equal(const weak_rc_ptr<U, D, A>& other) const noexcept
+    {
+        return (static_cast<const detail::control_block_base*>(
+                    m_control_block) ==
+                static_cast<const detail::control_block_base*>(
+                    other.m_control_block));
+    }
+
+    /**
+     * @brief Implicit conversion to bool. Compares the stored pointer to
+     * nullptr.
+     *
+     * @return true if stored pointer is not nullptr.
+     * @return false otherwise
+     */
+    operator bool() const noexcept
+    {
+        return static_cast<bool>(get());
+    }
+
+    /**
+     * @brief Dereferences the stored pointer and returns a reference to the
+     * value. Undefined behaviour if the stored pointer is not valid.
+     *
+     * @return reference
+     */
+    reference operator*() const noexcept
+    {
+        assert(get());
+        return *get();
+    }
+
+    /**
+     * @brief Dereferences the stored pointer and returns a reference to the
+     * value. Undefined behaviour if the stored pointer is not valid.
+     *
+     * @return pointer
+     */
+    pointer operator->() const noexcept
+    {
+        assert(get());
+        return get();
+    }
+
+    /**
+     * @brief Provides index based access to the stored array.
+     *
+     * @param index
+     * @return element_type&
+     */
+    element_type& operator[](const std::ptrdiff_t index) const
+    {
+        assert(get());
+        // The size of arrays adopted from a raw pointer is unknown.
+        assert(index >= 0 &&
+               (this->get_extent() == 0 ||
+                static_cast<std::size_t>(index) < this->get_extent()));
+        return get()[index];
+    }
+
+    /**
+     * @brief Returns the number of elements of the managed array.
+     *
+     * @return std::size_t
+     */
+    template<typename U = T, typename = std::enable_if_t<std::is_array_v<U>>>
+    std::size_t size() const noexcept
+    {
+        return this->get_extent();
+    }
+
+    /**
+     * @brief Returns the pointer to the first element of the managed array.
+     *
+     * @return pointer
+     */
+    template<typename U = T, typename = std::enable_if_t<std::is_array_v<U>>>
+    pointer begin() const noexcept
+    {
+        return get();
+    }
+
+    /**
+     * @brief Returns the pointer past the last element of the managed array.
+     *
+     * @return pointer
+     */
+    template<typename U = T, typename = std::enable_if_t<std::is_array_v<U>>>
+    pointer end() const noexcept
+    {
+        return get() + size();
+    }
+
+#if defined(__cpp_lib_span)
+    /**
+     * @brief Returns the view of the managed array.
+     *
+     * @return std::span<element_type>
+     */
+    template<typename U = T, typename = std::enable_if_t<std::is_array_v<U>>>
+    std::span<element_type> as_span() const noexcept
+    {
+        return { get(), size() };
+    }
+#endif
+
+    /**
+     * @brief Creates rc_ptr to the subrange of the managed array, sharing the
+     * ownership with this.
+     *
+     * @param offset Index of the first element of the subrange
+     * @param count Number of elements in the subrange
+     * @return rc_ptr
+     */
+    template<typename U = T, typename = std::enable_if_t<std::is_array_v<U>>>
+    rc_ptr slice(std::size_t offset, std::size_t count) const noexcept
+    {
+        assert(get());
+        assert(offset <= size() && count <= size() - offset);
+        return rc_ptr{ get() + offset, m_control_block, count };
+    }
+
+private:
+    using extent_storage_type = detail::extent_storage<T>;
+    using allocator_traits    = std::allocator_traits<allocator_type>;
+    using control_block_type =
+        detail::control_block<T, deleter_type, allocator_type>;
+
+    using control_block_allocator_type = typename std::allocator_traits<
+        allocator_type>::template rebind_alloc<control_block_type>;
+    using control_block_allocator_traits_type = typename std::allocator_traits<
+        allocator_type>::template rebind_traits<control_block_type>;
+
+    template<typename U, typename D, typename A>
+    friend class rc_ptr;
+    template<typename U, typename D, typename A>
+    friend class weak_rc_ptr;
+    friend class rc_borrow<T, deleter_type, allocator_type>;
+    friend struct detail::rc_ptr_access;
+
+    rc_ptr(pointer ptr, control_block_type* control_block,
+           std::size_t extent = 0) :
+        extent_storage_type{ extent },
+        m_ptr{ ptr },
+        m_control_block{ control_block }
+    {
+        assert(m_ptr);
+        assert(m_control_block);
+        m_control_block->increase_ref_count();
+    }
+
+    rc_ptr(detail::adopt_ref_t, pointer ptr, control_block_type* control_block,
+           std::size_t extent) noexcept :
+        extent_storage_type{ extent },
+        m_ptr{ ptr },
+        m_control_block{ control_block }
+    {
+    }
+
+    // Empties this without releasing the reference, which is then owned by
+    // the caller.
+    void drop() noexcept
+    {
+        rc_ptr empty;
+        swap(empty);
+        empty.m_ptr           = pointer();
+        empty.m_control_block = nullptr;
+    }
+
+    // Takes the first reference to a block created by one of the factories.
+    static rc_ptr from_block(control_block_type* control_block,
+                             std::size_t         extent = 0) noexcept
+    {
+        rc_ptr result{ control_block->get_pointer(), control_block, extent };
+        result.enable_rc_from_this_hook();
+        return result;
+    }
+
+    void enable_rc_from_this_hook() noexcept
+    {
+        // Additional step for classes deriving from enable_rc_from_this.
+        if constexpr (std::is_base_of_v<enable_rc_from_this<T>, T>)
+        {
+            m_ptr->m_weak = weak_rc_ptr<T>(*this);
+        }
+    }
+
+    pointer             m_ptr;
+    control_block_type* m_control_block;
+};
+
+/**
+ * @brief Outputs the value of get() to the output stream.
+ *
+ * @tparam CharT
+ * @tparam Traits
+ * @tparam U
+ * @tparam D
+ * @tparam A
+ * @param os
+ * @param ptr
+ * @return std::basic_ostream<CharT, Traits>&
+ */
+template<typename CharT, typename Traits, typename U, typename D, typename A>
+std::basic_ostream<CharT, Traits>&
+    operator<<(std::basic_ostream<CharT, Traits>& os,
+               const rc_ptr<U, D, A>&             ptr)
+{
+    return os << ptr.get();
+}
+
+/**
+ * @brief Compares the stored pointers.
+ *
+ */
+template<typename T, typename D, typename A, typename U, typename E,
+         typename B>
+bool operator==(const rc_ptr<T, D, A>& left,
+                const rc_ptr<U, E, B>& right) noexcept
+{
+    return (left.get() == right.get());
+}
+
+/**
+ * @brief Compares the stored pointers.
+ *
+ */
+template<typename T, typename D, typename A, typename U, typename E,
+         typename B>
+bool operator!=(const rc_ptr<T, D, A>& left,
+                const rc_ptr<U, E, B>& right) noexcept
+{
+    return !(left == right);
+}
+
+/**
+ * @brief Checks if the stored pointer is null.
+ *
+ */
+template<typename T, typename D, typename A>
+bool operator==(const rc_ptr<T, D, A>& ptr, std::nullptr_t) noexcept
+{
+    return !ptr;
+}
+
+/**
+ * @brief Checks if the stored pointer is null.
+ *
+ */
+template<typename T, typename D, typename A>
+bool operator==(std::nullptr_t, const rc_ptr<T, D, A>& ptr) noexcept
+{
+    return !ptr;
+}
+
+/**
+ * @brief Checks if the stored pointer is not null.
+ *
+ */
+template<typename T, typename D, typename A>
+bool operator!=(const rc_ptr<T, D, A>& ptr, std::nullptr_t) noexcept
+{
+    return static_cast<bool>(ptr);
+}
+
+/**
+ * @brief Checks if the stored pointer is not null.
+ *
+ */
+template<typename T, typename D, typename A>
+bool operator!=(std::nullptr_t, const rc_ptr<T, D, A>& ptr) noexcept
+{
+    return static_cast<bool>(ptr);
+}
+
+/**
+ * @brief weak_rc_ptr is a smart pointer that represents a weak reference to the
+ * resource.
+ *
+ * rc_ptr object can be constructed from weak_rc_ptr object by using the
+ * lock() method or by assignment.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ */
+template<typename T, typename Deleter, typename Alloc>
+class weak_rc_ptr : private detail::extent_storage<T>
+{
+public:
+    using element_type   = std::remove_extent_t<T>;
+    using pointer        = element_type*;
+    using reference      = element_type&;
+    using deleter_type   = Deleter;
+    using allocator_type = Alloc;
+
+    /**
+     * @brief Default constructor. Constructs an empty weak_rc_ptr object.
+     *
+     */
+    constexpr weak_rc_ptr() : m_ptr{ pointer() }, m_control_block{ nullptr } { }
+
+    /**
+     * @brief Copy constructor.
+     *
+     * @param other
+     */
+    weak_rc_ptr(const weak_rc_ptr& other) :
+        extent_storage_type{ other.get_extent() },
+        m_ptr{ other.m_ptr },
+        m_control_block{ other.m_control_block }
+    {
+        if (!m_control_block)
+        {
+            assert(!m_ptr);
+            return;
+        }
+
+        m_control_block->increase_weak_count();
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * @param other
+     */
+    weak_rc_ptr(weak_rc_ptr&& other) :
+        m_ptr{ pointer() },
+        m_control_block{ nullptr }
+    {
+        swap(other);
+    }
+
+    /**
+     * @brief Constructs the weak_rc_ptr from the rc_ptr.
+     *
+     * @param other
+     */
+    weak_rc_ptr(const rc_ptr<T, deleter_type, allocator_type>& other) :
+        extent_storage_type{ other.get_extent() },
+        m_ptr{ pointer() },
+        m_control_block{ nullptr }
+    {
+        if (!other.get())
+        {
+            return;
+        }
+
+        assert(other.m_control_block);
+        m_ptr           = other.get();
+        m_control_block = other.m_control_block;
+        m_control_block->increase_weak_count();
+    }
+
+    /**
+     * @brief Destroys weak_rc_ptr.
+     *
+     */
+    ~weak_rc_ptr()
+    {
+        if (!m_control_block)
+        {
+            assert(!m_ptr);
+            return;
+        }
+
+        m_control_block->release_weak();
+    }
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * @param other
+     * @return weak_rc_ptr&
+     */
+    weak_rc_ptr& operator=(const weak_rc_ptr& other)
+    {
+        weak_rc_ptr(other).swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * @param other
+     * @return weak_rc_ptr&
+     */
+    weak_rc_ptr& operator=(weak_rc_ptr&& other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        weak_rc_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Assigns rc_ptr to weak_rc_ptr.
+     *
+     * @param other
+     */
+    weak_rc_ptr& operator=(const rc_ptr<T, deleter_type, allocator_type>& other)
+    {
+        weak_rc_ptr(other).swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Checks if the managed object was deleted.
+     *
+     * @return true
+     * @return false
+     */
+    bool expired() const noexcept
+    {
+        return (!m_control_block || m_control_block->get_ref_count() == 0);
+    }
+
+    /**
+     * @brief Returns a reference to the deleter.
+     *
+     * @return const deleter_type&
+     */
+    const deleter_type& get_deleter() const noexcept
+    {
+        assert(m_control_block);
+        return m_control_block->get_deleter();
+    }
+
+    /**
+     * @brief Returns a reference to the deleter.
+     *
+     * @return deleter_type&
+     */
+    deleter_type& get_deleter() noexcept
+    {
+        assert(m_control_block);
+        return m_control_block->get_deleter();
+    }
+
+    /**
+     * @brief Returns a copy of the allocator.
+     *
+     * @return deleter_type&
+     */
+    allocator_type get_allocator() noexcept
+    {
+        assert(m_control_block);
+        return m_control_block->get_allocator();
+    }
+
+    /**
+     * @brief Returns the current number of rc_ptr objects owning the
+     * resource.
+     *
+     * @return std::size_t
+     */
+    std::size_t use_count() const noexcept
+    {
+        return (!m_control_block) ? 0 : m_control_block->get_ref_count();
+    }
+
+    /**
+     * @brief Creates rc_ptr managing the stored object. If expired() == true,
+     * the default constructed rc_ptr is returned.
+     *
+     * @return rc_ptr<T, deleter_type, allocator_type>
+     */
+    rc_ptr<T, deleter_type, allocator_type> lock() const noexcept
+    {
+        return expired() ?
+                   rc_ptr<T, deleter_type, allocator_type>{} :
+                   rc_ptr<T, deleter_type, allocator_type>{
+                       m_ptr,
+                       m_control_block,
+                       this->get_extent()
+                   };
+    }
+
+    /**
+     * @brief Releases the ownerhip of the managed object.
+     *
+     */
+    void reset() noexcept
+    {
+        weak_rc_ptr().swap(*this);
+    }
+
+    /**
+     * @brief Swaps contents with other weak_rc_ptr object.
+     *
+     * @param other
+     */
+    void swap(weak_rc_ptr& other) noexcept
+    {
+        std::swap(m_control_block, other.m_control_block);
+        std::swap(m_ptr, other.m_ptr);
+        this->swap_extent(other);
+    }
+
+    /**
+     * @brief Checks whether the current rc_ptr object precedes other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_before(const rc_ptr<U, D, A>& other) const noexcept
+    {
+        return other.m_control_block < m_control_block;
+    }
+
+    /**
+     * @brief Checks whether the current rc_ptr object precedes other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_before(const weak_rc_ptr<U, D, A>& other) const noexcept
+    {
+        return other.m_control_block < m_control_block;
+    }
+
+    /**
+     * @brief Returns the hash of the control block. Equal for all rc_ptr and
+     * weak_rc_ptr objects sharing the ownership.
+     *
+     * @return std::size_t
+     */
+    std::size_t owner_hash() const noexcept
+    {
+        return std::hash<const detail::control_block_base*>{}(
+            m_control_block);
+    }
+
+    /**
+     * @brief Checks whether the current object shares the ownership with
+     * other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_equal(const rc_ptr<U, D, A>& other) const noexcept
+    {
+        return (static_cast<const detail::control_block_base*>(
+                    m_control_block) ==
+                static_cast<const detail::control_block_base*>(
+                    other.m_control_block));
+    }
+
+    /**
+     * @brief Checks whether the current object shares the ownership with
+     * other.
+     *
+     * @tparam U
+     * @tparam D
+     * @tparam A
+     * @param other
+     * @return true
+     * @return false
+     */
+    template<typename U, typename D, typename A>
+    bool owner_equal(const weak_rc_ptr<U, D, A>& other) const noexcept
+    {
+        return (static_cast<const detail::control_block_base*>(
+                    m_control_block) ==
+                static_cast<const detail::control_block_base*>(
+                    other.m_control_block));
+    }
+
+private:
+    using extent_storage_type = detail::extent_storage<T>;
+    using control_block_type =
+        detail::control_block<T, deleter_type, allocator_type>;
+
+    template<typename U, typename D, typename A>
+    friend class rc_ptr;
+    template<typename U, typename D, typename A>
+    friend class weak_rc_ptr;
+    friend struct detail::rc_ptr_access;
+
+    pointer             m_ptr;
+    control_block_type* m_control_block;
+};
+
+/**
+ * @brief rc_borrow is a non owning reference to the object managed by rc_ptr.
+ * Creating, copying and destroying rc_borrow objects does not modify the
+ * reference count. The borrowed object can be accessed directly and an
+ * owning rc_ptr can be obtained with to_owned().
+ *
+ * rc_borrow must not outlive the rc_ptr objects owning the resource. When
+ * RC_PTR_CHECK_BORROWS is enabled, rc_borrow keeps the control block alive
+ * and the use of a dangling rc_borrow aborts the program. Otherwise,
+ * rc_borrow is trivially copyable.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ */
+template<typename T, typename Deleter, typename Alloc>
+class rc_borrow : private detail::extent_storage<T>
+{
+public:
+    using element_type   = std::remove_extent_t<T>;
+    using pointer        = element_type*;
+    using reference      = element_type&;
+    using deleter_type   = Deleter;
+    using allocator_type = Alloc;
+
+    /**
+     * @brief Default constructor. Constructs rc_borrow that refers to nothing.
+     *
+     */
+    constexpr rc_borrow() noexcept :
+        m_ptr{ pointer() },
+        m_control_block{ nullptr }
+    {
+    }
+
+    /**
+     * @brief Constructs rc_borrow that refers to nothing.
+     *
+     */
+    constexpr rc_borrow(std::nullptr_t) noexcept : rc_borrow{} { }
+
+    /**
+     * @brief Borrows the object managed by other.
+     *
+     * @param other
+     */
+    rc_borrow(const rc_ptr<T, deleter_type, allocator_type>& other) noexcept :
+        extent_storage_type{ other.get_extent() },
+        m_ptr{ other.m_ptr },
+        m_control_block{ other.m_control_block }
+    {
+#if RC_PTR_CHECK_BORROWS
+        if (m_control_block)
+        {
+            m_control_block->increase_weak_count();
+        }
+#endif
+    }
+
+#if RC_PTR_CHECK_BORROWS
+    rc_borrow(const rc_borrow& other) noexcept :
+        extent_storage_type{ other.get_extent() },
+        m_ptr{ other.m_ptr },
+        m_control_block{ other.m_control_block }
+    {
+        if (m_control_block)
+        {
+            m_control_block->increase_weak_count();
+        }
+    }
+
+    rc_borrow& operator=(const rc_borrow& other) noexcept
+    {
+        rc_borrow(other).swap(*this);
+        return *this;
+    }
+
+    ~rc_borrow()
+    {
+        if (m_control_block)
+        {
+            m_control_block->release_weak();
+        }
+    }
+#endif
+
+    /**
+     * @brief Returns the borrowed pointer.
+     *
+     * @return pointer
+     */
+    pointer get() const noexcept
+    {
+        check_alive();
+        return m_ptr;
+    }
+
+    /**
+     * @brief Creates rc_ptr sharing the ownership of the borrowed object.
+     *
+     * @return rc_ptr<T, deleter_type, allocator_type>
+     */
+    rc_ptr<T, deleter_type, allocator_type> to_owned() const noexcept
+    {
+        check_alive();
+        return m_control_block ?
+                   rc_ptr<T, deleter_type, allocator_type>{
+                       m_ptr,
+                       m_control_block,
+                       this->get_extent()
+                   } :
+                   rc_ptr<T, deleter_type, allocator_type>{};
+    }
+
+    /**
+     * @brief Swaps contents with other rc_borrow object.
+     *
+     * @param other
+     */
+    void swap(rc_borrow& other) noexcept
+    {
+        std::swap(m_control_block, other.m_control_block);
+        std::swap(m_ptr, other.m_ptr);
+        this->swap_extent(other);
+    }
+
+    /**
+     * @brief Implicit conversion to bool. Compares the borrowed pointer to
+     * nullptr.
+     *
+     * @return true if borrowed pointer is not nullptr.
+     * @return false otherwise
+     */
+    operator bool() const noexcept
+    {
+        return static_cast<bool>(get());
+    }
+
+    /**
+     * @brief Dereferences the borrowed pointer.
+     *
+     * @return reference
+     */
+    reference operator*() const noexcept
+    {
+        assert(get());
+        return *get();
+    }
+
+    /**
+     * @brief Dereferences the borrowed pointer.
+     *
+     * @return pointer
+     */
+    pointer operator->() const noexcept
+    {
+        assert(get());
+        return get();
+    }
+
+private:
+    using extent_storage_type = detail::extent_storage<T>;
+    using control_block_type =
+        detail::control_block<T, deleter_type, allocator_type>;
+
+    void check_alive() const noexcept
+    {
+#if RC_PTR_CHECK_BORROWS
+        if (m_control_block && m_control_block->get_ref_count() == 0)
+        {
+            assert(!"rc_borrow outlived the borrowed object.");
+            std::abort();
+        }
+#endif
+    }
+
+    pointer             m_ptr;
+    control_block_type* m_control_block;
+};
+
+/**
+ * @brief enable_rc_from_this class template allows to safely create rc_ptr and
+ * weak_rc_ptr object from this pointer.
+ *
+ * @tparam T
+ */
+template<typename T>
+class enable_rc_from_this
+{
+protected:
+    constexpr enable_rc_from_this()                 = default;
+    enable_rc_from_this(const enable_rc_from_this&) = default;
+    enable_rc_from_this(enable_rc_from_this&&)      = default;
+    ~enable_rc_from_this()                          = default;
+
+    enable_rc_from_this& operator=(const enable_rc_from_this&) = default;
+    enable_rc_from_this& operator=(enable_rc_from_this&&) = default;
+
+public:
+    /**
+     * @brief Creates the rc_ptr object from this.
+     *
+     * @return rc_ptr<T>
+     */
+    rc_ptr<T> rc_from_this()
+    {
+        return m_weak.lock();
+    }
+
+    /**
+     * @brief Creates the rc_ptr object from this.
+     *
+     * @return rc_ptr<const T>
+     */
+    rc_ptr<const T> rc_from_this() const
+    {
+        return m_weak.lock();
+    }
+
+    /**
+     * @brief Creates the weak_rc_ptr object from this.
+     *
+     * @return weak_rc_ptr<T>
+     */
+    weak_rc_ptr<T> weak_rc_from_this()
+    {
+        return m_weak;
+    }
+
+    /**
+     * @brief Creates the weak_rc_ptr object from this.
+     *
+     * @return weak_rc_ptr<const T>
+     */
+    weak_rc_ptr<const T> weak_rc_from_this() const
+    {
+        return m_weak;
+    }
+
+private:
+    friend class rc_ptr<T>;
+
+    mutable weak_rc_ptr<T> m_weak;
+};
+
+namespace detail
+{
+// Vector holding the results of allocate_rc_n, allocated with a rebound Alloc.
+template<typename T, typename Deleter, typename Alloc>
+using slab_vector = std::vector<
+    rc_ptr<T, Deleter, Alloc>,
+    typename std::allocator_traits<Alloc>::template rebind_alloc<
+        rc_ptr<T, Deleter, Alloc>>>;
+
+/**
+ * @brief Grants the factories access to rc_ptr internals.
+ *
+ */
+struct rc_ptr_access
+{
+    template<typename T, typename Deleter, typename Alloc, typename... ArgsT>
+    static rc_ptr<T, Deleter, Alloc> make_inplace(const Alloc& allocator,
+                                                  ArgsT&&... args)
+    {
+        static_assert(
+            is_inplace_rc_from_this_compatible_v<T, Deleter, Alloc>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "as the type passed to it, with the same Deleter and Alloc.");
+
+        return rc_ptr<T, Deleter, Alloc>::from_block(
+            inplace_block<T, Deleter, Alloc>::create(
+                allocator,
+                std::forward<ArgsT>(args)...));
+    }
+
+    template<typename T, typename Deleter, typename Alloc, typename... ArgsT>
+    static rc_ptr<T, Deleter, Alloc> make_immortal(const Alloc& allocator,
+                                                   ArgsT&&... args)
+    {
+        static_assert(
+            is_inplace_rc_from_this_compatible_v<T, Deleter, Alloc>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "as the type passed to it, with the same Deleter and Alloc.");
+
+        auto block = inplace_block<T, Deleter, Alloc>::create(
+            allocator,
+            std::forward<ArgsT>(args)...);
+        block->make_immortal();
+        return rc_ptr<T, Deleter, Alloc>::from_block(block);
+    }
+
+    template<typename T, typename Deleter, typename Alloc,
+             typename Initializer>
+    static rc_ptr<T, Deleter, Alloc> make_inplace_array(
+        const Alloc& allocator, std::size_t size, Initializer&& initializer)
+    {
+        static_assert(!std::is_base_of_v<enable_inplace_rc_from_this_base,
+                                         std::remove_extent_t<T>>,
+                      "Classes deriving from enable_inplace_rc_from_this must "
+                      "be created by make_rc or allocate_rc.");
+
+        return rc_ptr<T, Deleter, Alloc>::from_block(
+            inplace_array_block<T, Deleter, Alloc>::create(
+                allocator,
+                size,
+                std::forward<Initializer>(initializer)),
+            size);
+    }
+
+    template<typename T, typename Elem, typename Deleter, typename Alloc,
+             typename... ArgsT>
+    static rc_ptr<T, Deleter, Alloc> make_inplace_flex(const Alloc& allocator,
+                                                       std::size_t  count,
+                                                       ArgsT&&... args)
+    {
+        static_assert(
+            !std::is_base_of_v<enable_inplace_rc_from_this_base, T>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "by make_rc or allocate_rc.");
+
+        return rc_ptr<T, Deleter, Alloc>::from_block(
+            inplace_flex_block<T, Elem, Deleter, Alloc>::create(
+                allocator,
+                count,
+                std::forward<ArgsT>(args)...));
+    }
+
+    template<typename T, typename Deleter, typename Alloc, typename Init>
+    static slab_vector<T, Deleter, Alloc>
+        make_slab(const Alloc& allocator, std::size_t count, Init& init)
+    {
+        static_assert(
+            !std::is_base_of_v<enable_inplace_rc_from_this_base, T>,
+            "Classes deriving from enable_inplace_rc_from_this must be created "
+            "by make_rc or allocate_rc.");
+
+        using slab_block_type = slab_block<T, Deleter, Alloc>;
+
+        using vector_type = slab_vector<T, Deleter, Alloc>;
+
+        // Reject an overflowing count before anything is allocated.
+        slab_block_type::units_for(count);
+
+        vector_type result{ typename vector_type::allocator_type{ allocator } };
+        result.reserve(count);
+
+        slab_block_type::create(
+            allocator,
+            count,
+            init,
+            [&result](typename slab_block_type::block_type* block) noexcept {
+                result.push_back(rc_ptr<T, Deleter, Alloc>::from_block(block));
+            });
+
+        return result;
+    }
+
+    template<typename T, typename Deleter, typename Alloc>
+    static control_block_base*
+        get_control_block(const rc_ptr<T, Deleter, Alloc>& ptr) noexcept
+    {
+        return ptr.m_control_block;
+    }
+
+    template<typename T, typename Deleter, typename Alloc>
+    static void drop(rc_ptr<T, Deleter, Alloc>& ptr) noexcept
+    {
+        ptr.drop();
+    }
+
+    // Returns the pointer stored by weak_rc_ptr, which may be expired.
+    template<typename T, typename Deleter, typename Alloc>
+    static std::remove_extent_t<T>*
+        get_pointer(const weak_rc_ptr<T, Deleter, Alloc>& ptr) noexcept
+    {
+        return ptr.m_ptr;
+    }
+
+    // Takes over a reference already counted by the caller.
+    template<typename T, typename Deleter, typename Alloc>
+    static rc_ptr<T, Deleter, Alloc>
+        adopt(std::remove_extent_t<T>*             ptr,
+              control_block<T, Deleter, Alloc>* control_block) noexcept
+    {
+        return rc_ptr<T, Deleter, Alloc>{ adopt_ref, ptr, control_block, 0 };
+    }
+
+    template<typename T, typename Hook, typename Deleter, typename Alloc,
+             typename... ArgsT>
+    static rc_ptr<T, Deleter, Alloc>
+        make_hooked(const Alloc& allocator, Hook&& hook, ArgsT&&... args);
+
+    // Takes a reference to the block, storing ptr.
+    template<typename T, typename Deleter, typename Alloc>
+    static rc_ptr<T, Deleter, Alloc>
+        share(std::remove_extent_t<T>*             ptr,
+              control_block<T, Deleter, Alloc>* control_block) noexcept
+    {
+        return rc_ptr<T, Deleter, Alloc>{ ptr, control_block };
+    }
+
+    // Shares the ownership with ptr, setting the number of elements of an
+    // array adopted from a raw pointer.
+    template<typename T, typename Deleter, typename Alloc>
+    static rc_ptr<T, Deleter, Alloc>
+        with_extent(const rc_ptr<T, Deleter, Alloc>& ptr,
+                    std::size_t                      extent) noexcept
+    {
+        return rc_ptr<T, Deleter, Alloc>{ ptr.m_ptr,
+                                          ptr.m_control_block,
+                                          extent };
+    }
+
+    template<typename T, typename Deleter, typename Alloc>
+    static rc_ptr<T, Deleter, Alloc> from_inplace(T* object)
+    {
+        using inplace_block_type = inplace_block<T, Deleter, Alloc>;
+
+        auto block = inplace_block_type::layout_type::block(object);
+        assert(block->get_manager() == &inplace_block_type::manage &&
+               "Object was not created by make_rc or allocate_rc.");
+        assert(block->get_pointer() == object);
+
+        if (block->get_ref_count() == 0)
+        {
+            throw bad_weak_rc_ptr("rc_ptr expired.");
+        }
+
+        return rc_ptr<T, Deleter, Alloc>{ object, block };
+    }
+};
+
+/**
+ * @brief Control block of the objects created by make_hooked_rc, storing the
+ * last release hook.
+ *
+ */
+template<typename T, typename Hook, typename Deleter, typename Alloc>
+class hooked_control_block : public control_block<T, Deleter, Alloc>
+{
+public:
+    using base_type = control_block<T, Deleter, Alloc>;
+
+    template<typename H>
+    hooked_control_block(T*                                  ptr,
+                         H&&                                 hook,
+                         const Alloc&                        allocator,
+                         control_block_base::manager_type manager) :
+        base_type{ ptr, Deleter{}, allocator, manager },
+        m_hook{ std::forward<H>(hook) }
+    {
+    }
+
+    Hook& get_hook() noexcept
+    {
+        return m_hook;
+    }
+
+private:
+    Hook m_hook;
+};
+
+/**
+ * @brief Fused allocation of the object and the control block with the last
+ * release hook. When the reference count reaches zero, the hook is called
+ * with rc_ptr holding the last reference. The object is destroyed only if the
+ * hook leaves the rc_ptr in place, moving it elsewhere resurrects the object.
+ *
+ * Blocks without a hook do not pay for it, the hook is reached through the
+ * manager function only.
+ *
+ * @tparam T
+ * @tparam Hook
+ * @tparam Deleter Stored only for the rc_ptr interface, never invoked.
+ * @tparam Alloc
+ */
+template<typename T, typename Hook, typename Deleter, typename Alloc>
+struct hooked_block
+{
+    using block_type  = hooked_control_block<T, Hook, Deleter, Alloc>;
+    using layout_type = inplace_layout<block_type, T>;
+    using unit_type   = typename layout_type::unit;
+
+    using unit_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<unit_type>;
+    using unit_allocator_traits_type = typename std::allocator_traits<
+        Alloc>::template rebind_traits<unit_type>;
+
+    template<typename H, typename... ArgsT>
+    static block_type* create(const Alloc& allocator, H&& hook,
+                              ArgsT&&... args)
+    {
+        auto unit_allocator = unit_allocator_type{ allocator };
+        auto mem =
+            unit_allocator_traits_type::allocate(unit_allocator,
+                                                 layout_type::units(1));
+
+        assert(mem);
+        T*          object = layout_type::object(mem);
+        block_type* block  = nullptr;
+
+        try
+        {
+            block = ::new (static_cast<void*>(mem)) block_type{
+                object, std::forward<H>(hook), allocator, &hooked_block::manage
+            };
+
+            list_construct_object(object, std::forward<ArgsT>(args)...);
+        }
+        catch (...)
+        {
+            if (block)
+            {
+                std::destroy_at(block);
+            }
+
+            unit_allocator_traits_type::deallocate(unit_allocator,
+                                                   mem,
+                                                   layout_type::units(1));
+            throw;
+        }
+
+        return block;
+    }
+
+    static void manage(control_block_base* base,
+                       block_operation     operation) noexcept
+    {
+        auto block = static_cast<block_type*>(base);
+
+        switch (operation)
+        {
+        case block_operation::dispose:
+        {
+            block->increase_ref_count();
+            auto last = rc_ptr_access::adopt(
+                block->get_pointer(),
+                static_cast<typename block_type::base_type*>(block));
+
+            block->get_hook()(last);
+
+            // Moved or copied by the hook. A copy keeps the object alive and
+            // last releases its own reference when it goes out of scope.
+            if (!rc_ptr_access::get_control_block(last) ||
+                block->get_ref_count() > 1)
+            {
+                break;
+            }
+
+            rc_ptr_access::drop(last);
+            block->decrease_ref_count();
+            std::destroy_at(block->get_pointer());
+            break;
+        }
+        case block_operation::destroy:
+        {
+            auto unit_allocator = unit_allocator_type{ block->get_allocator() };
+            std::destroy_at(block);
+            unit_allocator_traits_type::deallocate(
+                unit_allocator,
+                reinterpret_cast<unit_type*>(block),
+                layout_type::units(1));
+            break;
+        }
+        }
+    }
+};
+
+template<typename T, typename Hook, typename Deleter, typename Alloc,
+         typename... ArgsT>
+rc_ptr<T, Deleter, Alloc> rc_ptr_access::make_hooked(const Alloc& allocator,
+                                                     Hook&&       hook,
+                                                     ArgsT&&... args)
+{
+    static_assert(
+        !std::is_base_of_v<enable_inplace_rc_from_this_base, T>,
+        "Classes deriving from enable_inplace_rc_from_this must be created "
+        "by make_rc or allocate_rc.");
+
+    return rc_ptr<T, Deleter, Alloc>::from_block(
+        hooked_block<T, std::decay_t<Hook>, Deleter, Alloc>::create(
+            allocator,
+            std::forward<Hook>(hook),
+            std::forward<ArgsT>(args)...));
+}
+} // namespace detail
+
+/**
+ * @brief enable_inplace_rc_from_this class template allows to safely create
+ * rc_ptr and weak_rc_ptr objects from this pointer, without storing any
+ * additional data in the object. The control block is found at the known
+ * offset from the object, therefore the deriving objects must be created by
+ * make_rc<T>, allocate_rc<T> or make_immortal_rc<T>. Deleter and Alloc must
+ * match the template arguments of the rc_ptr managing the object.
+ *
+ * The factories fail to compile for classes deriving from T, or with other
+ * Deleter or Alloc. Calling rc_from_this or weak_rc_from_this on an object
+ * not created by them, e.g. one on the stack, a member or a container
+ * element, is undefined behaviour. The control block cannot be told apart
+ * from the memory in front of such an object, debug builds only assert on
+ * it.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ */
+template<typename T, typename Deleter, typename Alloc>
+class enable_inplace_rc_from_this :
+    private detail::enable_inplace_rc_from_this_base
+{
+protected:
+    constexpr enable_inplace_rc_from_this()                         = default;
+    enable_inplace_rc_from_this(const enable_inplace_rc_from_this&) = default;
+    enable_inplace_rc_from_this(enable_inplace_rc_from_this&&)      = default;
+    ~enable_inplace_rc_from_this()                                  = default;
+
+    enable_inplace_rc_from_this&
+        operator=(const enable_inplace_rc_from_this&) = default;
+    enable_inplace_rc_from_this&
+        operator=(enable_inplace_rc_from_this&&) = default;
+
+public:
+    /**
+     * @brief Creates the rc_ptr object from this. The object must have been
+     * created by make_rc<T>, allocate_rc<T> or make_immortal_rc<T>.
+     *
+     * @return rc_ptr<T, Deleter, Alloc>
+     * @throws bad_weak_rc_ptr when called from the constructor or the
+     * destructor of T
+     */
+    rc_ptr<T, Deleter, Alloc> rc_from_this()
+    {
+        return detail::rc_ptr_access::from_inplace<T, Deleter, Alloc>(
+            static_cast<T*>(this));
+    }
+
+    /**
+     * @brief Creates the weak_rc_ptr object from this. The object must have
+     * been created by make_rc<T>, allocate_rc<T> or make_immortal_rc<T>.
+     *
+     * @return weak_rc_ptr<T, Deleter, Alloc>
+     * @throws bad_weak_rc_ptr when called from the constructor or the
+     * destructor of T
+     */
+    weak_rc_ptr<T, Deleter, Alloc> weak_rc_from_this()
+    {
+        return rc_from_this();
+    }
+};
+
+/**
+ * @brief Creates the rc_ptr instance, forwarding the arguments to the
+ * constructor of type T. The object and the control block share a single
+ * allocation, obtained from the allocator. Deleter is not invoked, it only
+ * sets the type of the returned rc_ptr.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ * @tparam ArgsT
+ * @param allocator
+ * @param args
+ * @return rc_ptr<T, Deleter, Alloc>
+ */
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc, typename... ArgsT,
+         typename = std::enable_if_t<!std::is_array_v<T>>>
+rc_ptr<T, Deleter, Alloc> allocate_rc(const Alloc& allocator, ArgsT&&... args)
+{
+    return detail::rc_ptr_access::make_inplace<T, Deleter, Alloc>(
+        allocator,
+        std::forward<ArgsT>(args)...);
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the array of size value
+ * initialized elements. The elements and the control block share a single
+ * allocation, obtained from the allocator.
+ *
+ * @tparam T Array type, e.g. int[]
+ * @tparam Deleter
+ * @tparam Alloc
+ * @param allocator
+ * @param size
+ * @return rc_ptr<T, Deleter, Alloc>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc,
+         typename = std::enable_if_t<detail::is_unbounded_array_v<T>>>
+rc_ptr<T, Deleter, Alloc> allocate_rc(const Alloc& allocator, std::size_t size)
+{
+    return detail::rc_ptr_access::make_inplace_array<T, Deleter, Alloc>(
+        allocator,
+        size,
+        [size](auto elements) {
+            std::uninitialized_value_construct_n(elements, size);
+        });
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the array of size elements,
+ * each initialized to a copy of value. The elements and the control block
+ * share a single allocation, obtained from the allocator.
+ *
+ * @tparam T Array type, e.g. int[]
+ * @tparam Deleter
+ * @tparam Alloc
+ * @param allocator
+ * @param size
+ * @param value
+ * @return rc_ptr<T, Deleter, Alloc>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc,
+         typename = std::enable_if_t<detail::is_unbounded_array_v<T>>>
+rc_ptr<T, Deleter, Alloc> allocate_rc(const Alloc&                    allocator,
+                                      std::size_t                     size,
+                                      const std::remove_extent_t<T>& value)
+{
+    return detail::rc_ptr_access::make_inplace_array<T, Deleter, Alloc>(
+        allocator,
+        size,
+        [size, &value](auto elements) {
+            std::uninitialized_fill_n(elements, size, value);
+        });
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the array of size default
+ * initialized elements, which leaves trivial elements, e.g. bytes of a
+ * buffer about to be filled, uninitialized. The elements and the control
+ * block share a single allocation, obtained from the allocator.
+ *
+ * @tparam T Array type, e.g. std::byte[]
+ * @tparam Deleter
+ * @tparam Alloc
+ * @param allocator
+ * @param size
+ * @return rc_ptr<T, Deleter, Alloc>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc,
+         typename = std::enable_if_t<detail::is_unbounded_array_v<T>>>
+rc_ptr<T, Deleter, Alloc> allocate_rc_for_overwrite(const Alloc& allocator,
+                                                    std::size_t  size)
+{
+    return detail::rc_ptr_access::make_inplace_array<T, Deleter, Alloc>(
+        allocator,
+        size,
+        [size](auto elements) {
+            std::uninitialized_default_construct_n(elements, size);
+        });
+}
+
+/**
+ * @brief Creates the rc_ptr instance, forwarding the arguments to the
+ * constructor of type T. The object and the control block share a single
+ * allocation.
+ *
+ * @tparam T
+ * @tparam ArgsT
+ * @param args
+ * @return rc_ptr<T>
+ */
+template<typename T, typename... ArgsT,
+         typename = std::enable_if_t<!std::is_array_v<T>>>
+rc_ptr<T> make_rc(ArgsT&&... args)
+{
+    return detail::rc_ptr_access::make_inplace<T,
+                                               std::default_delete<T>,
+                                               std::allocator<T>>(
+        std::allocator<T>{},
+        std::forward<ArgsT>(args)...);
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the array of size value
+ * initialized elements. The elements and the control block share a single
+ * allocation.
+ *
+ * @tparam T Array type, e.g. int[]
+ * @param size
+ * @return rc_ptr<T>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename T,
+         typename = std::enable_if_t<detail::is_unbounded_array_v<T>>>
+rc_ptr<T> make_rc(std::size_t size)
+{
+    return allocate_rc<T>(std::allocator<T>{}, size);
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the array of size elements,
+ * each initialized to a copy of value. The elements and the control block
+ * share a single allocation.
+ *
+ * @tparam T Array type, e.g. int[]
+ * @param size
+ * @param value
+ * @return rc_ptr<T>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename T,
+         typename = std::enable_if_t<detail::is_unbounded_array_v<T>>>
+rc_ptr<T> make_rc(std::size_t size, const std::remove_extent_t<T>& value)
+{
+    return allocate_rc<T>(std::allocator<T>{}, size, value);
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the array of size default
+ * initialized elements. See allocate_rc_for_overwrite.
+ *
+ * @tparam T Array type, e.g. std::byte[]
+ * @param size
+ * @return rc_ptr<T>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename T,
+         typename = std::enable_if_t<detail::is_unbounded_array_v<T>>>
+rc_ptr<T> make_rc_for_overwrite(std::size_t size)
+{
+    return allocate_rc_for_overwrite<T>(std::allocator<T>{}, size);
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the header of type Header
+ * followed by count value initialized elements of type Elem. The control
+ * block, the header and the elements share a single allocation. The
+ * elements are initialized before the header, which may fill them from its
+ * constructor, and destroyed after it.
+ *
+ * The elements are accessed with flex_data, flex_size and flex_span.
+ * emplace() on the returned rc_ptr replaces the header with an object
+ * without trailer.
+ *
+ * @tparam Header
+ * @tparam Elem
+ * @tparam Deleter
+ * @tparam Alloc
+ * @tparam ArgsT
+ * @param allocator
+ * @param count Number of elements
+ * @param args Arguments forwarded to the constructor of Header
+ * @return rc_ptr<Header, Deleter, Alloc>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename Header, typename Elem,
+         typename Deleter = std::default_delete<Header>, typename Alloc,
+         typename... ArgsT>
+rc_ptr<Header, Deleter, Alloc> allocate_rc_flex(const Alloc& allocator,
+                                                std::size_t  count,
+                                                ArgsT&&... args)
+{
+    static_assert(!std::is_array_v<Header> && !std::is_array_v<Elem>,
+                  "Header and Elem must not be arrays.");
+
+    return detail::rc_ptr_access::
+        make_inplace_flex<Header, Elem, Deleter, Alloc>(
+            allocator,
+            count,
+            std::forward<ArgsT>(args)...);
+}
+
+/**
+ * @brief Creates the rc_ptr instance managing the header of type Header
+ * followed by count value initialized elements of type Elem, in a single
+ * allocation. See allocate_rc_flex.
+ *
+ * @tparam Header
+ * @tparam Elem
+ * @tparam ArgsT
+ * @param count Number of elements
+ * @param args Arguments forwarded to the constructor of Header
+ * @return rc_ptr<Header>
+ * @throws std::bad_array_new_length if the allocation size overflows
+ * std::size_t
+ */
+template<typename Header, typename Elem, typename... ArgsT>
+rc_ptr<Header> make_rc_flex(std::size_t count, ArgsT&&... args)
+{
+    return allocate_rc_flex<Header, Elem>(std::allocator<Header>{},
+                                          count,
+                                          std::forward<ArgsT>(args)...);
+}
+
+/**
+ * @brief Returns the pointer to the elements following the header created by
+ * make_rc_flex or allocate_rc_flex. Elem must match the element type used
+ * at the creation.
+ *
+ * @tparam Elem
+ * @tparam Header
+ * @param header
+ * @return Elem*
+ */
+template<typename Elem, typename Header>
+Elem* flex_data(Header* header) noexcept
+{
+    assert(header);
+    return detail::flex_layout<void*, Header, Elem>::trailer(header);
+}
+
+/**
+ * @brief Returns the number of elements following the header created by
+ * make_rc_flex or allocate_rc_flex.
+ *
+ * @tparam Header
+ * @param header
+ * @return std::size_t
+ */
+template<typename Header>
+std::size_t flex_size(const Header* header) noexcept
+{
+    assert(header);
+    return *detail::flex_layout<void*, Header, char>::count(header);
+}
+
+#if defined(__cpp_lib_span)
+/**
+ * @brief Returns the view of the elements following the header created by
+ * make_rc_flex or allocate_rc_flex.
+ *
+ * @tparam Elem
+ * @tparam Header
+ * @param header
+ * @return std::span<Elem>
+ */
+template<typename Elem, typename Header>
+std::span<Elem> flex_span(Header* header) noexcept
+{
+    return { flex_data<Elem>(header), flex_size(header) };
+}
+#endif
 
 /**
- * @brief enable_rc_from_this class template allows to safely create rc_ptr and
- * weak_rc_ptr object from this pointer.
+ * @brief Creates count rc_ptr instances, constructing the object i from the
+ * result of init(i). All the objects and their control blocks are placed
+ * contiguously in a single allocation, obtained from the allocator. Each
+ * object is owned independently and destroyed when its last rc_ptr is gone;
+ * the allocation is released when all of the control blocks are. The returned
+ * vector uses Alloc rebound to its element type.
  *
  * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ * @tparam Init
+ * @param allocator
+ * @param count
+ * @param init Invocable with std::size_t, returning the object or the
+ * argument for the constructor of T
+ * @return std::vector of rc_ptr<T, Deleter, Alloc>, allocated with Alloc
+ * @throws std::bad_array_new_length if the slab size overflows std::size_t
  */
-template<typename T>
-class enable_rc_from_this
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc, typename Init>
+detail::slab_vector<T, Deleter, Alloc>
+    allocate_rc_n(const Alloc& allocator, std::size_t count, Init init)
 {
-protected:
-    constexpr enable_rc_from_this()                 = default;
-    enable_rc_from_this(const enable_rc_from_this&) = default;
-    enable_rc_from_this(enable_rc_from_this&&)      = default;
-    ~enable_rc_from_this()                          = default;
-
-    enable_rc_from_this& operator=(const enable_rc_from_this&) = default;
-    enable_rc_from_this& operator=(enable_rc_from_this&&) = default;
-
-public:
-    /**
-     * @brief Creates the rc_ptr object from this.
-     *
-     * @return rc_ptr<T>
-     */
-    rc_ptr<T> rc_from_this()
-    {
-        return m_weak.lock();
-    }
-
-    /**
-     * @brief Creates the rc_ptr object from this.
-     *
-     * @return rc_ptr<const T>
-     */
-    rc_ptr<const T> rc_from_this() const
-    {
-        return m_weak.lock();
-    }
+    static_assert(!std::is_array_v<T>, "T must not be an array.");
 
-    /**
-     * @brief Creates the weak_rc_ptr object from this.
-     *
-     * @return weak_rc_ptr<T>
-     */
-    weak_rc_ptr<T> weak_rc_from_this()
-    {
-        return m_weak;
-    }
+    return detail::rc_ptr_access::make_slab<T, Deleter, Alloc>(allocator,
+                                                               count,
+                                                               init);
+}
 
-    /**
-     * @brief Creates the weak_rc_ptr object from this.
-     *
-     * @return weak_rc_ptr<const T>
-     */
-    weak_rc_ptr<const T> weak_rc_from_this() const
-    {
-        return m_weak;
-    }
+/**
+ * @brief Creates count rc_ptr instances in a single allocation, constructing
+ * the object i from the result of init(i). See allocate_rc_n.
+ *
+ * @tparam T
+ * @tparam Init
+ * @param count
+ * @param init Invocable with std::size_t, returning the object or the
+ * argument for the constructor of T
+ * @return std::vector<rc_ptr<T>>
+ */
+template<typename T, typename Init>
+std::vector<rc_ptr<T>> make_rc_n(std::size_t count, Init init)
+{
+    return allocate_rc_n<T>(std::allocator<T>{}, count, std::move(init));
+}
 
-private:
-    friend class rc_ptr<T>;
+/**
+ * @brief Creates the immortal rc_ptr instance, forwarding the arguments to the
+ * constructor of type T. Copying and destroying rc_ptr objects managing an
+ * immortal object does not modify the reference count, which avoids writes to
+ * the control block of widely shared objects. The object is never destroyed
+ * and its memory is never released.
+ *
+ * @tparam T
+ * @tparam ArgsT
+ * @param args
+ * @return rc_ptr<T>
+ */
+template<typename T, typename... ArgsT>
+rc_ptr<T> make_immortal_rc(ArgsT&&... args)
+{
+    return detail::rc_ptr_access::make_immortal<T,
+                                                std::default_delete<T>,
+                                                std::allocator<T>>(
+        std::allocator<T>{},
+        std::forward<ArgsT>(args)...);
+}
 
-    mutable weak_rc_ptr<T> m_weak;
-};
+/**
+ * @brief Creates rc_ptr instance with the last release hook, using the
+ * allocator. Args are forwarded to the constructor of type T. When the
+ * reference count reaches zero, hook is called with rc_ptr<T, Deleter, Alloc>&
+ * holding the last reference. If the hook moves or copies the rc_ptr away,
+ * for example to a pool, the object is resurrected. Otherwise, the object is
+ * destroyed after the hook returns. The hook runs every time the count reaches
+ * zero and must not throw.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ * @tparam Hook
+ * @tparam ArgsT
+ * @param allocator
+ * @param hook
+ * @param args
+ * @return rc_ptr<T, Deleter, Alloc>
+ */
+template<typename T, typename Deleter = std::default_delete<T>,
+         typename Alloc = std::allocator<T>, typename Hook, typename... ArgsT>
+rc_ptr<T, Deleter, Alloc> allocate_hooked_rc(const Alloc& allocator,
+                                             Hook&&       hook,
+                                             ArgsT&&... args)
+{
+    static_assert(!std::is_array_v<T>,
+                  "allocate_hooked_rc does not support arrays.");
+    static_assert(
+        std::is_invocable_v<std::decay_t<Hook>&, rc_ptr<T, Deleter, Alloc>&>,
+        "Hook must be invocable with rc_ptr<T, Deleter, Alloc>&.");
+
+    return detail::rc_ptr_access::make_hooked<T, Hook, Deleter, Alloc>(
+        allocator,
+        std::forward<Hook>(hook),
+        std::forward<ArgsT>(args)...);
+}
 
 /**
- * @brief Creates the rc_ptr instance, forwarding the arguments to the
- * constructor of type T.
+ * @brief Creates rc_ptr instance with the last release hook. See
+ * allocate_hooked_rc.
  *
  * @tparam T
+ * @tparam Hook
  * @tparam ArgsT
+ * @param hook
  * @param args
  * @return rc_ptr<T>
  */
-template<typename T, typename... ArgsT>
-rc_ptr<T> make_rc(ArgsT&&... args)
+template<typename T, typename Hook, typename... ArgsT>
+rc_ptr<T> make_hooked_rc(Hook&& hook, ArgsT&&... args)
 {
-    return rc_ptr<T>{ new T{ std::forward<ArgsT>(args)... } };
+    return allocate_hooked_rc<T>(std::allocator<T>{},
+                                 std::forward<Hook>(hook),
+                                 std::forward<ArgsT>(args)...);
 }
 
 /**
@@ -1073,6 +3370,327 @@ struct owner_less<weak_rc_ptr<T, Deleter, Alloc>> {
     };
 };
 
+/**
+ * @brief Function object providing the owner based hash of rc_ptr and
+ * weak_rc_ptr objects, for the unordered containers keyed by the identity of
+ * the control block.
+ *
+ */
+struct owner_hash {
+    using is_transparent = void;
+
+    template<typename Ptr>
+    std::size_t operator()(const Ptr& ptr) const noexcept
+    {
+        return ptr.owner_hash();
+    }
+};
+
+/**
+ * @brief Function object providing the owner based equality of rc_ptr and
+ * weak_rc_ptr objects. Used together with owner_hash.
+ *
+ */
+struct owner_equal {
+    using is_transparent = void;
+
+    template<typename Left, typename Right>
+    bool operator()(const Left& lhs, const Right& rhs) const noexcept
+    {
+        return lhs.owner_equal(rhs);
+    }
+};
+
+/**
+ * @brief Trait telling whether moving the object of type T to another address
+ * and destroying the source is equivalent to copying its bytes. Specialize it
+ * for types holding no pointers to themselves. Default are trivially copyable
+ * types.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+};
+
+template<typename T, typename Deleter, typename Alloc>
+struct is_trivially_relocatable<rc_ptr<T, Deleter, Alloc>> : std::true_type {
+};
+
+template<typename T, typename Deleter, typename Alloc>
+struct is_trivially_relocatable<weak_rc_ptr<T, Deleter, Alloc>> :
+    std::true_type {
+};
+
+template<typename T, typename Deleter, typename Alloc>
+struct is_trivially_relocatable<rc_borrow<T, Deleter, Alloc>> : std::true_type {
+};
+
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+/**
+ * @brief Moves the objects from [first, last) to the uninitialized memory at
+ * dest and ends the lifetime of the source objects. The ranges may overlap
+ * for trivially relocatable types, which are copied with memmove.
+ *
+ * @tparam T
+ * @param first
+ * @param last
+ * @param dest
+ * @return T* End of the destination range.
+ */
+template<typename T>
+T* uninitialized_relocate(T* first, T* last, T* dest) noexcept
+{
+    static_assert(is_trivially_relocatable_v<T> ||
+                      std::is_nothrow_move_constructible_v<T>,
+                  "T must be trivially relocatable or nothrow movable.");
+
+    if constexpr (is_trivially_relocatable_v<T>)
+    {
+        const auto count = static_cast<std::size_t>(last - first);
+
+        if (count != 0)
+        {
+            std::memmove(detail::voidify(dest),
+                         detail::voidify(first),
+                         count * sizeof(T));
+        }
+
+        return dest + count;
+    }
+    else
+    {
+        for (; first != last; ++first, ++dest)
+        {
+            ::new (detail::voidify(dest)) T(std::move(*first));
+            std::destroy_at(first);
+        }
+
+        return dest;
+    }
+}
+
+namespace detail
+{
+template<typename T>
+struct is_rc_ptr : std::false_type {
+};
+
+template<typename T, typename Deleter, typename Alloc>
+struct is_rc_ptr<rc_ptr<T, Deleter, Alloc>> : std::true_type {
+};
+
+/**
+ * @brief Prefetches the control blocks of the rc_ptr objects in a range,
+ * staying distance elements ahead of the processed one.
+ *
+ * @tparam ForwardIt
+ */
+template<typename ForwardIt>
+class block_prefetcher
+{
+public:
+    static constexpr std::size_t distance = 16;
+
+    block_prefetcher(ForwardIt first, ForwardIt last) noexcept :
+        m_ahead{ first },
+        m_last{ last }
+    {
+        for (std::size_t i = 0; i != distance; ++i)
+        {
+            advance();
+        }
+    }
+
+    // Called once per processed element.
+    void advance() noexcept
+    {
+        if (m_ahead == m_last)
+        {
+            return;
+        }
+
+        prefetch_for_write(rc_ptr_access::get_control_block(*m_ahead));
+        ++m_ahead;
+    }
+
+private:
+    ForwardIt m_ahead;
+    ForwardIt m_last;
+};
+} // namespace detail
+
+/**
+ * @brief Releases all rc_ptr objects in [first, last), leaving them empty.
+ * Consecutive objects sharing the control block are released with a single
+ * decrement and the control blocks ahead are prefetched. The managed objects
+ * are destroyed after all the counts are updated.
+ *
+ * @tparam ForwardIt
+ * @param first
+ * @param last
+ */
+template<typename ForwardIt>
+void rc_release_range(ForwardIt first, ForwardIt last) noexcept
+{
+    using access = detail::rc_ptr_access;
+
+    detail::block_prefetcher<ForwardIt> prefetcher{ first, last };
+
+    // The objects holding the last references are moved to [begin, keep)
+    // and reset at the end.
+    const auto begin = first;
+    auto       keep  = first;
+
+    detail::control_block_base* run_block = nullptr;
+    std::size_t                 run_count = 0;
+    ForwardIt                   run_owner = first;
+
+    auto flush = [&]() noexcept {
+        if (!run_block)
+        {
+            return;
+        }
+
+        if (run_block->get_ref_count() == run_count)
+        {
+            run_block->decrease_ref_count(run_count - 1);
+
+            if (keep != run_owner)
+            {
+                *keep = std::move(*run_owner);
+            }
+
+            ++keep;
+            return;
+        }
+
+        run_block->decrease_ref_count(run_count);
+        access::drop(*run_owner);
+    };
+
+    for (; first != last; ++first)
+    {
+        prefetcher.advance();
+
+        auto block = access::get_control_block(*first);
+
+        if (!block)
+        {
+            continue;
+        }
+
+        if (block == run_block)
+        {
+            ++run_count;
+            access::drop(*first);
+            continue;
+        }
+
+        flush();
+        run_block = block;
+        run_count = 1;
+        run_owner = first;
+    }
+
+    flush();
+
+    for (auto it = begin; it != keep; ++it)
+    {
+        it->reset();
+    }
+}
+
+/**
+ * @brief Resets all rc_ptr objects in [first, last) in order, prefetching the
+ * control blocks of the following ones. Unlike rc_release_range, the managed
+ * objects are destroyed as soon as their last reference is released, so each
+ * control block is loaded once. Preferred for the large ranges of the cold
+ * pointers.
+ *
+ * @tparam ForwardIt
+ * @param first
+ * @param last
+ */
+template<typename ForwardIt>
+void rc_reset_range(ForwardIt first, ForwardIt last) noexcept
+{
+    detail::block_prefetcher<ForwardIt> prefetcher{ first, last };
+
+    for (; first != last; ++first)
+    {
+        prefetcher.advance();
+        first->reset();
+    }
+}
+
+/**
+ * @brief Destroys all the elements of the container of rc_ptr objects. The
+ * elements are reset by rc_reset_range first, so the control blocks are
+ * prefetched ahead instead of being loaded one by one by the destructors.
+ *
+ * @tparam Container
+ * @param container
+ */
+template<typename Container>
+void rc_clear(Container& container) noexcept
+{
+    rc_reset_range(std::begin(container), std::end(container));
+    container.clear();
+}
+
 } // namespace RC_PTR_NAMESPACE
 
+namespace std
+{
+/**
+ * @brief Hash of the stored pointer.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ */
+template<typename T, typename Deleter, typename Alloc>
+struct hash<RC_PTR_NAMESPACE::rc_ptr<T, Deleter, Alloc>> {
+    std::size_t operator()(
+        const RC_PTR_NAMESPACE::rc_ptr<T, Deleter, Alloc>& ptr) const noexcept
+    {
+        return std::hash<typename RC_PTR_NAMESPACE::rc_ptr<T, Deleter, Alloc>::
+                             pointer>{}(ptr.get());
+    }
+};
+
+/**
+ * @brief rc_ptr names the allocator of its control block, not one it can be
+ * constructed with, so containers must not pass theirs on construction.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ * @tparam OtherAlloc
+ */
+template<typename T, typename Deleter, typename Alloc, typename OtherAlloc>
+struct uses_allocator<RC_PTR_NAMESPACE::rc_ptr<T, Deleter, Alloc>, OtherAlloc>
+    : false_type
+{
+};
+
+/**
+ * @brief See uses_allocator of rc_ptr.
+ *
+ * @tparam T
+ * @tparam Deleter
+ * @tparam Alloc
+ * @tparam OtherAlloc
+ */
+template<typename T, typename Deleter, typename Alloc, typename OtherAlloc>
+struct uses_allocator<RC_PTR_NAMESPACE::weak_rc_ptr<T, Deleter, Alloc>,
+                      OtherAlloc> : false_type
+{
+};
+} // namespace std
+
 #endif
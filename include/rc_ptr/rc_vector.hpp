@@ -0,0 +1,606 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_VECTOR_HPP
+#define RC_VECTOR_HPP
+
+#include <initializer_list>
+#include <utility>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+/**
+ * @brief rc_vector class template is a sequence container of trivially
+ * relocatable elements, such as rc_ptr. Growth, insertion and erasure move
+ * the elements with memcpy and memmove instead of calling the move
+ * constructors and destructors of each one.
+ *
+ * @tparam T Element type, is_trivially_relocatable_v<T> must be true.
+ * @tparam Alloc Default is std::allocator<T>.
+ */
+template<typename T, typename Alloc = std::allocator<T>>
+class rc_vector
+{
+    static_assert(is_trivially_relocatable_v<T>,
+                  "rc_vector requires trivially relocatable elements.");
+
+public:
+    using value_type      = T;
+    using allocator_type  = Alloc;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using iterator        = T*;
+    using const_iterator  = const T*;
+
+    /**
+     * @brief Constructs an empty container.
+     *
+     * @param allocator
+     */
+    explicit rc_vector(
+        const allocator_type& allocator = allocator_type{}) noexcept :
+        m_allocator{ allocator },
+        m_begin{ nullptr },
+        m_end{ nullptr },
+        m_capacity{ nullptr }
+    {
+    }
+
+    /**
+     * @brief Constructs the container with the copies of the elements of
+     * init.
+     *
+     * @param init
+     * @param allocator
+     */
+    rc_vector(std::initializer_list<T> init,
+              const allocator_type&    allocator = allocator_type{}) :
+        rc_vector{ allocator }
+    {
+        reserve(init.size());
+
+        for (const auto& value : init)
+        {
+            push_back(value);
+        }
+    }
+
+    /**
+     * @brief Copy constructor.
+     *
+     * @param other
+     */
+    rc_vector(const rc_vector& other) :
+        rc_vector{ allocator_traits::select_on_container_copy_construction(
+            other.m_allocator) }
+    {
+        reserve(other.size());
+
+        for (const auto& value : other)
+        {
+            push_back(value);
+        }
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * @param other
+     */
+    rc_vector(rc_vector&& other) noexcept : rc_vector{ other.m_allocator }
+    {
+        swap(other);
+    }
+
+    /**
+     * @brief Destroys the elements and releases the storage.
+     *
+     */
+    ~rc_vector()
+    {
+        clear();
+        deallocate();
+    }
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * @param other
+     * @return rc_vector&
+     */
+    rc_vector& operator=(const rc_vector& other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        constexpr bool propagate =
+            allocator_traits::propagate_on_container_copy_assignment::value;
+
+        rc_vector copy{ propagate ? other.m_allocator : m_allocator };
+        copy.reserve(other.size());
+
+        for (const auto& value : other)
+        {
+            copy.push_back(value);
+        }
+
+        if constexpr (propagate)
+        {
+            clear();
+            deallocate();
+            m_allocator = other.m_allocator;
+        }
+
+        take_storage(copy);
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator. The storage of other is taken when
+     * the allocator propagates or the allocators compare equal, otherwise
+     * the elements are relocated into a new storage.
+     *
+     * @param other
+     * @return rc_vector&
+     */
+    rc_vector& operator=(rc_vector&& other) noexcept(
+        allocator_traits::propagate_on_container_move_assignment::value ||
+        allocator_traits::is_always_equal::value)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        if constexpr (allocator_traits::propagate_on_container_move_assignment::
+                          value)
+        {
+            clear();
+            deallocate();
+            m_allocator = std::move(other.m_allocator);
+        }
+        else if (m_allocator != other.m_allocator)
+        {
+            rc_vector moved{ m_allocator };
+            moved.reserve(other.size());
+            moved.m_end = relocate_to_storage(other.m_begin,
+                                              other.m_end,
+                                              moved.m_begin);
+            other.m_end = other.m_begin;
+
+            take_storage(moved);
+            return *this;
+        }
+
+        take_storage(other);
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        return m_begin;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return m_begin;
+    }
+
+    iterator end() noexcept
+    {
+        return m_end;
+    }
+
+    const_iterator end() const noexcept
+    {
+        return m_end;
+    }
+
+    pointer data() noexcept
+    {
+        return m_begin;
+    }
+
+    const_pointer data() const noexcept
+    {
+        return m_begin;
+    }
+
+    size_type size() const noexcept
+    {
+        return static_cast<size_type>(m_end - m_begin);
+    }
+
+    size_type capacity() const noexcept
+    {
+        return static_cast<size_type>(m_capacity - m_begin);
+    }
+
+    bool empty() const noexcept
+    {
+        return (m_begin == m_end);
+    }
+
+    reference operator[](size_type index) noexcept
+    {
+        assert(index < size());
+        return m_begin[index];
+    }
+
+    const_reference operator[](size_type index) const noexcept
+    {
+        assert(index < size());
+        return m_begin[index];
+    }
+
+    reference front() noexcept
+    {
+        assert(!empty());
+        return *m_begin;
+    }
+
+    const_reference front() const noexcept
+    {
+        assert(!empty());
+        return *m_begin;
+    }
+
+    reference back() noexcept
+    {
+        assert(!empty());
+        return *(m_end - 1);
+    }
+
+    const_reference back() const noexcept
+    {
+        assert(!empty());
+        return *(m_end - 1);
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return m_allocator;
+    }
+
+    /**
+     * @brief Makes room for at least count elements. The elements are
+     * relocated with a single memcpy.
+     *
+     * @param count
+     */
+    void reserve(size_type count)
+    {
+        if (count <= capacity())
+        {
+            return;
+        }
+
+        reallocate(count, m_end, 0);
+    }
+
+    /**
+     * @brief Releases the unused capacity.
+     *
+     */
+    void shrink_to_fit()
+    {
+        if (m_end == m_capacity)
+        {
+            return;
+        }
+
+        if (empty())
+        {
+            deallocate();
+            return;
+        }
+
+        reallocate(size(), m_end, 0);
+    }
+
+    /**
+     * @brief Constructs the element at the end, forwarding args to its
+     * constructor.
+     *
+     * @tparam ArgsT
+     * @param args
+     * @return reference
+     */
+    template<typename... ArgsT>
+    reference emplace_back(ArgsT&&... args)
+    {
+        if (m_end != m_capacity)
+        {
+            detail::construct_object(m_end, std::forward<ArgsT>(args)...);
+            return *m_end++;
+        }
+
+        return *emplace_grow(m_end, std::forward<ArgsT>(args)...);
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    /**
+     * @brief Constructs the element before pos, forwarding args to its
+     * constructor. The following elements are shifted with memmove.
+     *
+     * @tparam ArgsT
+     * @param pos
+     * @param args
+     * @return iterator Iterator to the new element.
+     */
+    template<typename... ArgsT>
+    iterator emplace(const_iterator pos, ArgsT&&... args)
+    {
+        assert(m_begin <= pos && pos <= m_end);
+
+        auto position = const_cast<iterator>(pos);
+
+        if (m_end == m_capacity)
+        {
+            return emplace_grow(position, std::forward<ArgsT>(args)...);
+        }
+
+        // Constructed aside first, args may refer to the elements.
+        storage_type value;
+        auto         object = detail::construct_object(
+            reinterpret_cast<T*>(value.bytes),
+            std::forward<ArgsT>(args)...);
+
+        uninitialized_relocate(position, m_end, position + 1);
+        uninitialized_relocate(object, object + 1, position);
+        ++m_end;
+        return position;
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+    {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, T&& value)
+    {
+        return emplace(pos, std::move(value));
+    }
+
+    /**
+     * @brief Destroys the last element.
+     *
+     */
+    void pop_back() noexcept
+    {
+        assert(!empty());
+        std::destroy_at(--m_end);
+    }
+
+    /**
+     * @brief Destroys the element at pos. The following elements are shifted
+     * with memmove.
+     *
+     * @param pos
+     * @return iterator Iterator following the erased element.
+     */
+    iterator erase(const_iterator pos) noexcept
+    {
+        return erase(pos, pos + 1);
+    }
+
+    /**
+     * @brief Destroys the elements in [first, last). The following elements
+     * are shifted with memmove.
+     *
+     * @param first
+     * @param last
+     * @return iterator Iterator following the erased elements.
+     */
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        assert(m_begin <= first && first <= last && last <= m_end);
+
+        auto begin = const_cast<iterator>(first);
+        auto end   = const_cast<iterator>(last);
+
+        std::destroy(begin, end);
+        m_end = uninitialized_relocate(end, m_end, begin);
+        return begin;
+    }
+
+    /**
+     * @brief Changes the number of elements. New elements are value
+     * initialized.
+     *
+     * @param count
+     */
+    void resize(size_type count)
+    {
+        if (count <= size())
+        {
+            erase(m_begin + count, m_end);
+            return;
+        }
+
+        reserve(count);
+
+        while (size() != count)
+        {
+            emplace_back();
+        }
+    }
+
+    /**
+     * @brief Destroys all the elements, the capacity is kept. rc_ptr elements
+     * are released by rc_reset_range.
+     *
+     */
+    void clear() noexcept
+    {
+        if constexpr (detail::is_rc_ptr<T>::value)
+        {
+            rc_reset_range(m_begin, m_end);
+        }
+
+        std::destroy(m_begin, m_end);
+        m_end = m_begin;
+    }
+
+    /**
+     * @brief Swaps the contents with other.
+     *
+     * @param other
+     */
+    void swap(rc_vector& other) noexcept
+    {
+        using std::swap;
+
+        if constexpr (allocator_traits::propagate_on_container_swap::value)
+        {
+            swap(m_allocator, other.m_allocator);
+        }
+
+        swap(m_begin, other.m_begin);
+        swap(m_end, other.m_end);
+        swap(m_capacity, other.m_capacity);
+    }
+
+private:
+    using allocator_traits = std::allocator_traits<allocator_type>;
+
+    struct storage_type
+    {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    size_type grown_capacity() const noexcept
+    {
+        return std::max<size_type>(2 * capacity(), 4);
+    }
+
+    // Relocates [first, last) to dest, which is in a storage different from
+    // the one of the source. Unlike uninitialized_relocate, the ranges are
+    // known not to overlap, so memcpy is used with an explicit size.
+    static iterator relocate_to_storage(iterator first,
+                                        iterator last,
+                                        iterator dest) noexcept
+    {
+        const auto count = static_cast<size_type>(last - first);
+
+        if (count != 0)
+        {
+            std::memcpy(detail::voidify(dest),
+                        detail::voidify(first),
+                        count * sizeof(T));
+        }
+
+        return dest + count;
+    }
+
+    // Moves the elements to a new storage for count elements, leaving a gap
+    // of gap elements before pos.
+    void reallocate(size_type count, iterator pos, size_type gap)
+    {
+        auto storage = allocator_traits::allocate(m_allocator, count);
+        auto end     = relocate_to_storage(m_begin, pos, storage) + gap;
+        end          = relocate_to_storage(pos, m_end, end);
+
+        if (m_begin)
+        {
+            allocator_traits::deallocate(m_allocator, m_begin, capacity());
+        }
+
+        m_begin    = storage;
+        m_end      = end;
+        m_capacity = storage + count;
+    }
+
+    template<typename... ArgsT>
+    iterator emplace_grow(iterator pos, ArgsT&&... args)
+    {
+        const auto index = static_cast<size_type>(pos - m_begin);
+
+        storage_type value;
+        auto         object = detail::construct_object(
+            reinterpret_cast<T*>(value.bytes),
+            std::forward<ArgsT>(args)...);
+
+        try
+        {
+            reallocate(grown_capacity(), pos, 1);
+        }
+        catch (...)
+        {
+            std::destroy_at(object);
+            throw;
+        }
+
+        uninitialized_relocate(object, object + 1, m_begin + index);
+        return m_begin + index;
+    }
+
+    // Replaces the elements with the ones of other, whose storage can be
+    // released by m_allocator. other is left empty.
+    void take_storage(rc_vector& other) noexcept
+    {
+        clear();
+        deallocate();
+
+        m_begin    = std::exchange(other.m_begin, nullptr);
+        m_end      = std::exchange(other.m_end, nullptr);
+        m_capacity = std::exchange(other.m_capacity, nullptr);
+    }
+
+    void deallocate() noexcept
+    {
+        if (!m_begin)
+        {
+            return;
+        }
+
+        allocator_traits::deallocate(m_allocator, m_begin, capacity());
+        m_begin    = nullptr;
+        m_end      = nullptr;
+        m_capacity = nullptr;
+    }
+
+    allocator_type m_allocator;
+    pointer        m_begin;
+    pointer        m_end;
+    pointer        m_capacity;
+};
+
+/**
+ * @brief Swaps the contents of left and right.
+ *
+ * @tparam T
+ * @tparam Alloc
+ * @param left
+ * @param right
+ */
+template<typename T, typename Alloc>
+void swap(rc_vector<T, Alloc>& left, rc_vector<T, Alloc>& right) noexcept
+{
+    left.swap(right);
+}
+
+} // namespace RC_PTR_NAMESPACE
+
+#endif
@@ -0,0 +1,411 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef TAGGED_RC_PTR_HPP
+#define TAGGED_RC_PTR_HPP
+
+#include <cstdint>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace RC_PTR_NAMESPACE
+{
+/**
+ * @brief tagged_rc_ptr class template is rc_ptr storing up to Bits bits of
+ * user data in the low bits of the control block pointer, which are always
+ * zero due to its alignment. The size of tagged_rc_ptr is the same as the
+ * size of rc_ptr.
+ *
+ * @tparam T Type of the managed object, arrays are not supported.
+ * @tparam Bits Number of tag bits, limited by the alignment of the control
+ * block.
+ * @tparam Deleter
+ * @tparam Alloc
+ */
+template<typename T, std::size_t Bits,
+         typename Deleter = std::default_delete<T>,
+         typename Alloc = std::allocator<T>>
+class tagged_rc_ptr
+{
+    static_assert(!std::is_array_v<T>,
+                  "tagged_rc_ptr does not support arrays.");
+
+public:
+    using rc_type        = rc_ptr<T, Deleter, Alloc>;
+    using weak_type      = weak_rc_ptr<T, Deleter, Alloc>;
+    using element_type   = typename rc_type::element_type;
+    using pointer        = typename rc_type::pointer;
+    using reference      = typename rc_type::reference;
+    using deleter_type   = Deleter;
+    using allocator_type = Alloc;
+    using tag_type       = std::uintptr_t;
+
+    /**
+     * @brief Mask of the tag bits.
+     *
+     */
+    static constexpr tag_type tag_mask = (tag_type{ 1 } << Bits) - 1;
+
+    /**
+     * @brief Constructs an empty tagged_rc_ptr with zero tag.
+     *
+     */
+    constexpr tagged_rc_ptr() noexcept : m_ptr{ pointer() }, m_bits{ 0 }
+    {
+    }
+
+    /**
+     * @brief Constructs an empty tagged_rc_ptr with zero tag.
+     *
+     */
+    constexpr tagged_rc_ptr(std::nullptr_t) noexcept : tagged_rc_ptr{}
+    {
+    }
+
+    /**
+     * @brief Constructs tagged_rc_ptr sharing the ownership with ptr.
+     *
+     * @param ptr
+     * @param tag
+     */
+    tagged_rc_ptr(const rc_type& ptr, tag_type tag = 0) noexcept :
+        tagged_rc_ptr{ rc_type{ ptr }, tag }
+    {
+    }
+
+    /**
+     * @brief Constructs tagged_rc_ptr taking over the ownership from ptr.
+     *
+     * @param ptr
+     * @param tag
+     */
+    tagged_rc_ptr(rc_type&& ptr, tag_type tag = 0) noexcept :
+        m_ptr{ ptr.get() },
+        m_bits{ reinterpret_cast<tag_type>(
+            detail::rc_ptr_access::get_control_block(ptr)) }
+    {
+        assert((tag & ~tag_mask) == 0 && "Tag does not fit in Bits.");
+        m_bits |= tag;
+        detail::rc_ptr_access::drop(ptr);
+    }
+
+    /**
+     * @brief Copy constructor.
+     *
+     * @param other
+     */
+    tagged_rc_ptr(const tagged_rc_ptr& other) noexcept :
+        m_ptr{ other.m_ptr },
+        m_bits{ other.m_bits }
+    {
+        if (auto block = get_control_block())
+        {
+            block->increase_ref_count();
+        }
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * @param other
+     */
+    tagged_rc_ptr(tagged_rc_ptr&& other) noexcept : tagged_rc_ptr{}
+    {
+        swap(other);
+    }
+
+    /**
+     * @brief Releases the ownership of the managed object.
+     *
+     */
+    ~tagged_rc_ptr()
+    {
+        if (auto block = get_control_block())
+        {
+            block->release_ref();
+        }
+    }
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * @param other
+     * @return tagged_rc_ptr&
+     */
+    tagged_rc_ptr& operator=(const tagged_rc_ptr& other) noexcept
+    {
+        tagged_rc_ptr{ other }.swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * @param other
+     * @return tagged_rc_ptr&
+     */
+    tagged_rc_ptr& operator=(tagged_rc_ptr&& other) noexcept
+    {
+        tagged_rc_ptr{ std::move(other) }.swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Returns the tag.
+     *
+     * @return tag_type
+     */
+    tag_type tag() const noexcept
+    {
+        return (m_bits & tag_mask);
+    }
+
+    /**
+     * @brief Replaces the tag, the ownership is not affected.
+     *
+     * @param tag
+     */
+    void set_tag(tag_type tag) noexcept
+    {
+        assert((tag & ~tag_mask) == 0 && "Tag does not fit in Bits.");
+        m_bits = (m_bits & ~tag_mask) | tag;
+    }
+
+    /**
+     * @brief Returns the stored pointer.
+     *
+     * @return pointer
+     */
+    pointer get() const noexcept
+    {
+        return m_ptr;
+    }
+
+    /**
+     * @brief Returns rc_ptr sharing the ownership of the managed object.
+     *
+     * @return rc_type
+     */
+    rc_type to_rc() const noexcept
+    {
+        auto block = get_control_block();
+
+        if (!block)
+        {
+            return rc_type{};
+        }
+
+        return detail::rc_ptr_access::share(m_ptr, block);
+    }
+
+    /**
+     * @brief Returns weak_rc_ptr observing the managed object, the tag is not
+     * kept.
+     *
+     * @return weak_type
+     */
+    operator weak_type() const
+    {
+        return weak_type{ to_rc() };
+    }
+
+    /**
+     * @brief Releases the ownership of the managed object. The tag is kept.
+     *
+     */
+    void reset() noexcept
+    {
+        const auto current_tag = tag();
+        tagged_rc_ptr{}.swap(*this);
+        m_bits = current_tag;
+    }
+
+    /**
+     * @brief Returns the number of rc_ptr and tagged_rc_ptr objects owning
+     * the resource.
+     *
+     * @return std::size_t
+     */
+    std::size_t use_count() const noexcept
+    {
+        auto block = get_control_block();
+        return (!block) ? 0 : block->get_ref_count();
+    }
+
+    /**
+     * @brief Checks whether the instance is the only one managing the
+     * resource.
+     *
+     * @return true
+     * @return false
+     */
+    bool unique() const noexcept
+    {
+        return (use_count() == 1);
+    }
+
+    /**
+     * @brief Swaps the pointers and the tags with other.
+     *
+     * @param other
+     */
+    void swap(tagged_rc_ptr& other) noexcept
+    {
+        std::swap(m_ptr, other.m_ptr);
+        std::swap(m_bits, other.m_bits);
+    }
+
+    /**
+     * @brief Checks if the stored pointer is not null.
+     *
+     */
+    explicit operator bool() const noexcept
+    {
+        return (m_ptr != nullptr);
+    }
+
+    /**
+     * @brief Dereferences the stored pointer.
+     *
+     * @return reference
+     */
+    reference operator*() const noexcept
+    {
+        assert(m_ptr);
+        return *m_ptr;
+    }
+
+    /**
+     * @brief Dereferences the stored pointer.
+     *
+     * @return pointer
+     */
+    pointer operator->() const noexcept
+    {
+        assert(m_ptr);
+        return m_ptr;
+    }
+
+private:
+    using control_block_type = detail::control_block<T, Deleter, Alloc>;
+
+    static_assert(alignof(control_block_type) > tag_mask,
+                  "Bits exceed the alignment of the control block.");
+
+    control_block_type* get_control_block() const noexcept
+    {
+        return reinterpret_cast<control_block_type*>(m_bits & ~tag_mask);
+    }
+
+    pointer  m_ptr;
+    tag_type m_bits;
+};
+
+/**
+ * @brief Compares the stored pointers, the tags are ignored.
+ *
+ */
+template<typename T, std::size_t Bits, typename D, typename A, typename U,
+         std::size_t OtherBits, typename E, typename B>
+bool operator==(const tagged_rc_ptr<T, Bits, D, A>&      left,
+                const tagged_rc_ptr<U, OtherBits, E, B>& right) noexcept
+{
+    return (left.get() == right.get());
+}
+
+/**
+ * @brief Compares the stored pointers, the tags are ignored.
+ *
+ */
+template<typename T, std::size_t Bits, typename D, typename A, typename U,
+         std::size_t OtherBits, typename E, typename B>
+bool operator!=(const tagged_rc_ptr<T, Bits, D, A>&      left,
+                const tagged_rc_ptr<U, OtherBits, E, B>& right) noexcept
+{
+    return !(left == right);
+}
+
+/**
+ * @brief Checks if the stored pointer is null.
+ *
+ */
+template<typename T, std::size_t Bits, typename D, typename A>
+bool operator==(const tagged_rc_ptr<T, Bits, D, A>& ptr,
+                std::nullptr_t) noexcept
+{
+    return !ptr;
+}
+
+/**
+ * @brief Checks if the stored pointer is null.
+ *
+ */
+template<typename T, std::size_t Bits, typename D, typename A>
+bool operator==(std::nullptr_t,
+                const tagged_rc_ptr<T, Bits, D, A>& ptr) noexcept
+{
+    return !ptr;
+}
+
+/**
+ * @brief Checks if the stored pointer is not null.
+ *
+ */
+template<typename T, std::size_t Bits, typename D, typename A>
+bool operator!=(const tagged_rc_ptr<T, Bits, D, A>& ptr,
+                std::nullptr_t) noexcept
+{
+    return static_cast<bool>(ptr);
+}
+
+/**
+ * @brief Checks if the stored pointer is not null.
+ *
+ */
+template<typename T, std::size_t Bits, typename D, typename A>
+bool operator!=(std::nullptr_t,
+                const tagged_rc_ptr<T, Bits, D, A>& ptr) noexcept
+{
+    return static_cast<bool>(ptr);
+}
+
+/**
+ * @brief Swaps left and right.
+ *
+ */
+template<typename T, std::size_t Bits, typename Deleter, typename Alloc>
+void swap(tagged_rc_ptr<T, Bits, Deleter, Alloc>& left,
+          tagged_rc_ptr<T, Bits, Deleter, Alloc>& right) noexcept
+{
+    left.swap(right);
+}
+
+} // namespace RC_PTR_NAMESPACE
+
+namespace std
+{
+/**
+ * @brief Hash of the stored pointer, the tag is ignored.
+ *
+ * @tparam T
+ * @tparam Bits
+ * @tparam Deleter
+ * @tparam Alloc
+ */
+template<typename T, std::size_t Bits, typename Deleter, typename Alloc>
+struct hash<RC_PTR_NAMESPACE::tagged_rc_ptr<T, Bits, Deleter, Alloc>> {
+    using argument_type =
+        RC_PTR_NAMESPACE::tagged_rc_ptr<T, Bits, Deleter, Alloc>;
+
+    std::size_t operator()(const argument_type& ptr) const noexcept
+    {
+        return std::hash<typename argument_type::pointer>{}(ptr.get());
+    }
+};
+} // namespace std
+
+#endif
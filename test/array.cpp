@@ -0,0 +1,110 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <limits>
+#include <new>
+#include <numeric>
+#include <string>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+TEST_CASE("make_rc, array of value initialized elements", "[array]")
+{
+    auto ptr = memory::make_rc<int[]>(16);
+    REQUIRE(ptr.size() == 16);
+    REQUIRE(ptr.end() - ptr.begin() == 16);
+
+    for (int value : ptr)
+    {
+        REQUIRE(value == 0);
+    }
+}
+
+TEST_CASE("make_rc, array of copies", "[array]")
+{
+    auto ptr = memory::make_rc<std::string[]>(3, std::string{ "abc" });
+    REQUIRE(ptr.size() == 3);
+
+    for (const auto& value : ptr)
+    {
+        REQUIRE(value == "abc");
+    }
+}
+
+TEST_CASE("make_rc, empty array", "[array]")
+{
+    auto ptr = memory::make_rc<int[]>(0);
+    REQUIRE(ptr.size() == 0);
+    REQUIRE(ptr.begin() == ptr.end());
+    REQUIRE(ptr.unique());
+}
+
+TEST_CASE("rc_ptr, array size is preserved", "[array]")
+{
+    auto                       ptr  = memory::make_rc<int[]>(8);
+    auto                       copy = ptr;
+    memory::weak_rc_ptr<int[]> weak{ ptr };
+    memory::rc_ptr<int[]>      moved{ std::move(copy) };
+    REQUIRE(moved.size() == 8);
+    REQUIRE(copy.size() == 0);
+    REQUIRE(weak.lock().size() == 8);
+    REQUIRE(memory::rc_borrow<int[]>{ ptr }.to_owned().size() == 8);
+}
+
+TEST_CASE("rc_ptr, array slice", "[array]")
+{
+    memory::rc_ptr<int[]> slice;
+    {
+        auto ptr = memory::make_rc<int[]>(10);
+        std::iota(ptr.begin(), ptr.end(), 0);
+        slice = ptr.slice(2, 5);
+        REQUIRE(ptr.use_count() == 2);
+    }
+    REQUIRE(slice.unique());
+    REQUIRE(slice.size() == 5);
+    REQUIRE(slice[0] == 2);
+    REQUIRE(slice[4] == 6);
+
+    auto inner = slice.slice(1, 2);
+    REQUIRE(inner.size() == 2);
+    REQUIRE(inner[0] == 3);
+    REQUIRE(inner[1] == 4);
+}
+
+TEST_CASE("rc_ptr, array of unknown size", "[array]")
+{
+    memory::rc_ptr<int[]> ptr{ new int[4] };
+    REQUIRE(ptr.size() == 0);
+    REQUIRE(ptr.begin() == ptr.end());
+}
+
+TEST_CASE("make_rc_for_overwrite, array", "[array]")
+{
+    auto ptr = memory::make_rc_for_overwrite<int[]>(4);
+    REQUIRE(ptr.size() == 4);
+    std::iota(ptr.begin(), ptr.end(), 1);
+    REQUIRE(ptr[3] == 4);
+
+    auto strings = memory::make_rc_for_overwrite<std::string[]>(2);
+    REQUIRE(strings[1].empty());
+}
+
+TEST_CASE("make_rc, array size overflows", "[array]")
+{
+    constexpr auto max = std::numeric_limits<std::size_t>::max();
+
+    REQUIRE_THROWS_AS(memory::make_rc<int[]>(max), std::bad_array_new_length);
+    REQUIRE_THROWS_AS(memory::make_rc<int[]>(max / sizeof(int) + 2),
+                      std::bad_array_new_length);
+    REQUIRE_THROWS_AS(
+        memory::make_rc_for_overwrite<int[]>(max / sizeof(int) + 2),
+        std::bad_array_new_length);
+    REQUIRE_THROWS_AS(memory::make_rc<std::string[]>(max / sizeof(std::string)),
+                      std::bad_array_new_length);
+}
@@ -11,6 +11,8 @@
 
 #include "rc_ptr/rc_ptr.hpp"
 
+#include "counted.hpp"
+
 TEST_CASE("rc_ptr, nullptr assignment", "[assignment]")
 {
     memory::rc_ptr<int> ptr;
@@ -178,3 +180,79 @@ TEST_CASE("weak_rc_ptr, assignment of invalid rc_ptr", "[assignment]")
     REQUIRE(second.expired());
     REQUIRE(second.use_count() == 0);
 }
+
+TEST_CASE("rc_ptr, assignment releases the previous object", "[assignment]")
+{
+    int  released = 0;
+    auto deleter  = [&released](int* ptr) {
+        ++released;
+        delete ptr;
+    };
+
+    using ptr_type = memory::rc_ptr<int, std::function<void(int*)>>;
+
+    ptr_type first{ new int{ 1 }, deleter };
+    ptr_type second{ new int{ 2 }, deleter };
+
+    first = second;
+    REQUIRE(released == 1);
+    REQUIRE(second.use_count() == 2);
+
+    first = ptr_type{ new int{ 3 }, deleter };
+    REQUIRE(released == 1);
+    REQUIRE(second.unique());
+
+    second = std::move(first);
+    REQUIRE(released == 2);
+    REQUIRE(*second == 3);
+
+    memory::weak_rc_ptr<int, std::function<void(int*)>> weak{ second };
+    first = ptr_type{ new int{ 4 }, deleter };
+    second = weak;
+    REQUIRE(released == 2);
+    first = weak;
+    REQUIRE(released == 3);
+    REQUIRE(first.use_count() == 2);
+}
+
+#if (__has_include(<memory_resource>))
+
+using rc_test::counting_resource;
+
+TEST_CASE("weak_rc_ptr, assignment releases the previous weak count",
+          "[assignment]")
+{
+    using allocator_type = std::pmr::polymorphic_allocator<int>;
+    using ptr_type =
+        memory::rc_ptr<int, std::default_delete<int>, allocator_type>;
+    using weak_type =
+        memory::weak_rc_ptr<int, std::default_delete<int>, allocator_type>;
+
+    counting_resource resource;
+    allocator_type    alloc{ &resource };
+
+    ptr_type first{ new int{ 1 }, std::default_delete<int>{}, alloc };
+    ptr_type second{ new int{ 2 }, std::default_delete<int>{}, alloc };
+    const auto block = resource.allocated / 2;
+
+    weak_type weak{ first };
+    first.reset();
+    REQUIRE(resource.allocated == 2 * block);
+
+    weak = second;
+    REQUIRE(resource.allocated == block);
+
+    weak_type other{ second };
+    second.reset();
+    weak = other;
+    REQUIRE(resource.allocated == block);
+
+    first = ptr_type{ new int{ 3 }, std::default_delete<int>{}, alloc };
+    weak  = weak_type{ first };
+    REQUIRE(resource.allocated == 2 * block);
+
+    other = weak;
+    REQUIRE(resource.allocated == block);
+}
+
+#endif
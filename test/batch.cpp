@@ -0,0 +1,194 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+#include "counted.hpp"
+
+namespace
+{
+using rc_test::counted;
+
+// Output iterator failing after the given number of writes.
+struct failing_output
+{
+    using iterator_category = std::output_iterator_tag;
+    using value_type        = void;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = void;
+    using reference         = void;
+
+    failing_output& operator*()
+    {
+        return *this;
+    }
+
+    failing_output& operator++()
+    {
+        return *this;
+    }
+
+    failing_output& operator=(memory::rc_ptr<counted>&& ptr)
+    {
+        if (*writes == 0)
+        {
+            throw std::runtime_error("full");
+        }
+
+        --*writes;
+        sink->push_back(std::move(ptr));
+        return *this;
+    }
+
+    int*                                  writes;
+    std::vector<memory::rc_ptr<counted>>* sink;
+};
+} // namespace
+
+TEST_CASE("share_n, assigns copies", "[share_n]")
+{
+    auto ptr = memory::make_rc<counted>();
+
+    std::vector<memory::rc_ptr<counted>> copies(10);
+    auto end = ptr.share_n(copies.begin(), copies.size());
+    REQUIRE(end == copies.end());
+    REQUIRE(ptr.use_count() == 11);
+
+    for (const auto& copy : copies)
+    {
+        REQUIRE(copy.get() == ptr.get());
+    }
+
+    ptr.share_n(std::back_inserter(copies), 5);
+    REQUIRE(copies.size() == 15);
+    REQUIRE(ptr.use_count() == 16);
+}
+
+TEST_CASE("share_n, empty rc_ptr", "[share_n]")
+{
+    memory::rc_ptr<counted>              empty;
+    std::vector<memory::rc_ptr<counted>> copies;
+    empty.share_n(std::back_inserter(copies), 3);
+    REQUIRE(copies.size() == 3);
+    REQUIRE(!copies[2]);
+}
+
+TEST_CASE("share_n, array keeps the size", "[share_n]")
+{
+    auto                               values = memory::make_rc<int[]>(4);
+    std::vector<memory::rc_ptr<int[]>> copies(2);
+    values.share_n(copies.begin(), 2);
+    REQUIRE(copies[1].size() == 4);
+}
+
+TEST_CASE("share_n, output throws", "[share_n]")
+{
+    auto ptr = memory::make_rc<counted>();
+
+    int                                  writes = 2;
+    std::vector<memory::rc_ptr<counted>> sink;
+    REQUIRE_THROWS_AS(ptr.share_n(failing_output{ &writes, &sink }, 5),
+                      std::runtime_error);
+    REQUIRE(sink.size() == 2);
+    REQUIRE(ptr.use_count() == 3);
+}
+
+TEST_CASE("rc_release_range, releases all", "[rc_release_range]")
+{
+    {
+        auto a = memory::make_rc<counted>();
+        auto b = memory::make_rc<counted>();
+
+        std::vector<memory::rc_ptr<counted>> ptrs;
+        a.share_n(std::back_inserter(ptrs), 3);
+        ptrs.emplace_back();
+        b.share_n(std::back_inserter(ptrs), 2);
+        ptrs.push_back(a);
+        ptrs.push_back(memory::make_rc<counted>());
+        REQUIRE(counted::alive == 3);
+
+        b.reset();
+        memory::rc_release_range(ptrs.begin(), ptrs.end());
+        REQUIRE(counted::alive == 1);
+        REQUIRE(a.unique());
+
+        for (const auto& ptr : ptrs)
+        {
+            REQUIRE(!ptr);
+        }
+    }
+    REQUIRE(counted::alive == 0);
+}
+
+TEST_CASE("rc_release_range, last references", "[rc_release_range]")
+{
+    std::list<memory::rc_ptr<counted>> ptrs;
+    for (int i = 0; i < 20; ++i)
+    {
+        ptrs.push_back(memory::make_rc<counted>());
+        ptrs.push_back(ptrs.back());
+    }
+
+    memory::weak_rc_ptr<counted> weak = ptrs.front();
+    REQUIRE(counted::alive == 20);
+
+    memory::rc_release_range(ptrs.begin(), ptrs.end());
+    REQUIRE(counted::alive == 0);
+    REQUIRE(weak.expired());
+}
+
+TEST_CASE("rc_release_range, immortal", "[rc_release_range]")
+{
+    // Static, as immortal objects are never released.
+    static const auto immortal = memory::make_immortal_rc<int>(1);
+
+    std::vector<memory::rc_ptr<int>> ptrs(4);
+    immortal.share_n(ptrs.begin(), ptrs.size());
+    memory::rc_release_range(ptrs.begin(), ptrs.end());
+    REQUIRE(!ptrs[0]);
+    REQUIRE(*immortal == 1);
+}
+
+TEST_CASE("rc_clear, destroys the elements", "[rc_clear]")
+{
+    auto shared = memory::make_rc<counted>();
+
+    std::vector<memory::rc_ptr<counted>> ptrs;
+    for (int i = 0; i < 100; ++i)
+    {
+        ptrs.push_back(i % 2 ? shared : memory::make_rc<counted>());
+    }
+    REQUIRE(counted::alive == 51);
+
+    memory::rc_clear(ptrs);
+    REQUIRE(ptrs.empty());
+    REQUIRE(counted::alive == 1);
+    REQUIRE(shared.unique());
+}
+
+TEST_CASE("rc_reset_range, resets in order", "[rc_clear]")
+{
+    auto shared = memory::make_rc<counted>();
+
+    std::list<memory::rc_ptr<counted>> ptrs{ shared,
+                                             memory::make_rc<counted>(),
+                                             shared };
+    shared.reset();
+    REQUIRE(counted::alive == 2);
+
+    memory::rc_reset_range(ptrs.begin(), ptrs.end());
+    REQUIRE(counted::alive == 0);
+    REQUIRE(ptrs.size() == 3);
+    REQUIRE(!ptrs.back());
+}
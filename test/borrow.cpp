@@ -0,0 +1,71 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <type_traits>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+#if !RC_PTR_CHECK_BORROWS
+static_assert(std::is_trivially_copyable_v<memory::rc_borrow<int>>,
+              "rc_borrow must be trivially copyable.");
+#endif
+
+static int read(memory::rc_borrow<int> borrow)
+{
+    return *borrow;
+}
+
+TEST_CASE("rc_borrow, default constructor", "[borrow]")
+{
+    memory::rc_borrow<int> borrow;
+    REQUIRE(borrow.get() == nullptr);
+    REQUIRE(!borrow);
+    REQUIRE(!borrow.to_owned());
+}
+
+TEST_CASE("rc_borrow, from rc_ptr", "[borrow]")
+{
+    auto                   ptr = memory::make_rc<int>(24);
+    memory::rc_borrow<int> borrow{ ptr };
+    auto                   copy = borrow;
+    REQUIRE(borrow.get() == ptr.get());
+    REQUIRE(copy.get() == ptr.get());
+    REQUIRE(ptr.use_count() == 1);
+    REQUIRE(read(ptr) == 24);
+    REQUIRE(ptr.use_count() == 1);
+}
+
+TEST_CASE("rc_borrow, to_owned", "[borrow]")
+{
+    memory::rc_ptr<int> owned;
+    {
+        auto                   ptr = memory::make_rc<int>(24);
+        memory::rc_borrow<int> borrow{ ptr };
+        owned = borrow.to_owned();
+        REQUIRE(ptr.use_count() == 2);
+    }
+    REQUIRE(owned.unique());
+    REQUIRE(*owned == 24);
+}
+
+TEST_CASE("rc_borrow, from empty rc_ptr", "[borrow]")
+{
+    memory::rc_ptr<int>    ptr;
+    memory::rc_borrow<int> borrow{ ptr };
+    REQUIRE(!borrow);
+    REQUIRE(borrow.to_owned().use_count() == 0);
+}
+
+TEST_CASE("rc_borrow, member access", "[borrow]")
+{
+    auto ptr = memory::make_rc<std::pair<int, int>>(1, 2);
+    memory::rc_borrow<std::pair<int, int>> borrow{ ptr };
+    borrow->second = 3;
+    REQUIRE(ptr->second == 3);
+}
@@ -245,3 +245,15 @@ TEST_CASE("rc_ptr, std::unique_ptr array constructor", "[constructor]")
     REQUIRE(rc.use_count() == 1);
     REQUIRE(rc.unique());
 }
+
+TEST_CASE("rc_ptr, aliasing constructor", "[constructor]")
+{
+    auto                  values = memory::make_rc<int[]>(4);
+    memory::rc_ptr<int[]> alias{ values, values.get() + 2 };
+    REQUIRE(alias.get() == values.get() + 2);
+    REQUIRE(values.use_count() == 2);
+
+    memory::rc_ptr<int[]> empty{ memory::rc_ptr<int[]>{}, values.get() };
+    REQUIRE(empty.get() == nullptr);
+    REQUIRE(empty.use_count() == 0);
+}
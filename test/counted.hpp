@@ -0,0 +1,86 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RC_PTR_TEST_COUNTED_HPP
+#define RC_PTR_TEST_COUNTED_HPP
+
+#include <cstddef>
+#include <stdexcept>
+
+#if (__has_include(<memory_resource>))
+#include <memory_resource>
+#endif
+
+namespace rc_test
+{
+/**
+ * @brief Test object counting its living instances. Construction from a
+ * negative value throws std::runtime_error.
+ *
+ */
+struct counted
+{
+    static inline int alive = 0;
+
+    explicit counted(int value = 0) : value{ value }
+    {
+        if (value < 0)
+        {
+            throw std::runtime_error("negative");
+        }
+
+        ++alive;
+    }
+
+    counted(const counted&) = delete;
+
+    ~counted()
+    {
+        --alive;
+    }
+
+    int value;
+};
+
+#if (__has_include(<memory_resource>))
+/**
+ * @brief Memory resource counting the allocations and the bytes currently
+ * allocated through it.
+ *
+ */
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+    std::size_t allocated   = 0;
+    std::size_t allocations = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        allocated += bytes;
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void*       ptr,
+                       std::size_t bytes,
+                       std::size_t alignment) override
+    {
+        allocated -= bytes;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+#endif
+} // namespace rc_test
+
+#endif
@@ -0,0 +1,86 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <stdexcept>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+#include "counted.hpp"
+
+using rc_test::counted;
+
+TEST_CASE("rc_ptr, emplace when unique", "[emplace]")
+{
+    {
+        auto  ptr = memory::make_rc<counted>(1);
+        auto* raw = ptr.get();
+        auto& ref = ptr.emplace(2);
+        REQUIRE(ptr.get() == raw);
+        REQUIRE(&ref == raw);
+        REQUIRE(ptr->value == 2);
+        REQUIRE(ptr.unique());
+        REQUIRE(counted::alive == 1);
+    }
+    REQUIRE(counted::alive == 0);
+}
+
+TEST_CASE("rc_ptr, emplace when shared", "[emplace]")
+{
+    {
+        auto first  = memory::make_rc<counted>(1);
+        auto second = first;
+        first.emplace(2);
+        REQUIRE(first.get() != second.get());
+        REQUIRE(first->value == 2);
+        REQUIRE(second->value == 1);
+        REQUIRE(first.unique());
+        REQUIRE(second.unique());
+        REQUIRE(counted::alive == 2);
+    }
+    REQUIRE(counted::alive == 0);
+}
+
+TEST_CASE("rc_ptr, emplace when observed by weak_rc_ptr", "[emplace]")
+{
+    auto                         first = memory::make_rc<counted>(1);
+    memory::weak_rc_ptr<counted> weak{ first };
+    auto*                        raw = first.get();
+    first.emplace(2);
+    REQUIRE(first.get() != raw);
+    REQUIRE(weak.expired());
+    REQUIRE(first->value == 2);
+}
+
+TEST_CASE("rc_ptr, emplace when empty", "[emplace]")
+{
+    memory::rc_ptr<counted> ptr;
+    ptr.emplace(3);
+    REQUIRE(ptr);
+    REQUIRE(ptr->value == 3);
+    REQUIRE(ptr.unique());
+}
+
+TEST_CASE("rc_ptr, emplace when not created by make_rc", "[emplace]")
+{
+    memory::rc_ptr<counted> ptr{ new counted{ 1 } };
+    auto*                   raw = ptr.get();
+    ptr.emplace(4);
+    REQUIRE(ptr.get() != raw);
+    REQUIRE(ptr->value == 4);
+    REQUIRE(ptr.unique());
+}
+
+TEST_CASE("rc_ptr, emplace throws", "[emplace]")
+{
+    auto ptr = memory::make_rc<counted>(1);
+    REQUIRE_THROWS_AS(ptr.emplace(-1), std::runtime_error);
+    REQUIRE(!ptr);
+    REQUIRE(ptr.use_count() == 0);
+    REQUIRE(counted::alive == 0);
+}
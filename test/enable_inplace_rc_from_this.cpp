@@ -0,0 +1,153 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <memory>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace
+{
+class test : public memory::enable_inplace_rc_from_this<test>
+{
+public:
+    int value = 0;
+};
+
+class test_constructor :
+    public memory::enable_inplace_rc_from_this<test_constructor>
+{
+public:
+    test_constructor()
+    {
+        rc_from_this();
+    }
+};
+
+class test_destructor :
+    public memory::enable_inplace_rc_from_this<test_destructor>
+{
+public:
+    ~test_destructor()
+    {
+        expired = !weak_rc_from_this_nothrow();
+    }
+
+    bool weak_rc_from_this_nothrow() noexcept
+    {
+        try
+        {
+            weak_rc_from_this();
+            return true;
+        }
+        catch (const memory::bad_weak_rc_ptr&)
+        {
+            return false;
+        }
+    }
+
+    static inline bool expired = false;
+};
+
+class test_derived : public test
+{
+};
+
+struct other
+{
+    std::array<unsigned char, 32> bytes{};
+};
+
+class test_second_base :
+    public other,
+    public test
+{
+};
+
+template<typename T>
+constexpr bool can_make_rc = memory::detail::
+    is_inplace_rc_from_this_compatible_v<T, std::default_delete<T>,
+                                         std::allocator<T>>;
+} // namespace
+
+static_assert(sizeof(test) == sizeof(int),
+              "enable_inplace_rc_from_this must not add any members.");
+
+static_assert(can_make_rc<test>);
+static_assert(!can_make_rc<test_derived>,
+              "make_rc must reject classes deriving from T.");
+static_assert(!can_make_rc<test_second_base>,
+              "make_rc must reject classes deriving from T.");
+
+TEST_CASE("enable_inplace_rc_from_this, rc_from_this",
+          "[enable_inplace_rc_from_this]")
+{
+    auto first  = memory::make_rc<test>();
+    auto second = first->rc_from_this();
+    REQUIRE(first.get() == second.get());
+    REQUIRE(first.use_count() == 2);
+    REQUIRE(second.use_count() == 2);
+}
+
+TEST_CASE("enable_inplace_rc_from_this, weak_rc_from_this",
+          "[enable_inplace_rc_from_this]")
+{
+    auto first  = memory::make_rc<test>();
+    auto second = first->weak_rc_from_this();
+    REQUIRE(first.use_count() == 1);
+    REQUIRE(!second.expired());
+}
+
+TEST_CASE("enable_inplace_rc_from_this, from constructor",
+          "[enable_inplace_rc_from_this]")
+{
+    REQUIRE_THROWS_AS(memory::make_rc<test_constructor>(),
+                      memory::bad_weak_rc_ptr);
+}
+
+TEST_CASE("enable_inplace_rc_from_this, from destructor",
+          "[enable_inplace_rc_from_this]")
+{
+    memory::make_rc<test_destructor>();
+    REQUIRE(test_destructor::expired);
+}
+
+#if (__has_include(<memory_resource>))
+
+#include <memory_resource>
+
+namespace
+{
+class test_pmr :
+    public memory::enable_inplace_rc_from_this<
+        test_pmr,
+        std::default_delete<test_pmr>,
+        std::pmr::polymorphic_allocator<test_pmr>>
+{
+};
+} // namespace
+
+TEST_CASE("enable_inplace_rc_from_this, custom allocator",
+          "[enable_inplace_rc_from_this]")
+{
+    std::array<std::byte, 256>          buffer;
+    std::pmr::monotonic_buffer_resource resource{
+        buffer.data(),
+        buffer.size(),
+    };
+    std::pmr::polymorphic_allocator<test_pmr> alloc{ &resource };
+
+    auto first  = memory::allocate_rc<test_pmr>(alloc);
+    auto second = first->rc_from_this();
+    REQUIRE(first.get() == second.get());
+    REQUIRE(second.use_count() == 2);
+    REQUIRE(second.get_allocator().resource() == &resource);
+}
+
+#endif
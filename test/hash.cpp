@@ -0,0 +1,81 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace
+{
+struct pair
+{
+    int first;
+    int second;
+};
+} // namespace
+
+TEST_CASE("rc_ptr, comparison operators", "[hash]")
+{
+    auto                first = memory::make_rc<int>(1);
+    auto                copy  = first;
+    memory::rc_ptr<int> empty;
+
+    REQUIRE(first == copy);
+    REQUIRE(first != memory::make_rc<int>(1));
+    REQUIRE(empty == nullptr);
+    REQUIRE(nullptr == empty);
+    REQUIRE(first != nullptr);
+    REQUIRE(nullptr != first);
+    REQUIRE(first != empty);
+}
+
+TEST_CASE("rc_ptr, std::hash", "[hash]")
+{
+    auto ptr = memory::make_rc<int>(1);
+    REQUIRE(std::hash<memory::rc_ptr<int>>{}(ptr) ==
+            std::hash<int*>{}(ptr.get()));
+
+    std::unordered_map<memory::rc_ptr<int>, int> values;
+    values[ptr]                     = 1;
+    values[memory::make_rc<int>(1)] = 2;
+    values[ptr]                     = 3;
+    REQUIRE(values.size() == 2);
+    REQUIRE(values.at(ptr) == 3);
+}
+
+TEST_CASE("rc_ptr, owner_hash and owner_equal", "[hash]")
+{
+    auto                      owner = memory::make_rc<pair>(1, 2);
+    memory::rc_ptr<pair>      alias{ owner, owner.get() };
+    memory::weak_rc_ptr<pair> weak  = owner;
+    memory::rc_ptr<pair>      other = memory::make_rc<pair>(1, 2);
+    memory::rc_ptr<pair>      empty;
+    memory::weak_rc_ptr<pair> empty_weak;
+
+    REQUIRE(owner.owner_hash() == weak.owner_hash());
+    REQUIRE(owner.owner_equal(weak));
+    REQUIRE(weak.owner_equal(alias));
+    REQUIRE(!owner.owner_equal(other));
+    REQUIRE(empty.owner_equal(empty_weak));
+
+    std::unordered_set<memory::weak_rc_ptr<pair>,
+                       memory::owner_hash,
+                       memory::owner_equal>
+        observers;
+    observers.insert(weak);
+    observers.insert(owner);
+    observers.insert(other);
+    REQUIRE(observers.size() == 2);
+    REQUIRE(observers.count(weak) == 1);
+
+    other.reset();
+    REQUIRE(observers.size() == 2);
+}
@@ -0,0 +1,140 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+#include "counted.hpp"
+
+namespace
+{
+using buffer = rc_test::counted;
+
+struct pool
+{
+    ~pool()
+    {
+        open = false;
+        free.clear();
+    }
+
+    memory::rc_ptr<buffer> acquire()
+    {
+        if (free.empty())
+        {
+            return memory::make_hooked_rc<buffer>(
+                [this](memory::rc_ptr<buffer>& last) {
+                    if (open)
+                    {
+                        free.push_back(std::move(last));
+                    }
+                },
+                64);
+        }
+
+        auto result = std::move(free.back());
+        free.pop_back();
+        return result;
+    }
+
+    bool                                open = true;
+    std::vector<memory::rc_ptr<buffer>> free;
+};
+} // namespace
+
+TEST_CASE("make_hooked_rc, hook observes the last release", "[hooked]")
+{
+    int released = 0;
+    {
+        auto ptr = memory::make_hooked_rc<buffer>(
+            [&released](memory::rc_ptr<buffer>& last) {
+                REQUIRE(last.unique());
+                released += last->value;
+            },
+            8);
+
+        auto copy = ptr;
+        ptr.reset();
+        REQUIRE(released == 0);
+        REQUIRE(buffer::alive == 1);
+    }
+    REQUIRE(released == 8);
+    REQUIRE(buffer::alive == 0);
+}
+
+TEST_CASE("make_hooked_rc, hook resurrects into a pool", "[hooked]")
+{
+    {
+        pool buffers;
+
+        auto                        first = buffers.acquire();
+        auto                        raw   = first.get();
+        memory::weak_rc_ptr<buffer> weak  = first;
+
+        first.reset();
+        REQUIRE(buffer::alive == 1);
+        REQUIRE(buffers.free.size() == 1);
+        REQUIRE(!weak.expired());
+
+        auto second = buffers.acquire();
+        REQUIRE(second.get() == raw);
+        REQUIRE(second.unique());
+        REQUIRE(buffers.free.empty());
+
+        auto third = buffers.acquire();
+        REQUIRE(third.get() != raw);
+        REQUIRE(buffer::alive == 2);
+
+        second.reset();
+        third.reset();
+        REQUIRE(buffers.free.size() == 2);
+        REQUIRE(buffer::alive == 2);
+    }
+    REQUIRE(buffer::alive == 0);
+}
+
+TEST_CASE("make_hooked_rc, hook copies into a pool", "[hooked]")
+{
+    std::vector<memory::rc_ptr<buffer>> free;
+    int                                 calls = 0;
+    {
+        auto ptr = memory::make_hooked_rc<buffer>(
+            [&free, &calls](memory::rc_ptr<buffer>& last) {
+                if (!calls++)
+                {
+                    free.push_back(last);
+                }
+            },
+            16);
+
+        ptr.reset();
+        REQUIRE(buffer::alive == 1);
+        REQUIRE(free.size() == 1);
+        REQUIRE(free.back().unique());
+        REQUIRE(free.back()->value == 16);
+    }
+
+    free.clear();
+    REQUIRE(calls == 2);
+    REQUIRE(buffer::alive == 0);
+}
+
+TEST_CASE("make_hooked_rc, construction throws", "[hooked]")
+{
+    int calls = 0;
+    REQUIRE_THROWS_AS(memory::make_hooked_rc<buffer>(
+                          [&calls](memory::rc_ptr<buffer>&) { ++calls; },
+                          -1),
+                      std::runtime_error);
+    REQUIRE(calls == 0);
+    REQUIRE(buffer::alive == 0);
+}
@@ -0,0 +1,75 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <limits>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+namespace
+{
+struct probe
+{
+    static inline int destroyed = 0;
+
+    ~probe()
+    {
+        ++destroyed;
+    }
+
+    int value;
+};
+
+const memory::rc_ptr<probe>& sentinel()
+{
+    static const auto instance = memory::make_immortal_rc<probe>(24);
+    return instance;
+}
+} // namespace
+
+TEST_CASE("make_immortal_rc, count is not modified", "[immortal]")
+{
+    const auto count = sentinel().use_count();
+    REQUIRE(count == std::numeric_limits<std::size_t>::max());
+    REQUIRE(sentinel().immortal());
+    REQUIRE(!sentinel().unique());
+
+    {
+        auto first  = sentinel();
+        auto second = first;
+        REQUIRE(first.use_count() == count);
+        REQUIRE(second->value == 24);
+    }
+
+    REQUIRE(sentinel().use_count() == count);
+}
+
+TEST_CASE("make_immortal_rc, never destroyed", "[immortal]")
+{
+    {
+        auto copy = sentinel();
+        copy.reset();
+    }
+
+    REQUIRE(probe::destroyed == 0);
+    REQUIRE(sentinel()->value == 24);
+}
+
+TEST_CASE("make_immortal_rc, weak_rc_ptr never expires", "[immortal]")
+{
+    memory::weak_rc_ptr<probe> weak{ sentinel() };
+    REQUIRE(!weak.expired());
+    REQUIRE(weak.lock().get() == sentinel().get());
+}
+
+TEST_CASE("rc_ptr, not immortal", "[immortal]")
+{
+    memory::rc_ptr<int> empty;
+    REQUIRE(!empty.immortal());
+    REQUIRE(!memory::make_rc<int>(0).immortal());
+}
@@ -7,9 +7,69 @@
 
 #include "catch2/catch.hpp"
 
+#include <vector>
+
 #include "rc_ptr/rc_ptr.hpp"
 
 TEST_CASE("make_rc, int", "[make_rc]")
 {
     memory::rc_ptr ptr = memory::make_rc<int>(10);
 }
+
+TEST_CASE("make_rc, destroys the object", "[make_rc]")
+{
+    std::size_t times_called = 0;
+
+    struct probe
+    {
+        std::size_t& times_called;
+
+        ~probe()
+        {
+            ++times_called;
+        }
+    };
+
+    {
+        auto first  = memory::make_rc<probe>(times_called);
+        auto second = first;
+        REQUIRE(first.use_count() == 2);
+    }
+    REQUIRE(times_called == 1);
+}
+
+TEST_CASE("make_rc, outlived by weak_rc_ptr", "[make_rc]")
+{
+    memory::weak_rc_ptr<int> weak;
+    {
+        auto ptr = memory::make_rc<int>(10);
+        weak     = ptr;
+        REQUIRE(*weak.lock() == 10);
+    }
+    REQUIRE(weak.expired());
+}
+
+TEST_CASE("make_rc, list initialization", "[make_rc]")
+{
+    struct point
+    {
+        int x;
+        int y;
+    };
+
+    auto vector = memory::make_rc<std::vector<int>>(3, 1);
+    REQUIRE(*vector == std::vector<int>{ 3, 1 });
+
+    auto aggregate = memory::make_rc<point>(1, 2);
+    REQUIRE(aggregate->x == 1);
+    REQUIRE(aggregate->y == 2);
+
+    auto hooked = memory::make_hooked_rc<std::vector<int>>(
+        [](memory::rc_ptr<std::vector<int>>&) {},
+        3,
+        1);
+    REQUIRE(hooked->size() == 2);
+
+    vector.emplace(5, 2);
+    REQUIRE(*vector == std::vector<int>{ 5, 2 });
+}
@@ -0,0 +1,85 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <string>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+#include "counted.hpp"
+
+namespace
+{
+struct message
+{
+    explicit message(int id) : id{ id }
+    {
+        auto* payload = memory::flex_data<std::byte>(this);
+        for (std::size_t i = 0; i < memory::flex_size(this); ++i)
+        {
+            payload[i] = static_cast<std::byte>(i);
+        }
+    }
+
+    int id;
+};
+} // namespace
+
+using rc_test::counted;
+
+TEST_CASE("make_rc_flex, header fills the trailer", "[make_rc_flex]")
+{
+    auto ptr = memory::make_rc_flex<message, std::byte>(5, 42);
+    REQUIRE(ptr->id == 42);
+    REQUIRE(memory::flex_size(ptr.get()) == 5);
+
+    auto* payload = memory::flex_data<std::byte>(ptr.get());
+    REQUIRE(payload[0] == std::byte{ 0 });
+    REQUIRE(payload[4] == std::byte{ 4 });
+}
+
+TEST_CASE("make_rc_flex, destroys the trailer", "[make_rc_flex]")
+{
+    {
+        auto first  = memory::make_rc_flex<std::string, counted>(3, "header");
+        auto second = first;
+        REQUIRE(*second == "header");
+        REQUIRE(counted::alive == 3);
+        REQUIRE(memory::flex_data<counted>(first.get())[2].value == 0);
+    }
+    REQUIRE(counted::alive == 0);
+}
+
+TEST_CASE("make_rc_flex, empty trailer", "[make_rc_flex]")
+{
+    auto ptr = memory::make_rc_flex<double, long double>(0, 1.5);
+    REQUIRE(*ptr == 1.5);
+    REQUIRE(memory::flex_size(ptr.get()) == 0);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(
+                memory::flex_data<long double>(ptr.get())) %
+                alignof(long double) ==
+            0);
+}
+
+TEST_CASE("make_rc_flex, trailer size overflows", "[make_rc_flex]")
+{
+    constexpr auto max = std::numeric_limits<std::size_t>::max();
+
+    REQUIRE_THROWS_AS((memory::make_rc_flex<int, int>(max)),
+                      std::bad_array_new_length);
+    REQUIRE_THROWS_AS((memory::make_rc_flex<int, int>(max / sizeof(int) + 2)),
+                      std::bad_array_new_length);
+    REQUIRE_THROWS_AS(
+        (memory::make_rc_flex<std::string, counted>(max / sizeof(counted))),
+        std::bad_array_new_length);
+    REQUIRE(counted::alive == 0);
+}
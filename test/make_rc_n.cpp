@@ -0,0 +1,119 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "rc_ptr/rc_ptr.hpp"
+
+#include "counted.hpp"
+
+using record = rc_test::counted;
+
+TEST_CASE("make_rc_n, creates independent objects", "[make_rc_n]")
+{
+    {
+        auto records = memory::make_rc_n<record>(10, [](std::size_t i) {
+            return static_cast<int>(i);
+        });
+        REQUIRE(records.size() == 10);
+        REQUIRE(record::alive == 10);
+
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            REQUIRE(records[i]->value == static_cast<int>(i));
+            REQUIRE(records[i].unique());
+        }
+
+        REQUIRE(records[0].get() < records[9].get());
+
+        records[3].reset();
+        REQUIRE(record::alive == 9);
+        REQUIRE(records[4]->value == 4);
+
+        auto kept = records[7];
+        records.clear();
+        REQUIRE(record::alive == 1);
+        REQUIRE(kept->value == 7);
+    }
+    REQUIRE(record::alive == 0);
+}
+
+TEST_CASE("make_rc_n, outlived by weak_rc_ptr", "[make_rc_n]")
+{
+    memory::weak_rc_ptr<std::string> weak;
+    {
+        auto strings = memory::make_rc_n<std::string>(3, [](std::size_t i) {
+            return std::string(i + 1, 'x');
+        });
+        weak = strings[2];
+        REQUIRE(*weak.lock() == "xxx");
+    }
+    REQUIRE(weak.expired());
+}
+
+TEST_CASE("make_rc_n, zero objects", "[make_rc_n]")
+{
+    auto records = memory::make_rc_n<record>(0, [](std::size_t i) {
+        return static_cast<int>(i);
+    });
+    REQUIRE(records.empty());
+}
+
+TEST_CASE("make_rc_n, initialization throws", "[make_rc_n]")
+{
+    REQUIRE_THROWS_AS(memory::make_rc_n<record>(20,
+                                                [](std::size_t i) {
+                                                    return i == 13 ? -1 : 0;
+                                                }),
+                      std::runtime_error);
+    REQUIRE(record::alive == 0);
+}
+
+TEST_CASE("make_rc_n, slab size overflows", "[make_rc_n]")
+{
+    auto init = [](std::size_t) { return 0; };
+
+    REQUIRE_THROWS_AS(
+        memory::make_rc_n<record>(std::numeric_limits<std::size_t>::max(),
+                                  init),
+        std::bad_array_new_length);
+    REQUIRE_THROWS_AS(
+        memory::make_rc_n<record>(
+            std::numeric_limits<std::size_t>::max() / sizeof(record),
+            init),
+        std::bad_array_new_length);
+    REQUIRE(record::alive == 0);
+}
+
+#if (__has_include(<memory_resource>))
+
+TEST_CASE("allocate_rc_n, allocates the slab and the vector from the allocator",
+          "[make_rc_n]")
+{
+    using allocator_type = std::pmr::polymorphic_allocator<record>;
+
+    rc_test::counting_resource resource;
+    {
+        auto records = memory::allocate_rc_n<record>(
+            allocator_type{ &resource },
+            8,
+            [](std::size_t i) { return static_cast<int>(i); });
+
+        REQUIRE(resource.allocations == 2);
+        REQUIRE(records.get_allocator().resource() == &resource);
+        REQUIRE(records[5]->value == 5);
+    }
+    REQUIRE(resource.allocated == 0);
+    REQUIRE(record::alive == 0);
+}
+
+#endif
@@ -0,0 +1,142 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "rc_ptr/offset_rc_ptr.hpp"
+
+namespace
+{
+struct node
+{
+    int                         value;
+    memory::offset_rc_ptr<node> next;
+};
+
+struct region
+{
+    explicit region(std::size_t size) : storage((size + 15) / 16) { }
+
+    void* data() noexcept
+    {
+        return storage.data();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return storage.size() * 16;
+    }
+
+    struct alignas(16) unit
+    {
+        std::byte bytes[16];
+    };
+
+    std::vector<unit> storage;
+};
+} // namespace
+
+TEST_CASE("offset_rc_ptr, reference counting", "[offset_rc_ptr]")
+{
+    region storage{ 4096 };
+    auto   arena = memory::offset_arena::create(storage.data(), storage.size());
+
+    auto first = memory::make_offset_rc<node>(arena, node{ 1, nullptr });
+    REQUIRE(arena.contains(first.get()));
+    REQUIRE(first->value == 1);
+    REQUIRE(first.unique());
+
+    auto second = memory::make_offset_rc<node>(arena, node{ 2, first });
+    REQUIRE(first.use_count() == 2);
+    REQUIRE(second->next == first);
+
+    auto copy = second;
+    REQUIRE(copy.get() == second.get());
+    REQUIRE(second.use_count() == 2);
+
+    auto moved = std::move(copy);
+    REQUIRE(!copy);
+    REQUIRE(moved == second);
+    REQUIRE(second.use_count() == 2);
+
+    const auto used = arena.used();
+    first.reset();
+    second.reset();
+    moved.reset();
+
+    // The freed blocks are reused.
+    auto third  = memory::make_offset_rc<node>(arena, node{ 3, nullptr });
+    auto fourth = memory::make_offset_rc<node>(arena, node{ 4, nullptr });
+    REQUIRE(arena.used() == used);
+}
+
+TEST_CASE("offset_rc_ptr, graph stays valid at another address",
+          "[offset_rc_ptr]")
+{
+    region original{ 1 << 16 };
+    {
+        auto arena =
+            memory::offset_arena::create(original.data(), original.size());
+
+        auto& root = arena.root<node>();
+        for (int i = 0; i != 100; ++i)
+        {
+            root = memory::make_offset_rc<node>(arena, node{ i, root });
+        }
+    }
+
+    region relocated{ original.size() };
+    std::memcpy(relocated.data(), original.data(), original.size());
+    original.storage.assign(original.storage.size(), region::unit{});
+
+    auto arena =
+        memory::offset_arena::attach(relocated.data(), relocated.size());
+    auto& root = arena.root<node>();
+
+    int expected = 99;
+    for (auto it = root.get(); it; it = it->next.get())
+    {
+        REQUIRE(arena.contains(it));
+        REQUIRE(it->value == expected--);
+        REQUIRE(it->next.use_count() <= 1);
+    }
+    REQUIRE(expected == -1);
+
+    const auto used = arena.used();
+    root.reset();
+    for (int i = 0; i != 100; ++i)
+    {
+        root = memory::make_offset_rc<node>(arena, node{ i, root });
+    }
+    REQUIRE(arena.used() == used);
+}
+
+TEST_CASE("offset_arena, errors", "[offset_rc_ptr]")
+{
+    region storage{ 1024 };
+    REQUIRE_THROWS_AS(
+        memory::offset_arena::attach(storage.data(), storage.size()),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(memory::offset_arena::create(storage.data(), 64),
+                      std::invalid_argument);
+
+    auto arena = memory::offset_arena::create(storage.data(), storage.size());
+    using large = std::array<char, 2048>;
+    REQUIRE_THROWS_AS(memory::make_offset_rc<large>(arena), std::bad_alloc);
+    REQUIRE_THROWS_AS(arena.allocate(~std::size_t{ 0 }), std::bad_alloc);
+
+    REQUIRE_THROWS_AS(memory::offset_arena::attach(storage.data(), 512),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(memory::offset_arena::attach(storage.data(), 64),
+                      std::invalid_argument);
+    REQUIRE(memory::offset_arena::attach(storage.data(), storage.size()) ==
+            arena);
+}
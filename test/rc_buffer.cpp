@@ -0,0 +1,149 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <string>
+
+#include "rc_ptr/rc_buffer.hpp"
+
+namespace
+{
+template<typename Buffer>
+std::string to_string(const Buffer& buffer)
+{
+    return { reinterpret_cast<const char*>(buffer.data()), buffer.size() };
+}
+
+memory::rc_buffer from_string(const std::string& text)
+{
+    return memory::rc_buffer::copy_from(text.data(), text.size());
+}
+} // namespace
+
+TEST_CASE("rc_buffer, slices share the storage", "[rc_buffer]")
+{
+    auto buffer = from_string("hello, world");
+    auto hello  = buffer.slice(0, 5);
+    auto world  = buffer.slice(7, 12);
+
+    REQUIRE(to_string(hello) == "hello");
+    REQUIRE(to_string(world) == "world");
+    REQUIRE(hello.data() == buffer.data());
+    REQUIRE(buffer.as_rc().use_count() == 3);
+    REQUIRE(!buffer.unique());
+
+    buffer.clear();
+    REQUIRE(buffer.empty());
+    REQUIRE(to_string(world) == "world");
+    REQUIRE(world[0] == std::byte{ 'w' });
+}
+
+TEST_CASE("rc_buffer, split_to, split_off and advance", "[rc_buffer]")
+{
+    auto buffer = from_string("header:body:trailer");
+
+    auto header = buffer.split_to(7);
+    REQUIRE(to_string(header) == "header:");
+    REQUIRE(to_string(buffer) == "body:trailer");
+
+    auto trailer = buffer.split_off(5);
+    REQUIRE(to_string(trailer) == "trailer");
+    REQUIRE(to_string(buffer) == "body:");
+
+    buffer.truncate(4);
+    REQUIRE(to_string(buffer) == "body");
+    header.advance(4);
+    REQUIRE(to_string(header) == "er:");
+    REQUIRE(header.data() + 3 == buffer.data());
+
+    memory::rc_buffer empty;
+    REQUIRE(empty.split_to(0).empty());
+    REQUIRE(empty.slice(0, 0).empty());
+}
+
+TEST_CASE("rc_buffer_mut, append and freeze", "[rc_buffer]")
+{
+    memory::rc_buffer_mut buffer{ 4 };
+    REQUIRE(buffer.capacity() == 4);
+
+    buffer.append("abc", 3);
+    buffer.push_back(std::byte{ 'd' });
+    buffer.append("efgh", 4);
+    REQUIRE(buffer.capacity() >= 8);
+    REQUIRE(to_string(buffer) == "abcdefgh");
+
+    auto data   = buffer.data();
+    auto frozen = std::move(buffer).freeze();
+    REQUIRE(buffer.empty());
+    REQUIRE(frozen.data() == data);
+    REQUIRE(to_string(frozen) == "abcdefgh");
+
+    auto mut = std::move(frozen).into_mut();
+    REQUIRE(mut.data() == data);
+    mut[0] = std::byte{ 'A' };
+    REQUIRE(to_string(mut) == "Abcdefgh");
+
+    auto shared = from_string("xyz");
+    auto copy   = shared;
+    auto copied = std::move(copy).into_mut();
+    REQUIRE(copied.data() != shared.data());
+    copied.resize(5, std::byte{ '!' });
+    REQUIRE(to_string(copied) == "xyz!!");
+    REQUIRE(to_string(shared) == "xyz");
+}
+
+TEST_CASE("rc_buffer_mut, split parts are limited to their ranges",
+          "[rc_buffer]")
+{
+    memory::rc_buffer_mut buffer{ 16 };
+    buffer.append("0123456789", 10);
+
+    auto tail = buffer.split_off(6);
+    REQUIRE(buffer.capacity() == 6);
+    REQUIRE(tail.capacity() == 10);
+
+    buffer.append("ab", 2);
+    REQUIRE(buffer.data() != tail.data() - 6);
+    REQUIRE(to_string(buffer) == "012345ab");
+    REQUIRE(to_string(tail) == "6789");
+
+    auto head = tail.split_to(2);
+    REQUIRE(to_string(head) == "67");
+    REQUIRE(to_string(tail) == "89");
+    REQUIRE(head.capacity() == 2);
+    REQUIRE(!tail.unique());
+}
+
+TEST_CASE("rc_buffer_mut, reserve reclaims the storage when unique",
+          "[rc_buffer]")
+{
+    memory::rc_buffer_mut buffer{ 16 };
+    buffer.append("0123456789abcdef", 16);
+    const auto storage = buffer.data();
+
+    {
+        auto head = buffer.split_to(12);
+        REQUIRE(buffer.capacity() == 4);
+        buffer.reserve(8);
+        REQUIRE(buffer.data() != storage + 12);
+        REQUIRE(to_string(buffer) == "cdef");
+    }
+
+    memory::rc_buffer_mut second{ 16 };
+    second.append("0123456789abcdef", 16);
+    const auto second_storage = second.data();
+    {
+        auto frozen = second.split_to(12).freeze();
+        REQUIRE(frozen.size() == 12);
+    }
+    REQUIRE(second.unique());
+    second.reserve(8);
+    REQUIRE(second.data() == second_storage);
+    REQUIRE(second.capacity() == 16);
+    REQUIRE(to_string(second) == "cdef");
+}
@@ -0,0 +1,171 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <string>
+
+#include "rc_ptr/rc_buffer_chain.hpp"
+
+#if RC_PTR_HAS_IOVEC
+#include <unistd.h>
+#endif
+
+namespace
+{
+std::string to_string(const memory::rc_buffer& buffer)
+{
+    return { reinterpret_cast<const char*>(buffer.data()), buffer.size() };
+}
+
+std::string to_string(const memory::rc_buffer_chain& chain)
+{
+    return to_string(chain.flatten());
+}
+
+memory::rc_buffer from_string(const std::string& text)
+{
+    return memory::rc_buffer::copy_from(text.data(), text.size());
+}
+} // namespace
+
+TEST_CASE("rc_buffer_chain, append shares the fragments", "[rc_buffer_chain]")
+{
+    auto header = from_string("header:");
+    auto body   = from_string("body");
+
+    memory::rc_buffer_chain chain;
+    chain.append(header);
+    chain.append(memory::rc_buffer{});
+    chain.append(body);
+
+    REQUIRE(chain.size() == 11);
+    REQUIRE(chain.fragment_count() == 2);
+    REQUIRE(chain.begin()->data() == header.data());
+    REQUIRE(header.as_rc().use_count() == 2);
+    REQUIRE(to_string(chain) == "header:body");
+
+    auto copy = chain;
+    REQUIRE(header.as_rc().use_count() == 3);
+
+    chain.append(std::move(copy));
+    REQUIRE(copy.empty());
+    REQUIRE(chain.fragment_count() == 4);
+    REQUIRE(to_string(chain) == "header:bodyheader:body");
+}
+
+TEST_CASE("rc_buffer_chain, consume releases the fragments",
+          "[rc_buffer_chain]")
+{
+    auto header = from_string("header:");
+    auto body   = from_string("body");
+
+    memory::rc_buffer_chain chain;
+    chain.append(header);
+    chain.append(body);
+
+    chain.consume(3);
+    REQUIRE(to_string(chain) == "der:body");
+    REQUIRE(header.as_rc().use_count() == 2);
+
+    chain.consume(4);
+    REQUIRE(header.unique());
+    REQUIRE(chain.fragment_count() == 1);
+    REQUIRE(to_string(chain) == "body");
+
+    chain.consume(4);
+    REQUIRE(chain.empty());
+    REQUIRE(chain.fragment_count() == 0);
+    REQUIRE(body.unique());
+}
+
+TEST_CASE("rc_buffer_chain, grows past the inline fragments",
+          "[rc_buffer_chain]")
+{
+    memory::rc_buffer_chain chain;
+    std::string             expected;
+
+    for (int i = 0; i != 20; ++i)
+    {
+        const auto text = std::to_string(i) + ",";
+        chain.append(from_string(text));
+        expected += text;
+
+        if (i % 3 == 0)
+        {
+            chain.consume(1);
+            expected.erase(0, 1);
+        }
+    }
+
+    REQUIRE(chain.size() == expected.size());
+    REQUIRE(to_string(chain) == expected);
+}
+
+TEST_CASE("rc_buffer_chain, split_to and split_off", "[rc_buffer_chain]")
+{
+    auto text = from_string("header:body:trailer");
+
+    memory::rc_buffer_chain chain;
+    chain.append(text.slice(0, 7));
+    chain.append(text.slice(7, 12));
+    chain.append(text.slice(12, 19));
+
+    auto head = chain.split_to(9);
+    REQUIRE(to_string(head) == "header:bo");
+    REQUIRE(to_string(chain) == "dy:trailer");
+    REQUIRE(head.fragment_count() == 2);
+    REQUIRE(chain.fragment_count() == 2);
+    REQUIRE(chain.begin()->data() == text.data() + 9);
+
+    auto tail = chain.split_off(3);
+    REQUIRE(to_string(chain) == "dy:");
+    REQUIRE(to_string(tail) == "trailer");
+
+    auto all = head.split_to(head.size());
+    REQUIRE(head.empty());
+    REQUIRE(to_string(all) == "header:bo");
+}
+
+#if RC_PTR_HAS_IOVEC
+TEST_CASE("rc_buffer_chain, writev and readv", "[rc_buffer_chain]")
+{
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+
+    memory::rc_buffer_chain chain;
+    chain.append(from_string("header:"));
+    chain.append(from_string("body:"));
+    chain.append(from_string("trailer"));
+
+    while (!chain.empty())
+    {
+        struct iovec vec[2];
+        const auto   count   = chain.to_iovec(vec, 2);
+        const auto   written = writev(fds[1], vec, static_cast<int>(count));
+        REQUIRE(written > 0);
+        chain.consume(static_cast<std::size_t>(written));
+    }
+    close(fds[1]);
+
+    memory::rc_buffer_mut buffer{ 64 };
+    for (;;)
+    {
+        auto       vec  = memory::spare_iovec(buffer);
+        const auto read = readv(fds[0], &vec, 1);
+        REQUIRE(read >= 0);
+        if (!read)
+        {
+            break;
+        }
+        buffer.commit(static_cast<std::size_t>(read));
+    }
+    close(fds[0]);
+
+    REQUIRE(to_string(std::move(buffer).freeze()) == "header:body:trailer");
+}
+#endif
@@ -0,0 +1,100 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <type_traits>
+
+#include "rc_ptr/rc_cache.hpp"
+
+// The entries and the recency lists refer to each other's nodes.
+static_assert(!std::is_copy_constructible_v<memory::rc_cache<int, int>>);
+static_assert(!std::is_copy_assignable_v<memory::rc_cache<int, int>>);
+
+TEST_CASE("rc_cache, hits and misses", "[rc_cache]")
+{
+    memory::rc_cache<int, std::string> cache{ 2 };
+
+    cache.put(1, memory::make_rc<std::string>("one"));
+    REQUIRE(*cache.get(1) == "one");
+    REQUIRE(!cache.get(2));
+    REQUIRE(cache.stats().hits == 1);
+    REQUIRE(cache.stats().misses == 1);
+
+    auto created = cache.get_or_create(
+        2,
+        [] { return memory::make_rc<std::string>("two"); });
+    REQUIRE(*created == "two");
+    REQUIRE(cache.get(2).get() == created.get());
+    REQUIRE(cache.stats().misses == 2);
+    REQUIRE(cache.stats().hits == 2);
+}
+
+TEST_CASE("rc_cache, least recently used entries become weak", "[rc_cache]")
+{
+    memory::rc_cache<int, std::string> cache{ 2, 0 };
+
+    auto kept = memory::make_rc<std::string>("one");
+    cache.put(1, kept);
+    cache.put(2, memory::make_rc<std::string>("two"));
+    cache.put(3, memory::make_rc<std::string>("three"));
+
+    REQUIRE(cache.size() == 3);
+    REQUIRE(cache.strong_size() == 2);
+    REQUIRE(cache.stats().evictions == 1);
+    REQUIRE(kept.use_count() == 1);
+
+    // Still owned elsewhere, brought back to the strong segment.
+    REQUIRE(cache.get(1).get() == kept.get());
+    REQUIRE(cache.stats().resurrections == 1);
+    REQUIRE(kept.use_count() == 2);
+    REQUIRE(cache.strong_size() == 2);
+
+    // 2 was demoted by the resurrection and nobody else owns it.
+    REQUIRE(!cache.get(2));
+    REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE("rc_cache, expired entries are pruned incrementally", "[rc_cache]")
+{
+    memory::rc_cache<int, int> cache{ 1, 1 };
+
+    for (int i = 0; i < 10; ++i)
+    {
+        cache.put(i, memory::make_rc<int>(i));
+    }
+
+    // Each put demotes one entry and prunes at most one.
+    REQUIRE(cache.strong_size() == 1);
+    REQUIRE(cache.stats().evictions == 9);
+    REQUIRE(cache.stats().pruned > 0);
+    REQUIRE(cache.size() < 10);
+
+    cache.prune(cache.size());
+    REQUIRE(cache.size() == 1);
+    REQUIRE(*cache.get(9) == 9);
+}
+
+TEST_CASE("rc_cache, replace and erase", "[rc_cache]")
+{
+    memory::rc_cache<std::string, int> cache{ 1 };
+
+    auto first = memory::make_rc<int>(1);
+    cache.put("key", first);
+    cache.put("other", memory::make_rc<int>(2));
+    cache.put("key", memory::make_rc<int>(3));
+    REQUIRE(*cache.get("key") == 3);
+    REQUIRE(first.unique());
+
+    REQUIRE(cache.erase("key"));
+    REQUIRE(!cache.erase("key"));
+    REQUIRE(!cache.get("key"));
+
+    cache.put("other", nullptr);
+    REQUIRE(cache.size() == 0);
+}
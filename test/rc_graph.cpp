@@ -0,0 +1,175 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "rc_ptr/rc_graph.hpp"
+
+namespace
+{
+struct leaf
+{
+    std::string name;
+};
+
+struct node
+{
+    int                  value;
+    memory::rc_ptr<leaf> tag;
+    memory::rc_ptr<node> left;
+    memory::rc_ptr<node> right;
+};
+} // namespace
+
+namespace memory
+{
+template<>
+struct rc_graph_traits<leaf>
+{
+    static void save(rc_graph_writer& out, const leaf& value)
+    {
+        out.write_size(value.name.size());
+        out.write_bytes(value.name.data(), value.name.size());
+    }
+
+    static leaf load(rc_graph_reader& in)
+    {
+        std::string name(in.read_size(), '\0');
+        in.read_bytes(name.data(), name.size());
+        return leaf{ std::move(name) };
+    }
+};
+
+template<>
+struct rc_graph_traits<node>
+{
+    static void save(rc_graph_writer& out, const node& value)
+    {
+        out.write(value.value);
+        out.write_rc(value.tag);
+        out.write_rc(value.left);
+        out.write_rc(value.right);
+    }
+
+    static node load(rc_graph_reader& in)
+    {
+        node result;
+        result.value = in.read<int>();
+        result.tag   = in.read_rc<leaf>();
+        result.left  = in.read_rc<node>();
+        result.right = in.read_rc<node>();
+        return result;
+    }
+};
+} // namespace memory
+
+TEST_CASE("rc_graph, shared nodes are written once", "[rc_graph]")
+{
+    auto tag    = memory::make_rc<leaf>(leaf{ "shared" });
+    auto bottom = memory::make_rc<node>(node{ 1, tag, nullptr, nullptr });
+    auto middle = memory::make_rc<node>(node{ 2, tag, bottom, bottom });
+    auto root   = memory::make_rc<node>(node{ 3, nullptr, middle, bottom });
+
+    std::stringstream stream;
+    {
+        memory::rc_graph_writer writer{ stream };
+        writer.write_rc(root);
+        writer.write_rc(bottom);
+        REQUIRE(writer.node_count() == 4);
+    }
+
+    memory::rc_ptr<node> loaded_root;
+    memory::rc_ptr<node> loaded_bottom;
+    {
+        memory::rc_graph_reader reader{ stream };
+        loaded_root   = reader.read_rc<node>();
+        loaded_bottom = reader.read_rc<node>();
+        REQUIRE(reader.node_count() == 4);
+    }
+
+    REQUIRE(loaded_root->value == 3);
+    REQUIRE(!loaded_root->tag);
+
+    const auto& loaded_middle = loaded_root->left;
+    REQUIRE(loaded_middle->value == 2);
+    REQUIRE(loaded_middle->left == loaded_bottom);
+    REQUIRE(loaded_middle->right == loaded_bottom);
+    REQUIRE(loaded_root->right == loaded_bottom);
+    REQUIRE(loaded_bottom->tag == loaded_middle->tag);
+    REQUIRE(loaded_bottom->tag->name == "shared");
+
+    // Held by both middle references, root, and loaded_bottom.
+    REQUIRE(loaded_bottom.use_count() == 4);
+    REQUIRE(loaded_root.unique());
+}
+
+TEST_CASE("rc_graph, leaves of an arena", "[rc_graph]")
+{
+    auto list = memory::rc_ptr<node>{};
+    for (int i = 0; i != 100; ++i)
+    {
+        auto tag = memory::make_rc<leaf>(leaf{ std::to_string(i % 10) });
+        list     = memory::make_rc<node>(node{ i, tag, list, nullptr });
+    }
+
+    std::stringstream stream;
+    memory::rc_graph_writer{ stream }.write_rc(list);
+
+    memory::rc_group<leaf> group;
+    memory::rc_ptr<node>   loaded;
+    {
+        memory::rc_graph_reader reader{ stream };
+        reader.use_arena(group);
+        loaded = reader.read_rc<node>();
+    }
+
+    REQUIRE(group.size() == 100);
+    REQUIRE(group.use_count() == 101);
+
+    int expected = 99;
+    for (auto it = loaded.get(); it; it = it->left.get())
+    {
+        REQUIRE(it->value == expected);
+        REQUIRE(it->tag->name == std::to_string(expected % 10));
+        --expected;
+    }
+    REQUIRE(expected == -1);
+
+    loaded.reset();
+    REQUIRE(group.use_count() == 1);
+}
+
+TEST_CASE("rc_graph, truncated stream", "[rc_graph]")
+{
+    auto root = memory::make_rc<node>(node{ 1, nullptr, nullptr, nullptr });
+
+    std::stringstream stream;
+    memory::rc_graph_writer{ stream }.write_rc(root);
+
+    auto bytes = stream.str();
+    bytes.pop_back();
+
+    std::stringstream       truncated{ bytes };
+    memory::rc_graph_reader reader{ truncated };
+    REQUIRE_THROWS_AS(reader.read_rc<node>(), std::ios_base::failure);
+}
+
+TEST_CASE("rc_graph, cycle", "[rc_graph]")
+{
+    auto root  = memory::make_rc<node>(node{ 1, nullptr, nullptr, nullptr });
+    auto child = memory::make_rc<node>(node{ 2, nullptr, root, nullptr });
+    root->right = child;
+
+    std::stringstream       stream;
+    memory::rc_graph_writer writer{ stream };
+    REQUIRE_THROWS_AS(writer.write_rc(root), std::ios_base::failure);
+
+    root->right.reset();
+}
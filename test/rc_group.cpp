@@ -0,0 +1,110 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "rc_ptr/rc_group.hpp"
+
+#include "counted.hpp"
+
+namespace
+{
+struct node : rc_test::counted
+{
+    explicit node(int value, node* parent = nullptr) :
+        counted{ value },
+        parent{ parent }
+    {
+    }
+
+    node* parent;
+};
+} // namespace
+
+TEST_CASE("rc_group, objects share the count of the group", "[rc_group]")
+{
+    memory::rc_ptr<node> leaf;
+    {
+        memory::rc_group<node> group{ 2 };
+        auto                   root  = group.emplace(0);
+        auto                   left  = group.emplace(1, root);
+        auto                   right = group.emplace(2, root);
+        REQUIRE(group.size() == 3);
+        REQUIRE(group.use_count() == 1);
+        REQUIRE(node::alive == 3);
+
+        leaf = group.share(right);
+        REQUIRE(group.use_count() == 2);
+        REQUIRE(leaf.get() == right);
+        REQUIRE(leaf->parent == root);
+        REQUIRE(left->parent == root);
+
+        auto other = group.share(root);
+        REQUIRE(leaf.use_count() == 3);
+    }
+    REQUIRE(node::alive == 3);
+    REQUIRE(leaf.unique());
+    REQUIRE(leaf->parent->value == 0);
+
+    leaf.reset();
+    REQUIRE(node::alive == 0);
+}
+
+TEST_CASE("rc_group, weak_rc_ptr expires with the group", "[rc_group]")
+{
+    memory::weak_rc_ptr<node> weak;
+    {
+        memory::rc_group<node> group;
+        weak = group.share(group.emplace(7));
+        REQUIRE(weak.lock()->value == 7);
+    }
+    REQUIRE(weak.expired());
+    REQUIRE(node::alive == 0);
+}
+
+TEST_CASE("rc_group, move", "[rc_group]")
+{
+    memory::rc_group<node> group;
+    group.emplace(1);
+
+    memory::rc_group<node> other{ std::move(group) };
+    REQUIRE(group.size() == 0);
+    REQUIRE(group.use_count() == 0);
+    REQUIRE(other.size() == 1);
+
+    group = std::move(other);
+    REQUIRE(group.size() == 1);
+    REQUIRE(node::alive == 1);
+}
+
+TEST_CASE("rc_group, construction throws", "[rc_group]")
+{
+    {
+        memory::rc_group<node> group{ 1 };
+        group.emplace(1);
+        REQUIRE_THROWS_AS(group.emplace(-1), std::runtime_error);
+        REQUIRE(group.size() == 1);
+        REQUIRE(group.emplace(2)->value == 2);
+        REQUIRE(node::alive == 2);
+    }
+    REQUIRE(node::alive == 0);
+}
+
+TEST_CASE("rc_group, chunk size overflows", "[rc_group]")
+{
+    constexpr auto max = std::numeric_limits<std::size_t>::max();
+
+    REQUIRE_THROWS_AS(memory::rc_group<node>{ max }, std::bad_array_new_length);
+    REQUIRE_THROWS_AS(memory::rc_group<node>{ max / sizeof(node) + 2 },
+                      std::bad_array_new_length);
+    REQUIRE(node::alive == 0);
+}
@@ -0,0 +1,181 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "rc_ptr/rc_handle.hpp"
+
+#include "counted.hpp"
+
+namespace
+{
+using entry = rc_test::counted;
+
+// Throws from allocate while allocation_fails is set.
+bool allocation_fails = false;
+
+template<typename T>
+struct failing_allocator
+{
+    using value_type = T;
+
+    failing_allocator() noexcept = default;
+
+    template<typename U>
+    failing_allocator(const failing_allocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        if (allocation_fails)
+        {
+            throw std::bad_alloc{};
+        }
+
+        return std::allocator<T>{}.allocate(count);
+    }
+
+    void deallocate(T* ptr, std::size_t count) noexcept
+    {
+        std::allocator<T>{}.deallocate(ptr, count);
+    }
+
+    template<typename U>
+    bool operator==(const failing_allocator<U>&) const noexcept
+    {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const failing_allocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+} // namespace
+
+TEST_CASE("rc_handle, size", "[rc_handle]")
+{
+    REQUIRE(sizeof(memory::rc_handle<entry>) == 8);
+    REQUIRE(!memory::rc_handle<entry>{});
+}
+
+TEST_CASE("rc_handle, resolves while the object is alive", "[rc_handle]")
+{
+    memory::rc_slot_map<entry> slots;
+
+    auto ptr    = slots.emplace(1);
+    auto handle = slots.handle(ptr);
+    REQUIRE(handle);
+    REQUIRE(slots.size() == 1);
+    REQUIRE(slots.contains(handle));
+
+    auto locked = slots.lock(handle);
+    REQUIRE(locked.get() == ptr.get());
+    REQUIRE(ptr.use_count() == 2);
+
+    locked.reset();
+    ptr.reset();
+    REQUIRE(entry::alive == 0);
+    REQUIRE(slots.size() == 0);
+    REQUIRE(!slots.contains(handle));
+    REQUIRE(!slots.lock(handle));
+}
+
+TEST_CASE("rc_handle, reused slot invalidates stale handles", "[rc_handle]")
+{
+    memory::rc_slot_map<entry> slots;
+
+    auto stale = slots.handle(slots.emplace(1));
+    auto ptr   = slots.emplace(2);
+    auto fresh = slots.handle(ptr);
+    REQUIRE(fresh.index() == stale.index());
+    REQUIRE(fresh != stale);
+    REQUIRE(!slots.lock(stale));
+    REQUIRE(slots.lock(fresh)->value == 2);
+    REQUIRE(slots.slot_count() == 1);
+}
+
+TEST_CASE("rc_handle, for_each visits living objects", "[rc_handle]")
+{
+    memory::rc_slot_map<entry> slots;
+
+    std::vector<memory::rc_ptr<entry>> ptrs;
+    for (int i = 0; i < 100; ++i)
+    {
+        ptrs.push_back(slots.emplace(i));
+    }
+
+    ptrs.erase(ptrs.begin(), ptrs.begin() + 50);
+
+    int sum = 0;
+    slots.for_each([&sum](const entry& e) { sum += e.value; });
+    REQUIRE(sum == (50 + 99) * 50 / 2);
+    REQUIRE(slots.size() == 50);
+}
+
+TEST_CASE("rc_handle, for_each while emplacing", "[rc_handle]")
+{
+    memory::rc_slot_map<entry> slots;
+
+    std::vector<memory::rc_ptr<entry>> ptrs;
+    ptrs.push_back(slots.emplace(0));
+
+    int visited = 0;
+    slots.for_each([&](const entry& e) {
+        ++visited;
+        if (e.value < 99)
+        {
+            ptrs.push_back(slots.emplace(e.value + 1));
+        }
+    });
+    REQUIRE(visited == 100);
+    REQUIRE(slots.size() == 100);
+}
+
+TEST_CASE("rc_handle, objects outlive the map", "[rc_handle]")
+{
+    memory::rc_ptr<entry> ptr;
+    {
+        memory::rc_slot_map<entry> slots;
+        ptr = slots.emplace(3);
+    }
+    REQUIRE(ptr->value == 3);
+    ptr.reset();
+    REQUIRE(entry::alive == 0);
+}
+
+TEST_CASE("rc_handle, construction throws", "[rc_handle]")
+{
+    memory::rc_slot_map<entry> slots;
+    REQUIRE_THROWS_AS(slots.emplace(-1), std::runtime_error);
+    REQUIRE(slots.size() == 0);
+
+    auto ptr = slots.emplace(1);
+    REQUIRE(slots.slot_count() == 1);
+    REQUIRE(slots.lock(slots.handle(ptr)).get() == ptr.get());
+}
+
+TEST_CASE("rc_handle, allocation throws", "[rc_handle]")
+{
+    memory::rc_slot_map<entry, failing_allocator<entry>> slots;
+
+    allocation_fails = true;
+    REQUIRE_THROWS_AS(slots.emplace(1), std::bad_alloc);
+    allocation_fails = false;
+    REQUIRE(slots.slot_count() == 0);
+
+    auto ptr = slots.emplace(1);
+    REQUIRE(slots.slot_count() == 1);
+    REQUIRE(slots.handle(ptr).index() == 0);
+}
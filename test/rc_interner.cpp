@@ -0,0 +1,91 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "rc_ptr/rc_interner.hpp"
+
+namespace
+{
+// Puts every value into one bucket.
+struct colliding_hash
+{
+    std::size_t operator()(const std::string&) const noexcept
+    {
+        return 0;
+    }
+};
+} // namespace
+
+TEST_CASE("rc_interner, equal values share the object", "[rc_interner]")
+{
+    memory::rc_interner<std::string> strings;
+
+    auto first  = strings.intern("schema");
+    auto second = strings.intern(std::string{ "schema" });
+    auto other  = strings.intern("table");
+
+    REQUIRE(first.get() == second.get());
+    REQUIRE(first.get() != other.get());
+    REQUIRE(*first == "schema");
+    REQUIRE(first.use_count() == 2);
+    REQUIRE(strings.size() == 2);
+}
+
+TEST_CASE("rc_interner, values are not kept alive", "[rc_interner]")
+{
+    memory::rc_interner<std::string> strings;
+
+    auto value = strings.intern("value");
+    REQUIRE(strings.find("value").get() == value.get());
+
+    memory::weak_rc_ptr<const std::string,
+                        std::default_delete<const std::string>,
+                        std::allocator<std::string>>
+        weak = value;
+    value.reset();
+    REQUIRE(weak.expired());
+    REQUIRE(strings.empty());
+    REQUIRE(!strings.find("value"));
+
+    auto fresh = strings.intern("value");
+    REQUIRE(*fresh == "value");
+    REQUIRE(strings.size() == 1);
+}
+
+TEST_CASE("rc_interner, colliding hashes", "[rc_interner]")
+{
+    memory::rc_interner<std::string, colliding_hash> strings;
+
+    std::vector<memory::rc_interner<std::string, colliding_hash>::rc_type>
+        values;
+    for (int i = 0; i < 10; ++i)
+    {
+        values.push_back(strings.intern(std::to_string(i)));
+    }
+
+    REQUIRE(strings.size() == 10);
+    REQUIRE(strings.intern("3").get() == values[3].get());
+
+    values.erase(values.begin() + 3);
+    REQUIRE(strings.size() == 9);
+    REQUIRE(!strings.find("3"));
+    REQUIRE(strings.find("4").get() == values[3].get());
+}
+
+TEST_CASE("rc_interner, values outlive the table", "[rc_interner]")
+{
+    memory::rc_interner<std::string>::rc_type value;
+    {
+        memory::rc_interner<std::string> strings;
+        value = strings.intern("value");
+    }
+    REQUIRE(*value == "value");
+}
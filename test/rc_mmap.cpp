@@ -0,0 +1,126 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#if __has_include(<sys/mman.h>)
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "rc_ptr/rc_mmap.hpp"
+
+namespace
+{
+struct temp_file
+{
+    explicit temp_file(const std::string& contents) :
+        path{ "rc_mmap_test_" + std::to_string(::getpid()) + "_" +
+              std::to_string(++counter) }
+    {
+        write(contents);
+    }
+
+    ~temp_file()
+    {
+        std::remove(path.c_str());
+    }
+
+    void write(const std::string& contents) const
+    {
+        std::ofstream{ path, std::ios::binary | std::ios::trunc } << contents;
+    }
+
+    static inline int counter = 0;
+
+    std::string path;
+};
+
+std::string to_string(const memory::rc_mmap::region_type& region)
+{
+    return { reinterpret_cast<const char*>(region.get()), region.size() };
+}
+
+// msync fails with ENOMEM for the addresses which are not mapped.
+bool mapped(const void* address)
+{
+    const auto page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto start =
+        reinterpret_cast<std::uintptr_t>(address) & ~(page - 1);
+    return ::msync(reinterpret_cast<void*>(start), page, MS_ASYNC) == 0;
+}
+} // namespace
+
+TEST_CASE("rc_mmap, slices keep the mapping alive", "[rc_mmap]")
+{
+    temp_file file{ "header:body:trailer" };
+
+    auto region = memory::rc_mmap::open(file.path.c_str(),
+                                        memory::mmap_advice::sequential);
+    REQUIRE(to_string(region) == "header:body:trailer");
+    REQUIRE(region.get_deleter().size == 19);
+
+    auto       body    = region.slice(7, 4);
+    const auto address = region.get();
+    REQUIRE(to_string(body) == "body");
+    REQUIRE(region.use_count() == 2);
+
+    region.reset();
+    REQUIRE(mapped(address));
+    REQUIRE(to_string(body) == "body");
+
+    body.reset();
+    REQUIRE(!mapped(address));
+}
+
+TEST_CASE("rc_mmap, advise and errors", "[rc_mmap]")
+{
+    temp_file file{ std::string(1 << 16, 'x') };
+
+    auto region = memory::rc_mmap::open(file.path.c_str());
+    REQUIRE(memory::rc_mmap::advise(region.slice(5000, 100),
+                                    memory::mmap_advice::willneed));
+    REQUIRE(memory::rc_mmap::advise(region, memory::mmap_advice::random));
+    REQUIRE(memory::rc_mmap::advise(memory::rc_mmap::region_type{},
+                                    memory::mmap_advice::willneed));
+
+    temp_file empty{ "" };
+    REQUIRE(!memory::rc_mmap::open(empty.path.c_str()));
+
+    REQUIRE_THROWS_AS(memory::rc_mmap::open("rc_mmap_test_missing"),
+                      std::system_error);
+}
+
+TEST_CASE("rc_mmap_cache, reuses the living mappings", "[rc_mmap]")
+{
+    temp_file             file{ "dictionary" };
+    memory::rc_mmap_cache cache;
+
+    auto first  = cache.open(file.path.c_str());
+    auto second = cache.open(("./" + file.path).c_str());
+    REQUIRE(first.get() == second.get());
+    REQUIRE(first.use_count() == 2);
+    REQUIRE(cache.size() == 1);
+
+    file.write("dictionary, second edition");
+    auto third = cache.open(file.path.c_str());
+    REQUIRE(third.get() != first.get());
+    REQUIRE(to_string(third) == "dictionary, second edition");
+
+    first.reset();
+    second.reset();
+    third.reset();
+    cache.prune();
+    REQUIRE(cache.size() == 0);
+
+    auto fourth = cache.open(file.path.c_str());
+    REQUIRE(to_string(fourth) == "dictionary, second edition");
+    REQUIRE(cache.size() == 1);
+}
+
+#endif
@@ -0,0 +1,108 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include "rc_ptr/rc_observer_list.hpp"
+
+namespace
+{
+struct observer
+{
+    int received = 0;
+};
+} // namespace
+
+TEST_CASE("rc_observer_list, for_each compacts expired subscribers",
+          "[rc_observer_list]")
+{
+    memory::rc_observer_list<observer> list;
+
+    auto first  = memory::make_rc<observer>();
+    auto second = memory::make_rc<observer>();
+    auto third  = memory::make_rc<observer>();
+    list.subscribe(first);
+    list.subscribe(second);
+    list.subscribe(third);
+    REQUIRE(list.size() == 3);
+
+    second.reset();
+
+    int calls = 0;
+    list.for_each([&calls](observer& o) {
+        ++o.received;
+        ++calls;
+    });
+    REQUIRE(calls == 2);
+    REQUIRE(first->received == 1);
+    REQUIRE(third->received == 1);
+    REQUIRE(first.use_count() == 1);
+    REQUIRE(list.size() == 2);
+
+    REQUIRE(list.unsubscribe(first));
+    REQUIRE(!list.unsubscribe(first));
+    list.for_each([](observer& o) { ++o.received; });
+    REQUIRE(first->received == 1);
+    REQUIRE(third->received == 2);
+}
+
+TEST_CASE("rc_observer_list, modification during for_each",
+          "[rc_observer_list]")
+{
+    memory::rc_observer_list<observer> list;
+
+    auto first  = memory::make_rc<observer>();
+    auto second = memory::make_rc<observer>();
+    auto late   = memory::make_rc<observer>();
+    list.subscribe(first);
+    list.subscribe(second);
+
+    int calls = 0;
+    list.for_each([&](observer&) {
+        if (calls++ == 0)
+        {
+            list.unsubscribe(second);
+            list.subscribe(late);
+        }
+    });
+    REQUIRE(calls == 2);
+    REQUIRE(list.size() == 2);
+
+    calls = 0;
+    list.for_each([&calls](observer&) { ++calls; });
+    REQUIRE(calls == 2);
+    REQUIRE(second->received == 0);
+}
+
+TEST_CASE("rc_observer_list, snapshot", "[rc_observer_list]")
+{
+    memory::rc_observer_list<observer> list;
+
+    auto first  = memory::make_rc<observer>();
+    auto second = memory::make_rc<observer>();
+    list.subscribe(first);
+    list.subscribe(second);
+
+    auto snapshot = list.take_snapshot();
+    list.unsubscribe(first);
+    REQUIRE(snapshot.size() == 2);
+    REQUIRE(list.size() == 1);
+
+    int calls = 0;
+    snapshot.for_each([&](observer& o) {
+        ++o.received;
+        ++calls;
+        second.reset();
+    });
+    REQUIRE(calls == 1);
+    REQUIRE(first->received == 1);
+
+    calls = 0;
+    list.for_each([&calls](observer&) { ++calls; });
+    REQUIRE(calls == 0);
+    REQUIRE(list.size() == 0);
+}
@@ -0,0 +1,199 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rc_ptr/rc_persistent_map.hpp"
+
+namespace
+{
+// Maps many keys to equal hashes to exercise the collision nodes.
+struct weak_hash
+{
+    std::size_t operator()(int key) const noexcept
+    {
+        return static_cast<std::size_t>(key % 7);
+    }
+};
+
+template<typename Map>
+bool equal(const Map& map, const std::map<int, int>& expected)
+{
+    if (map.size() != expected.size())
+    {
+        return false;
+    }
+
+    for (const auto& [key, value] : expected)
+    {
+        const auto found = map.find(key);
+        if (!found || *found != value)
+        {
+            return false;
+        }
+    }
+
+    std::size_t visited = 0;
+    map.for_each([&visited](int, int) { ++visited; });
+    return visited == expected.size();
+}
+} // namespace
+
+TEST_CASE("rc_persistent_map, set, erase and versions",
+          "[rc_persistent_map]")
+{
+    memory::rc_persistent_map<int, std::string> empty;
+    auto one = empty.set(1, "one");
+    auto two = one.set(2, "two").set(1, "uno");
+
+    REQUIRE(empty.empty());
+    REQUIRE(*one.find(1) == "one");
+    REQUIRE(!one.contains(2));
+    REQUIRE(*two.find(1) == "uno");
+    REQUIRE(*two.find(2) == "two");
+    REQUIRE(two.size() == 2);
+
+    auto erased = two.erase(1).erase(3);
+    REQUIRE(erased.size() == 1);
+    REQUIRE(!erased.contains(1));
+    REQUIRE(two.contains(1));
+    REQUIRE(erased.erase(2).empty());
+}
+
+TEST_CASE("rc_persistent_map, random operations", "[rc_persistent_map]")
+{
+    std::mt19937 random{ 7 };
+
+    memory::rc_persistent_map<int, int>            map;
+    memory::rc_persistent_map<int, int, weak_hash> colliding;
+    std::map<int, int>                             expected;
+
+    std::vector<std::pair<memory::rc_persistent_map<int, int>,
+                          std::map<int, int>>>
+        versions;
+
+    for (int step = 0; step != 4000; ++step)
+    {
+        const int key = static_cast<int>(random() % 600);
+        if (random() % 3)
+        {
+            map           = map.set(key, step);
+            colliding     = colliding.set(key, step);
+            expected[key] = step;
+        }
+        else
+        {
+            map       = map.erase(key);
+            colliding = colliding.erase(key);
+            expected.erase(key);
+        }
+
+        if (step % 500 == 0)
+        {
+            versions.emplace_back(map, expected);
+        }
+    }
+
+    REQUIRE(equal(map, expected));
+    REQUIRE(equal(colliding, expected));
+    for (const auto& [version, contents] : versions)
+    {
+        REQUIRE(equal(version, contents));
+    }
+}
+
+TEST_CASE("rc_persistent_map, from_sorted", "[rc_persistent_map]")
+{
+    std::vector<std::pair<int, int>> sorted;
+    std::map<int, int>               expected;
+    for (int i = 0; i != 3000; ++i)
+    {
+        sorted.emplace_back(i, i * 2);
+        expected[i] = i * 2;
+    }
+    sorted.emplace_back(2999, 1);
+    expected[2999] = 1;
+
+    auto map = memory::rc_persistent_map<int, int>::from_sorted(sorted.begin(),
+                                                                sorted.end());
+    REQUIRE(equal(map, expected));
+
+    auto colliding =
+        memory::rc_persistent_map<int, int, weak_hash>::from_sorted(
+            sorted.begin(),
+            sorted.end());
+    REQUIRE(equal(colliding, expected));
+
+    map = map.set(5000, 1).erase(17);
+    expected[5000] = 1;
+    expected.erase(17);
+    REQUIRE(equal(map, expected));
+}
+
+TEST_CASE("rc_persistent_map, diff", "[rc_persistent_map]")
+{
+    memory::rc_persistent_map<int, int> older;
+    for (int i = 0; i != 1000; ++i)
+    {
+        older = older.set(i, i);
+    }
+
+    const auto newer = older.set(5, -5).erase(10).set(2000, 1).set(7, 7);
+
+    std::vector<int> added;
+    std::vector<int> removed;
+    std::vector<int> changed;
+    older.diff(
+        newer,
+        [&added](int key, int) { added.push_back(key); },
+        [&removed](int key, int) { removed.push_back(key); },
+        [&changed](int key, int before, int after) {
+            REQUIRE(before == 5);
+            REQUIRE(after == -5);
+            changed.push_back(key);
+        });
+
+    REQUIRE(added == std::vector<int>{ 2000 });
+    REQUIRE(removed == std::vector<int>{ 10 });
+    REQUIRE(changed == std::vector<int>{ 5 });
+
+    int visited = 0;
+    auto count  = [&visited](auto&&...) { ++visited; };
+    older.diff(older, count, count, count);
+    REQUIRE(visited == 0);
+    memory::rc_persistent_map<int, int>{}.diff(newer, count, count, count);
+    REQUIRE(visited == 1000);
+}
+
+TEST_CASE("rc_persistent_map, transient", "[rc_persistent_map]")
+{
+    const memory::rc_persistent_map<int, int> base{ { 1, 1 }, { 2, 2 } };
+
+    auto transient = base.transient();
+    for (int i = 3; i != 500; ++i)
+    {
+        transient.set(i, i);
+    }
+    REQUIRE(transient.erase(1));
+    REQUIRE(!transient.erase(1));
+
+    const auto value = transient.find(300);
+    transient.set(300, -1);
+    REQUIRE(transient.find(300) == value);
+    REQUIRE(*value == -1);
+
+    auto result = std::move(transient).persistent();
+    REQUIRE(result.size() == 498);
+    REQUIRE(*result.find(300) == -1);
+    REQUIRE(base.size() == 2);
+    REQUIRE(*base.find(1) == 1);
+}
@@ -0,0 +1,255 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rc_ptr/rc_persistent_vector.hpp"
+
+namespace
+{
+template<typename T>
+bool equal(const memory::rc_persistent_vector<T>& vector,
+           const std::vector<T>&                  expected)
+{
+    if (vector.size() != expected.size())
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i != expected.size(); ++i)
+    {
+        if (vector[i] != expected[i])
+        {
+            return false;
+        }
+    }
+
+    return std::equal(vector.begin(), vector.end(), expected.begin());
+}
+
+std::vector<int> iota(int first, int last)
+{
+    std::vector<int> values;
+    for (; first != last; ++first)
+    {
+        values.push_back(first);
+    }
+    return values;
+}
+} // namespace
+
+TEST_CASE("rc_persistent_vector, push_back keeps versions",
+          "[rc_persistent_vector]")
+{
+    memory::rc_persistent_vector<int>              vector;
+    std::vector<memory::rc_persistent_vector<int>> versions;
+
+    for (int i = 0; i != 5000; ++i)
+    {
+        versions.push_back(vector);
+        vector = vector.push_back(i);
+    }
+
+    REQUIRE(equal(vector, iota(0, 5000)));
+    REQUIRE(equal(versions[1234], iota(0, 1234)));
+    REQUIRE(versions[0].empty());
+    REQUIRE(vector.front() == 0);
+    REQUIRE(vector.back() == 4999);
+}
+
+TEST_CASE("rc_persistent_vector, set and update", "[rc_persistent_vector]")
+{
+    const auto                              values = iota(0, 2000);
+    const memory::rc_persistent_vector<int> vector{ values.begin(),
+                                                    values.end() };
+
+    auto changed = vector.set(10, -1).update(1999, [](int& v) { v *= 2; });
+
+    auto expected  = values;
+    expected[10]   = -1;
+    expected[1999] = 3998;
+    REQUIRE(equal(changed, expected));
+    REQUIRE(equal(vector, values));
+}
+
+TEST_CASE("rc_persistent_vector, take, drop and slice",
+          "[rc_persistent_vector]")
+{
+    const auto                              values = iota(0, 3000);
+    const memory::rc_persistent_vector<int> vector{ values.begin(),
+                                                    values.end() };
+
+    REQUIRE(equal(vector.take(1000), iota(0, 1000)));
+    REQUIRE(equal(vector.take(2990), iota(0, 2990)));
+    REQUIRE(equal(vector.drop(1000), iota(1000, 3000)));
+    REQUIRE(equal(vector.drop(2990), iota(2990, 3000)));
+    REQUIRE(equal(vector.slice(33, 2077), iota(33, 2077)));
+    REQUIRE(vector.take(0).empty());
+    REQUIRE(vector.drop(3000).empty());
+
+    auto grown = vector.slice(5, 100);
+    for (int i = 100; i != 1200; ++i)
+    {
+        grown = grown.push_back(i);
+    }
+    REQUIRE(equal(grown, iota(5, 1200)));
+    REQUIRE(equal(vector, values));
+}
+
+TEST_CASE("rc_persistent_vector, concat", "[rc_persistent_vector]")
+{
+    const auto                              values = iota(0, 1500);
+    const memory::rc_persistent_vector<int> vector{ values.begin(),
+                                                    values.end() };
+
+    auto joined   = vector.slice(0, 700).concat(vector.slice(3, 1403));
+    auto expected = iota(0, 700);
+    for (int i = 3; i != 1403; ++i)
+    {
+        expected.push_back(i);
+    }
+    REQUIRE(equal(joined, expected));
+
+    joined = joined.concat(memory::rc_persistent_vector<int>{ 1, 2, 3 });
+    expected.insert(expected.end(), { 1, 2, 3 });
+    REQUIRE(equal(joined, expected));
+
+    joined = joined.set(800, -5).push_back(7);
+    expected[800] = -5;
+    expected.push_back(7);
+    REQUIRE(equal(joined, expected));
+    REQUIRE(equal(vector, values));
+}
+
+TEST_CASE("rc_persistent_vector, concat of many small vectors",
+          "[rc_persistent_vector]")
+{
+    memory::rc_persistent_vector<int> prepended;
+    memory::rc_persistent_vector<int> appended;
+    std::vector<int>                  expected_prepended;
+    std::vector<int>                  expected_appended;
+
+    for (int step = 0; step != 500; ++step)
+    {
+        const auto values = iota(step * 100, step * 100 + 33);
+        const memory::rc_persistent_vector<int> small{ values.begin(),
+                                                       values.end() };
+
+        prepended = small.concat(prepended);
+        expected_prepended.insert(expected_prepended.begin(),
+                                  values.begin(),
+                                  values.end());
+
+        const auto count = static_cast<std::size_t>(step % 33 + 1);
+        appended         = appended.concat(small.take(count));
+        expected_appended.insert(expected_appended.end(),
+                                 values.begin(),
+                                 values.begin() + count);
+    }
+
+    REQUIRE(equal(prepended, expected_prepended));
+    REQUIRE(equal(appended, expected_appended));
+
+    // Even with every node half full, 4 levels hold 16^4 values.
+    REQUIRE(prepended.size() < 65536);
+    REQUIRE(prepended.height() <= 4);
+    REQUIRE(appended.height() <= 4);
+}
+
+TEST_CASE("rc_persistent_vector, random operations", "[rc_persistent_vector]")
+{
+    std::mt19937                      random{ 42 };
+    memory::rc_persistent_vector<int> vector;
+    std::vector<int>                  expected;
+
+    for (int step = 0; step != 400; ++step)
+    {
+        const auto size = expected.size();
+        switch (random() % 5)
+        {
+        case 0:
+        {
+            const int count = static_cast<int>(random() % 100);
+            for (int i = 0; i != count; ++i)
+            {
+                vector = vector.push_back(step);
+                expected.push_back(step);
+            }
+            break;
+        }
+        case 1:
+            if (size)
+            {
+                const auto index = random() % size;
+                vector           = vector.set(index, -step);
+                expected[index]  = -step;
+            }
+            break;
+        case 2:
+        {
+            const auto first = size ? random() % size : 0;
+            const auto last  = first + random() % (size - first + 1);
+            vector           = vector.slice(first, last);
+            expected         = { expected.begin() + first,
+                         expected.begin() + last };
+            break;
+        }
+        default:
+        {
+            const auto copy = expected;
+            vector          = vector.concat(vector);
+            expected.insert(expected.end(), copy.begin(), copy.end());
+            if (expected.size() > 20000)
+            {
+                vector = vector.take(5000);
+                expected.resize(5000);
+            }
+            break;
+        }
+        }
+
+        REQUIRE(equal(vector, expected));
+    }
+}
+
+TEST_CASE("rc_persistent_vector, transient", "[rc_persistent_vector]")
+{
+    const auto                              values = iota(0, 1000);
+    const memory::rc_persistent_vector<int> vector{ values.begin(),
+                                                    values.end() };
+
+    auto transient = vector.transient();
+    for (int i = 1000; i != 2000; ++i)
+    {
+        transient.push_back(i);
+    }
+    transient.set(0, -1);
+    transient.update(1500, [](int& v) { v = -2; });
+    const auto first = &transient[0];
+    transient.set(0, -3);
+    REQUIRE(&transient[0] == first);
+
+    auto expected  = iota(0, 2000);
+    expected[0]    = -3;
+    expected[1500] = -2;
+
+    auto result = std::move(transient).persistent();
+    REQUIRE(equal(result, expected));
+    REQUIRE(equal(vector, values));
+
+    memory::rc_transient_vector<std::string> strings;
+    strings.emplace_back(3, 'a');
+    strings.append(memory::rc_persistent_vector<std::string>{ "b", "c" });
+    strings.drop_front(1);
+    strings.truncate(1);
+    REQUIRE(strings.size() == 1);
+    REQUIRE(strings[0] == "b");
+}
@@ -0,0 +1,220 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "rc_ptr/rc_vector.hpp"
+
+#include "counted.hpp"
+
+namespace
+{
+using rc_test::counted;
+
+using counted_ptr = memory::rc_ptr<counted>;
+
+// Stateful allocator which does not propagate, instances with different ids
+// compare unequal.
+template<typename T>
+struct arena_allocator
+{
+    using value_type = T;
+
+    explicit arena_allocator(int id) noexcept : id{ id } { }
+
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept : id{ other.id }
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        return std::allocator<T>{}.allocate(count);
+    }
+
+    void deallocate(T* ptr, std::size_t count) noexcept
+    {
+        std::allocator<T>{}.deallocate(ptr, count);
+    }
+
+    template<typename U>
+    bool operator==(const arena_allocator<U>& other) const noexcept
+    {
+        return id == other.id;
+    }
+
+    template<typename U>
+    bool operator!=(const arena_allocator<U>& other) const noexcept
+    {
+        return id != other.id;
+    }
+
+    int id;
+};
+
+using arena_vector =
+    memory::rc_vector<counted_ptr, arena_allocator<counted_ptr>>;
+} // namespace
+
+TEST_CASE("rc_vector, trivially relocatable trait", "[rc_vector]")
+{
+    REQUIRE(memory::is_trivially_relocatable_v<int>);
+    REQUIRE(memory::is_trivially_relocatable_v<memory::rc_ptr<std::string>>);
+    REQUIRE(memory::is_trivially_relocatable_v<memory::weak_rc_ptr<int>>);
+    REQUIRE(!memory::is_trivially_relocatable_v<std::string>);
+}
+
+TEST_CASE("rc_vector, uninitialized_relocate", "[rc_vector]")
+{
+    std::allocator<std::string> allocator;
+    auto                        src = allocator.allocate(2);
+    auto                        dst = allocator.allocate(2);
+    ::new (src) std::string(32, 'a');
+    ::new (src + 1) std::string(32, 'b');
+
+    REQUIRE(memory::uninitialized_relocate(src, src + 2, dst) == dst + 2);
+    REQUIRE(dst[0] == std::string(32, 'a'));
+    REQUIRE(dst[1] == std::string(32, 'b'));
+
+    std::destroy(dst, dst + 2);
+    allocator.deallocate(src, 2);
+    allocator.deallocate(dst, 2);
+}
+
+TEST_CASE("rc_vector, growth keeps the references", "[rc_vector]")
+{
+    {
+        memory::rc_vector<counted_ptr> ptrs;
+        for (int i = 0; i < 100; ++i)
+        {
+            ptrs.push_back(memory::make_rc<counted>(i));
+        }
+
+        REQUIRE(ptrs.size() == 100);
+        REQUIRE(ptrs.capacity() >= 100);
+        REQUIRE(counted::alive == 100);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(ptrs[i]->value == i);
+            REQUIRE(ptrs[i].unique());
+        }
+
+        ptrs.shrink_to_fit();
+        REQUIRE(ptrs.capacity() == 100);
+        REQUIRE(ptrs.back()->value == 99);
+    }
+    REQUIRE(counted::alive == 0);
+}
+
+TEST_CASE("rc_vector, insert and erase", "[rc_vector]")
+{
+    auto                           shared = memory::make_rc<counted>(7);
+    memory::rc_vector<counted_ptr> ptrs{ shared, shared, shared };
+    REQUIRE(shared.use_count() == 4);
+
+    auto it = ptrs.insert(ptrs.begin() + 1, memory::make_rc<counted>(1));
+    REQUIRE(it == ptrs.begin() + 1);
+    REQUIRE(ptrs.size() == 4);
+    REQUIRE(ptrs[1]->value == 1);
+    REQUIRE(ptrs[2].get() == shared.get());
+
+    ptrs.insert(ptrs.begin(), ptrs.back());
+    REQUIRE(ptrs.front().get() == shared.get());
+    REQUIRE(shared.use_count() == 5);
+
+    it = ptrs.erase(ptrs.begin(), ptrs.begin() + 2);
+    REQUIRE(it == ptrs.begin());
+    REQUIRE(ptrs.size() == 3);
+    REQUIRE(ptrs.front()->value == 1);
+    REQUIRE(shared.use_count() == 3);
+
+    ptrs.erase(ptrs.begin() + 1);
+    ptrs.pop_back();
+    REQUIRE(ptrs.size() == 1);
+    REQUIRE(shared.unique());
+    REQUIRE(counted::alive == 2);
+}
+
+TEST_CASE("rc_vector, copy and move", "[rc_vector]")
+{
+    memory::rc_vector<counted_ptr> ptrs;
+    ptrs.emplace_back(memory::make_rc<counted>(1));
+
+    auto copy = ptrs;
+    REQUIRE(ptrs[0].use_count() == 2);
+
+    auto moved = std::move(copy);
+    REQUIRE(copy.empty());
+    REQUIRE(moved[0].get() == ptrs[0].get());
+
+    ptrs = moved;
+    REQUIRE(ptrs[0].use_count() == 2);
+
+    moved.clear();
+    REQUIRE(ptrs[0].unique());
+}
+
+TEST_CASE("rc_vector, move with unequal allocators", "[rc_vector]")
+{
+    static_assert(!std::is_nothrow_move_assignable_v<arena_vector>);
+    static_assert(
+        std::is_nothrow_move_assignable_v<memory::rc_vector<counted_ptr>>);
+
+    arena_vector first{ arena_allocator<counted_ptr>{ 1 } };
+    first.emplace_back(memory::make_rc<counted>(1));
+    first.emplace_back(memory::make_rc<counted>(2));
+
+    arena_vector second{ arena_allocator<counted_ptr>{ 2 } };
+    second = std::move(first);
+    REQUIRE(first.empty());
+    REQUIRE(second.get_allocator().id == 2);
+    REQUIRE(second.size() == 2);
+    REQUIRE(second[0].unique());
+    REQUIRE(second[1]->value == 2);
+
+    arena_vector third{ arena_allocator<counted_ptr>{ 2 } };
+    const auto   data = second.data();
+    third             = std::move(second);
+    REQUIRE(third.data() == data);
+    REQUIRE(second.empty());
+
+    first = third;
+    REQUIRE(first.get_allocator().id == 1);
+    REQUIRE(first[0].use_count() == 2);
+
+    third.clear();
+    first.clear();
+    REQUIRE(counted::alive == 0);
+}
+
+TEST_CASE("rc_vector, resize", "[rc_vector]")
+{
+    memory::rc_vector<counted_ptr> ptrs;
+    ptrs.resize(3);
+    REQUIRE(ptrs.size() == 3);
+    REQUIRE(!ptrs[2]);
+
+    ptrs[0] = memory::make_rc<counted>(1);
+    ptrs.resize(1);
+    REQUIRE(ptrs.size() == 1);
+    REQUIRE(ptrs[0]->value == 1);
+}
+
+TEST_CASE("rc_vector, construction throws", "[rc_vector]")
+{
+    memory::rc_vector<counted_ptr> ptrs;
+    ptrs.push_back(memory::make_rc<counted>(1));
+
+    REQUIRE_THROWS_AS(ptrs.emplace_back(memory::make_rc<counted>(-1)),
+                      std::runtime_error);
+    REQUIRE(ptrs.size() == 1);
+    REQUIRE(ptrs[0]->value == 1);
+}
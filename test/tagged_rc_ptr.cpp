@@ -0,0 +1,130 @@
+//
+// Copyright Borys Chyliński 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "catch2/catch.hpp"
+
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "rc_ptr/tagged_rc_ptr.hpp"
+
+TEST_CASE("tagged_rc_ptr, size", "[tagged_rc_ptr]")
+{
+    REQUIRE(sizeof(memory::tagged_rc_ptr<int, 3>) ==
+            sizeof(memory::rc_ptr<int>));
+}
+
+TEST_CASE("tagged_rc_ptr, tag does not affect the pointer",
+          "[tagged_rc_ptr]")
+{
+    auto ptr = memory::make_rc<std::string>("node");
+
+    memory::tagged_rc_ptr<std::string, 2> tagged{ ptr, 3 };
+    REQUIRE(tagged.tag() == 3);
+    REQUIRE(tagged.get() == ptr.get());
+    REQUIRE(*tagged == "node");
+    REQUIRE(tagged->size() == 4);
+    REQUIRE(ptr.use_count() == 2);
+
+    tagged.set_tag(1);
+    REQUIRE(tagged.tag() == 1);
+    REQUIRE(tagged.get() == ptr.get());
+    REQUIRE(tagged.use_count() == 2);
+
+    auto shared = tagged.to_rc();
+    REQUIRE(shared.get() == ptr.get());
+    REQUIRE(ptr.use_count() == 3);
+}
+
+TEST_CASE("tagged_rc_ptr, copy and move", "[tagged_rc_ptr]")
+{
+    memory::weak_rc_ptr<int> weak;
+    {
+        memory::tagged_rc_ptr<int, 1> tagged{ memory::make_rc<int>(5), 1 };
+        weak = tagged.to_rc();
+        REQUIRE(tagged.unique());
+
+        auto copy = tagged;
+        REQUIRE(copy.tag() == 1);
+        REQUIRE(tagged.use_count() == 2);
+
+        auto moved = std::move(copy);
+        REQUIRE(!copy);
+        REQUIRE(copy.tag() == 0);
+        REQUIRE(moved.tag() == 1);
+        REQUIRE(*moved == 5);
+
+        tagged = moved;
+        REQUIRE(moved.use_count() == 2);
+    }
+    REQUIRE(weak.expired());
+}
+
+TEST_CASE("tagged_rc_ptr, reset keeps the tag", "[tagged_rc_ptr]")
+{
+    auto ptr = memory::make_rc<int>(1);
+
+    memory::tagged_rc_ptr<int, 3> tagged{ ptr, 6 };
+    tagged.reset();
+    REQUIRE(!tagged);
+    REQUIRE(tagged.tag() == 6);
+    REQUIRE(!tagged.to_rc());
+    REQUIRE(ptr.unique());
+}
+
+TEST_CASE("tagged_rc_ptr, empty", "[tagged_rc_ptr]")
+{
+    memory::tagged_rc_ptr<int, 2> tagged{ nullptr };
+    tagged.set_tag(2);
+    REQUIRE(!tagged);
+    REQUIRE(tagged.use_count() == 0);
+
+    memory::tagged_rc_ptr<int, 2> other{ memory::rc_ptr<int>{}, 1 };
+    swap(tagged, other);
+    REQUIRE(tagged.tag() == 1);
+    REQUIRE(other.tag() == 2);
+}
+
+TEST_CASE("tagged_rc_ptr, comparison ignores the tag", "[tagged_rc_ptr]")
+{
+    auto ptr = memory::make_rc<int>(7);
+
+    memory::tagged_rc_ptr<int, 2> first{ ptr, 1 };
+    memory::tagged_rc_ptr<int, 3> second{ ptr, 6 };
+    REQUIRE(first == second);
+    REQUIRE(!(first != second));
+    REQUIRE(first != memory::tagged_rc_ptr<int, 2>{ memory::make_rc<int>(7) });
+
+    using hash_type = std::hash<memory::tagged_rc_ptr<int, 2>>;
+    memory::tagged_rc_ptr<int, 2> third{ ptr, 2 };
+    REQUIRE(hash_type{}(first) == hash_type{}(third));
+    REQUIRE(hash_type{}(first) == std::hash<memory::rc_ptr<int>>{}(ptr));
+
+    memory::tagged_rc_ptr<int, 2> empty{ nullptr };
+    empty.set_tag(3);
+    REQUIRE(empty == nullptr);
+    REQUIRE(nullptr == empty);
+    REQUIRE(first != nullptr);
+    REQUIRE(nullptr != first);
+    REQUIRE(empty == memory::tagged_rc_ptr<int, 3>{});
+}
+
+TEST_CASE("tagged_rc_ptr, weak_rc_ptr", "[tagged_rc_ptr]")
+{
+    memory::weak_rc_ptr<int> weak;
+    {
+        memory::tagged_rc_ptr<int, 1> tagged{ memory::make_rc<int>(3), 1 };
+        weak = tagged;
+        REQUIRE(tagged.unique());
+        REQUIRE(*weak.lock() == 3);
+    }
+    REQUIRE(weak.expired());
+
+    memory::weak_rc_ptr<int> empty = memory::tagged_rc_ptr<int, 1>{};
+    REQUIRE(empty.expired());
+}